@@ -1,8 +1,12 @@
 #pragma once
 
+#include <boost/lexical_cast.hpp>
+#include <boost/throw_exception.hpp>
+
 #include <fstream>
 #include <iostream>
 
+#include <stdexcept>
 #include <string>
 
 #include <unordered_map>
@@ -43,4 +47,60 @@ inline config_file_t load_config_file(std::string filename) {
   return return_map;  // And return the result
 }
 
+/**
+ * @return the value of a configuration entry. Fails naming the key when it
+ * can't be converted
+ */
+template <typename T>
+T convert(std::string const &key, std::string const &value) {
+  try {
+    return boost::lexical_cast<T>(value);
+  } catch (boost::bad_lexical_cast const &) {
+    BOOST_THROW_EXCEPTION(std::invalid_argument(
+        "Invalid value for the configuration key " + key + ": " + value));
+  }
+}
+
+/**
+ * @return the value of a configuration entry or the default if it's missing
+ */
+template <typename T>
+T get(config_file_t const &configuration, std::string const &key,
+      T const &default_value) {
+  auto const entry = configuration.find(key);
+  if (entry == configuration.end()) {
+    return default_value;
+  }
+  return convert<T>(key, entry->second);
+}
+
+/**
+ * @return the value of a configuration entry, failing if it's missing
+ */
+template <typename T>
+T require(config_file_t const &configuration, std::string const &key) {
+  auto const entry = configuration.find(key);
+  if (entry == configuration.end()) {
+    BOOST_THROW_EXCEPTION(
+        std::invalid_argument("Missing the configuration key " + key));
+  }
+  return convert<T>(key, entry->second);
+}
+
+/**
+ * @return if a "Y" or "N" configuration entry is enabled, or the default if
+ * it's missing
+ */
+inline bool get_flag(config_file_t const &configuration,
+                     std::string const &key, bool default_value) {
+  auto const value =
+      get<std::string>(configuration, key, default_value ? "Y" : "N");
+  if (value != "Y" && value != "N") {
+    BOOST_THROW_EXCEPTION(std::invalid_argument(
+        "Invalid value for the configuration key " + key + ": " + value +
+        ", expected Y or N"));
+  }
+  return value == "Y";
+}
+
 }  // namespace config_file
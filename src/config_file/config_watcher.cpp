@@ -0,0 +1,108 @@
+#include "config_watcher.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace details {
+
+// Time between checks of the watcher being stopped
+int const watch_poll_milliseconds = 200;
+
+// Changes of a folder meaning a file was written or replaced
+uint32_t const watched_events = IN_CLOSE_WRITE | IN_MOVED_TO;
+
+/**
+ * @returns the folder of a file, the current one when it has none
+ */
+string folder_of(string const &filename) {
+  auto const separator = filename.find_last_of('/');
+  if (separator == string::npos) {
+    return ".";
+  }
+  return separator == 0 ? "/" : filename.substr(0, separator);
+}
+
+}  // namespace details
+
+config_watcher::config_watcher(string const &filename, callback_t callback)
+    : m_filename(filename),
+      m_name(filename.substr(filename.find_last_of('/') + 1)),
+      m_callback(std::move(callback)),
+      m_inotify(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)),
+      m_running(true),
+      m_thread() {
+  if (m_inotify < 0) {
+    BOOST_THROW_EXCEPTION(std::runtime_error(
+        "Impossible to watch the configuration: " +
+        string(std::strerror(errno))));
+  }
+  if (inotify_add_watch(m_inotify, details::folder_of(filename).c_str(),
+                        details::watched_events) < 0) {
+    auto const error = errno;
+    close(m_inotify);
+    BOOST_THROW_EXCEPTION(std::runtime_error(
+        "Impossible to watch the configuration " + filename + ": " +
+        std::strerror(error)));
+  }
+
+  m_thread = std::thread(&config_watcher::watch, this);
+}
+
+config_watcher::~config_watcher() {
+  m_running = false;
+  m_thread.join();
+  close(m_inotify);
+}
+
+void config_watcher::watch() {
+  alignas(inotify_event) char buffer[4096];
+  pollfd descriptor{m_inotify, POLLIN, 0};
+
+  while (m_running) {
+    if (poll(&descriptor, 1, details::watch_poll_milliseconds) <= 0) {
+      continue;
+    }
+
+    // Every change read at once, the file loaded a single time for them
+    bool changed = false;
+    ssize_t length;
+    while ((length = read(m_inotify, buffer, sizeof(buffer))) > 0) {
+      for (char *event = buffer; event < buffer + length;) {
+        auto const &notification = *reinterpret_cast<inotify_event *>(event);
+        if (notification.len && m_name == notification.name) {
+          changed = true;
+        }
+        event += sizeof(inotify_event) + notification.len;
+      }
+    }
+
+    if (changed) {
+      reload();
+    }
+  }
+}
+
+void config_watcher::reload() {
+  auto const configuration = config_file::load_config_file(m_filename);
+  if (configuration.empty()) {
+    std::cerr << "Configuration " << m_filename << " not reloaded"
+              << std::endl;
+    return;
+  }
+
+  try {
+    m_callback(configuration);
+    std::cout << "Configuration " << m_filename << " reloaded" << std::endl;
+  } catch (std::exception const &exception) {
+    std::cerr << "Configuration " << m_filename
+              << " not reloaded: " << exception.what() << std::endl;
+  }
+}
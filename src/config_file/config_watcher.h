@@ -0,0 +1,51 @@
+#pragma once
+
+#include "../config.h"
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+/**
+ * Watches a configuration file with inotify, loading it again every time it's
+ * written or replaced.
+ *
+ * The folder is watched instead of the file, so editors saving into a new
+ * file and renaming it are noticed too. The callback runs in the watcher's
+ * thread, and configurations that can't be loaded or that the callback
+ * rejects throwing are reported and ignored
+ */
+class config_watcher {
+ public:
+  using callback_t = std::function<void(config_file_t const &)>;
+
+  /** Constructor. Starts watching the file */
+  config_watcher(string const &filename, callback_t callback);
+
+  /** Destructor. Stops watching */
+  ~config_watcher();
+
+  config_watcher(config_watcher const &) = delete;
+  config_watcher &operator=(config_watcher const &) = delete;
+
+ private:
+  // Waits for changes of the file until stopped
+  void watch();
+
+  // Loads the file again and hands it to the callback
+  void reload();
+
+  // File watched, and its name inside the folder
+  string m_filename;
+  string m_name;
+
+  // Called with every configuration loaded
+  callback_t m_callback;
+
+  // Inotify instance watching the folder
+  int m_inotify;
+
+  // Thread waiting for the changes
+  std::atomic<bool> m_running;
+  std::thread m_thread;
+};
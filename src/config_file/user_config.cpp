@@ -0,0 +1,40 @@
+#include "user_config.h"
+
+namespace config_file {
+
+user_config_t load_user_config(config_file_t const &configuration) {
+  user_config_t config;
+  config.access_key = require<string>(configuration, "AccessKey");
+  config.fix_configuration_file =
+      require<string>(configuration, "FIXConfigurationFile");
+  config.aux_folder = get<string>(configuration, "AuxFolder", "");
+
+  auto const log_to_replay = configuration.find("LogToReplay");
+  if (log_to_replay != configuration.end()) {
+    config.log_to_replay = log_to_replay->second;
+  }
+  config.validate_replay = get_flag(configuration, "ValidateReplay", false);
+
+  config.trusted_session = get_flag(configuration, "TrustedSession", false);
+  config.busy_poll_initiator =
+      get_flag(configuration, "BusyPollInitiator", false);
+  config.mapped_store = get_flag(configuration, "MappedStore", false);
+  config.async_log = get_flag(configuration, "AsyncLog", false);
+  config.outbound_scheduler =
+      get_flag(configuration, "OutboundScheduler", false);
+
+  config.validation_sample_rate =
+      get<size_t>(configuration, "ValidationSampleRate", 0);
+  return config;
+}
+
+string &access_secret(config_file_t &configuration) {
+  auto const entry = configuration.find("AccessSecret");
+  if (entry == configuration.end()) {
+    BOOST_THROW_EXCEPTION(
+        std::invalid_argument("Missing the configuration key AccessSecret"));
+  }
+  return entry->second;
+}
+
+}  // namespace config_file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "../config.h"
+
+/**
+ * Entries of the user configuration used by the sessions, resolved and
+ * validated once when loading instead of looked up by name while running.
+ *
+ * The optional components, like the mapped store or the asynchronous log,
+ * resolve their own entries into their settings
+ */
+struct user_config_t {
+  // Deribit key, the secret is taken by the credentials of the session
+  string access_key;
+
+  // Quickfix settings of the sessions
+  string fix_configuration_file;
+
+  // Folder of the files kept between runs
+  string aux_folder;
+
+  // Log replayed instead of connecting, and if its messages are validated
+  optional<string> log_to_replay;
+  bool validate_replay = false;
+
+  // Components of the session
+  bool trusted_session = false;
+  bool busy_poll_initiator = false;
+  bool mapped_store = false;
+  bool async_log = false;
+  bool outbound_scheduler = false;
+
+  // Application messages between full validations of a trusted session, 0 to
+  // never validate
+  size_t validation_sample_rate = 0;
+};
+
+namespace config_file {
+
+/**
+ * @returns the entries of the user configuration, failing with the key when
+ * one is missing or invalid
+ */
+user_config_t load_user_config(config_file_t const &configuration);
+
+/**
+ * @returns the Deribit secret of the user configuration, failing when it's
+ * missing. It's the entry itself, for the session to wipe it once copied
+ */
+string &access_secret(config_file_t &configuration);
+
+}  // namespace config_file
@@ -5,6 +5,8 @@
 #include <boost/optional/optional_io.hpp>
 #include <boost/serialization/strong_typedef.hpp>
 
+#include "fixed_string.h"
+
 #include <string>
 #include <vector>
 
@@ -25,6 +27,10 @@ BOOST_STRONG_TYPEDEF(double, price_t)
 BOOST_STRONG_TYPEDEF(double, volume_t)
 BOOST_STRONG_TYPEDEF(string, currency)
 
+// Inline storage for instrument symbols and order identifiers
+using symbol_t = fixed_string<31>;
+using order_id_t = fixed_string<63>;
+
 struct BBO_t {
   optional<volume_t> bid_volume;
   optional<price_t> bid;
@@ -3,64 +3,143 @@
 #include "basic_types.h"
 #include "to_string.h"
 
+/**
+ * Execution report of an order.
+ *
+ * Every field may be missing, so instead of an optional each a bit in
+ * `present` tells which ones came in the message. What is checked for every
+ * report goes first and the rarely used fields at the end, out of the cache
+ * lines read on the common path
+ */
 struct execution_report_t {
-  optional<string> order_id;
-  optional<string> original_order_id;
-  optional<order_status_t> order_status;
-  optional<side_t> side;
-  optional<ptime> transaction_time;
-  optional<volume_t> open_volume;
-  optional<volume_t> executed_volume;
-  optional<volume_t> order_volume;
-  optional<order_type_t> order_type;
-  optional<int> reject_reason;
-  optional<string> symbol;
+  // Fields that may be missing in the report
+  enum field_t : uint32_t {
+    ORDER_ID = 1 << 0,
+    ORIGINAL_ORDER_ID = 1 << 1,
+    ORDER_STATUS = 1 << 2,
+    SIDE = 1 << 3,
+    TRANSACTION_TIME = 1 << 4,
+    OPEN_VOLUME = 1 << 5,
+    EXECUTED_VOLUME = 1 << 6,
+    ORDER_VOLUME = 1 << 7,
+    ORDER_TYPE = 1 << 8,
+    REJECT_REASON = 1 << 9,
+    SYMBOL = 1 << 10,
+    ORDER_PRICE = 1 << 11,
+    VOLUME_TYPE = 1 << 12,
+    CONTRACT_MULTIPLIER = 1 << 13,
+    AVERAGE_EXECUTION_PRICE = 1 << 14,
+    MAXIMUN_SHOW_VOLUME = 1 << 15,
+    IMPLIED_VOLATILITY = 1 << 16,
+    PEGGED_PRICE = 1 << 17,
+    MASS_STATUS_REQUEST_TYPE = 1 << 18,
+    MASS_STATUS_REPORT_NUMBER = 1 << 19,
+    LAST_EXECUTION_PRICE = 1 << 20
+  };
 
-  optional<price_t> order_price;
-  optional<volume_type_t> volume_type;
-  optional<double> contract_multiplier;
-  optional<price_t> average_execution_price;
-  optional<volume_t> maximun_show_volume;
-  optional<double> implied_volatility;
-  optional<price_t> pegged_price;
+  // Hot: needed to match the report with the order and update the position
+  uint32_t present = 0;
+  order_status_t order_status = order_status_t::NEW;
+  side_t side = side_t::BUY;
+  volume_t open_volume = volume_t(0);
+  volume_t executed_volume = volume_t(0);
+  price_t order_price = price_t(0);
+  price_t average_execution_price = price_t(0);
+  price_t last_execution_price = price_t(0);
+  symbol_t symbol;
+  order_id_t order_id;
+  order_id_t original_order_id;
 
-  optional<int> mass_status_request_type;
-  optional<int> mass_status_report_number;
+  // Cold
+  ptime transaction_time;
+  volume_t order_volume = volume_t(0);
+  order_type_t order_type = order_type_t::LIMIT;
+  int reject_reason = 0;
+  volume_type_t volume_type = volume_type_t::CONTRACTS;
+  double contract_multiplier = 0;
+  volume_t maximun_show_volume = volume_t(0);
+  double implied_volatility = 0;
+  price_t pegged_price = price_t(0);
+  int mass_status_request_type = 0;
+  int mass_status_report_number = 0;
+
+  /** @returns true if the field came in the report */
+  bool has(field_t field) const { return (present & field) != 0; }
+
+  /** @returns true if all the fields came in the report */
+  bool has_all(uint32_t fields) const { return (present & fields) == fields; }
+
+  /** Marks a field as present */
+  void set(field_t field) { present |= field; }
+
+  /** @returns the value of a field or none if it's not present */
+  template <typename T>
+  optional<T> get(field_t field, T const &value) const {
+    return has(field) ? optional<T>(value) : optional<T>(boost::none);
+  }
 
   friend std::ostream &operator<<(std::ostream &os,
                                   execution_report_t const &report) {
     auto const &separation_string = "|";
-    os << "Execution report [" << to_string(report.order_id) << " - "
-       << to_string(report.original_order_id)
-       << "]: " << to_string(report.symbol) << separation_string;
+    os << "Execution report ["
+       << to_string(report.get(ORDER_ID, report.order_id)) << " - "
+       << to_string(report.get(ORIGINAL_ORDER_ID, report.original_order_id))
+       << "]: " << to_string(report.get(SYMBOL, report.symbol))
+       << separation_string;
 
-    os << "Status: " << to_string(report.order_status) << separation_string;
-    os << "Side: " << to_string(report.side) << separation_string;
-    os << "Transation time: " << to_string(report.transaction_time)
+    os << "Status: " << to_string(report.get(ORDER_STATUS, report.order_status))
+       << separation_string;
+    os << "Side: " << to_string(report.get(SIDE, report.side))
        << separation_string;
-    os << "Open volume: " << to_string(report.open_volume) << separation_string;
-    os << "Executed volume: " << to_string(report.executed_volume)
+    os << "Transation time: "
+       << to_string(report.get(TRANSACTION_TIME, report.transaction_time))
        << separation_string;
-    os << "Order volume: " << to_string(report.order_volume)
+    os << "Open volume: "
+       << to_string(report.get(OPEN_VOLUME, report.open_volume))
        << separation_string;
-    os << "Order type: " << to_string(report.order_type) << separation_string;
-    if (report.order_type == order_type_t::LIMIT) {
-      os << "Order price: " << to_string(report.order_price)
+    os << "Executed volume: "
+       << to_string(report.get(EXECUTED_VOLUME, report.executed_volume))
+       << separation_string;
+    os << "Order volume: "
+       << to_string(report.get(ORDER_VOLUME, report.order_volume))
+       << separation_string;
+    os << "Order type: "
+       << to_string(report.get(ORDER_TYPE, report.order_type))
+       << separation_string;
+    if (report.has(ORDER_TYPE) && report.order_type == order_type_t::LIMIT) {
+      os << "Order price: "
+         << to_string(report.get(ORDER_PRICE, report.order_price))
          << separation_string;
     }
-    os << "Volume type: " << to_string(report.volume_type) << separation_string;
-    os << "Contract multiplier: " << to_string(report.contract_multiplier)
+    os << "Volume type: "
+       << to_string(report.get(VOLUME_TYPE, report.volume_type))
        << separation_string;
-    os << "Execution price: " << to_string(report.average_execution_price)
+    os << "Contract multiplier: "
+       << to_string(
+              report.get(CONTRACT_MULTIPLIER, report.contract_multiplier))
        << separation_string;
-    os << "Max show volume: " << to_string(report.maximun_show_volume)
+    os << "Execution price: "
+       << to_string(report.get(AVERAGE_EXECUTION_PRICE,
+                               report.average_execution_price))
        << separation_string;
-    os << "Implied volatility: " << to_string(report.implied_volatility)
+    os << "Last execution price: "
+       << to_string(
+              report.get(LAST_EXECUTION_PRICE, report.last_execution_price))
        << separation_string;
-    os << "Pegged price: " << to_string(report.pegged_price)
+    os << "Max show volume: "
+       << to_string(
+              report.get(MAXIMUN_SHOW_VOLUME, report.maximun_show_volume))
+       << separation_string;
+    os << "Implied volatility: "
+       << to_string(report.get(IMPLIED_VOLATILITY, report.implied_volatility))
+       << separation_string;
+    os << "Pegged price: "
+       << to_string(report.get(PEGGED_PRICE, report.pegged_price))
        << separation_string;
     os << "Mass status reports comming: "
-       << to_string(report.mass_status_report_number) << separation_string;
+       << to_string(report.get(MASS_STATUS_REPORT_NUMBER,
+                               report.mass_status_report_number))
+       << separation_string;
 
     return os;
   }
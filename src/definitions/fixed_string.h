@@ -0,0 +1,104 @@
+#pragma once
+
+#include <boost/functional/hash.hpp>
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+/**
+ * String stored inline with a fixed capacity, for symbols and identifiers
+ * that are copied and compared on every message. It never allocates and
+ * fits together with its length in N + 1 bytes
+ */
+template <size_t N>
+class fixed_string {
+  static_assert(N < 256, "fixed_string length is stored in one byte");
+
+ public:
+  /** Constructors */
+  fixed_string() : m_size(0), m_data() {}
+  fixed_string(std::string const &value) : fixed_string() {
+    assign(value.data(), value.size());
+  }
+  fixed_string(char const *value) : fixed_string() {
+    assign(value, std::strlen(value));
+  }
+
+  /** Replaces the content. Throws if it doesn't fit */
+  void assign(char const *value, size_t size) {
+    if (size > N) {
+      BOOST_THROW_EXCEPTION(std::length_error(
+          "fixed_string: '" + std::string(value, size) + "' is longer than " +
+          std::to_string(N) + " characters"));
+    }
+    std::memcpy(m_data, value, size);
+    m_size = static_cast<uint8_t>(size);
+  }
+
+  /** Accessors */
+  char const *data() const { return m_data; }
+  size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+  static constexpr size_t capacity() { return N; }
+
+  /** @returns a copy in a std::string */
+  std::string str() const { return std::string(m_data, m_size); }
+
+  /** Comparisons */
+  bool operator==(fixed_string const &other) const {
+    return m_size == other.m_size &&
+           std::memcmp(m_data, other.m_data, m_size) == 0;
+  }
+  bool operator!=(fixed_string const &other) const {
+    return !(*this == other);
+  }
+  bool operator<(fixed_string const &other) const {
+    auto const compared =
+        std::memcmp(m_data, other.m_data, std::min(m_size, other.m_size));
+    return compared < 0 || (compared == 0 && m_size < other.m_size);
+  }
+  bool operator==(std::string const &other) const {
+    return m_size == other.size() &&
+           std::memcmp(m_data, other.data(), m_size) == 0;
+  }
+  bool operator!=(std::string const &other) const {
+    return !(*this == other);
+  }
+  bool operator==(char const *other) const {
+    return std::strlen(other) == m_size &&
+           std::memcmp(m_data, other, m_size) == 0;
+  }
+  bool operator!=(char const *other) const { return !(*this == other); }
+
+  friend bool operator==(std::string const &a, fixed_string const &b) {
+    return b == a;
+  }
+  friend bool operator!=(std::string const &a, fixed_string const &b) {
+    return b != a;
+  }
+
+  friend std::ostream &operator<<(std::ostream &os,
+                                  fixed_string const &value) {
+    return os.write(value.m_data, value.m_size);
+  }
+
+ private:
+  uint8_t m_size;
+  char m_data[N];
+};
+
+namespace std {
+
+template <size_t N>
+struct hash<fixed_string<N>> {
+  size_t operator()(fixed_string<N> const &value) const {
+    return boost::hash_range(value.data(), value.data() + value.size());
+  }
+};
+
+}  // namespace std
@@ -1,31 +1,75 @@
 #pragma once
 
+#include "../memory/arena.h"
 #include "basic_types.h"
+#include "to_string.h"
 
+/**
+ * Contract specification of an instrument.
+ *
+ * The fields the strategy reads on every update come first and the optional
+ * ones are stored as plain values with a presence bit each, so the hot part
+ * takes 64 bytes. Market data is not part of the specification, it's
+ * kept apart by the instrument registry
+ */
 struct instrument_t {
-  string symbol;
-  string description;
-  string type;
+  // Fields that may be missing in the security list
+  enum field_t : uint8_t {
+    CONTRACT_MULTIPLIER = 1 << 0,
+    PUT_CALL = 1 << 1,
+    STRIKE_PRICE = 1 << 2,
+    STRIKE_CURRENCY = 1 << 3,
+    MATURITY_DATE = 1 << 4,
+    MIN_TRADE_VOLUME = 1 << 5,
+    TICK_SIZE = 1 << 6
+  };
+
+  // Hot: used when pricing and sending orders
+  symbol_t symbol;
+  uint8_t present = 0;
+  option_type_t put_call = option_type_t::PUT;
+  double contract_multiplier = 0;
+  price_t strike_price = price_t(0);
+  ptime maturity_date;
+
+  // Cold: only used when selecting instruments and printing
+  volume_t min_trade_volume = volume_t(0);
+  double tick_size = 0;
+  fixed_string<15> type;
   currency main_currency;
-  optional<double> contract_multiplier;
-  optional<option_type_t> put_call;
-  optional<price_t> strike_price;
-  optional<currency> strike_currency;
-  optional<ptime> maturity_date;
-  optional<volume_t> min_trade_volume;
-  optional<double> tick_size;
-  optional<BBO_t> bbo;
+  currency strike_currency;
+  arena_string description;
+
+  /** Constructors. Decoded instruments keep their strings in an arena */
+  instrument_t() = default;
+  explicit instrument_t(arena_allocator<char> const &allocator)
+      : description(allocator) {}
+
+  /** @returns true if the field came in the security list */
+  bool has(field_t field) const { return (present & field) != 0; }
+
+  /** Marks a field as present */
+  void set(field_t field) { present |= field; }
+
+  /** @returns the value of a field or none if it's not present */
+  template <typename T>
+  optional<T> get(field_t field, T const &value) const {
+    return has(field) ? optional<T>(value) : optional<T>(boost::none);
+  }
 
   friend std::ostream &operator<<(std::ostream &os, instrument_t const &instr) {
     os << "[" << to_string(instr.main_currency) << "] " << instr.symbol << " "
        << instr.description << " " << instr.type << " "
-       << instr.contract_multiplier << " " << to_string(instr.min_trade_volume)
-       << " " << to_string(instr.put_call) << " "
-       << to_string(instr.strike_price) << " ["
-       << to_string(instr.strike_currency) << "] "
-       << to_string(instr.maturity_date);
+       << to_string(instr.get(CONTRACT_MULTIPLIER, instr.contract_multiplier))
+       << " "
+       << to_string(instr.get(MIN_TRADE_VOLUME, instr.min_trade_volume))
+       << " " << to_string(instr.get(PUT_CALL, instr.put_call)) << " "
+       << to_string(instr.get(STRIKE_PRICE, instr.strike_price)) << " ["
+       << to_string(instr.get(STRIKE_CURRENCY, instr.strike_currency))
+       << "] " << to_string(instr.get(MATURITY_DATE, instr.maturity_date));
     return os;
   }
 };
 
-using instruments_list_t = vector<instrument_t>;
+// Decoded from a security list, only valid during the user's callback
+using instruments_list_t = arena_vector<instrument_t>;
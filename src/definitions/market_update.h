@@ -3,6 +3,8 @@
 #include "basic_types.h"
 #include "to_string.h"
 
+#include <algorithm>
+
 // Enumerations required
 enum class market_side_t { BID = 0, ASK = 1 };
 enum class market_update_action_t { NEW = 0, CHANGE = 1, DELETE = 2 };
@@ -47,14 +49,93 @@ struct market_update_level_t {
   price_t level_price;
 };
 
+/**
+ * Levels of a market update. The usual depths are stored inline and deeper
+ * updates spill into an overflow buffer that keeps its capacity when cleared,
+ * so an update reused between messages stops allocating once warmed up.
+ * Levels are always contiguous
+ */
+class market_update_levels_t {
+ public:
+  // Levels stored without touching the heap
+  static size_t const inline_capacity = 20;
+
+  /** Constructor */
+  market_update_levels_t() : m_size(0), m_inline(), m_overflow() {}
+
+  /** Changes the number of levels. New ones are left unset */
+  void resize(size_t size) {
+    if (size > inline_capacity) {
+      // Moving what was inline before growing
+      if (m_size <= inline_capacity) {
+        m_overflow.assign(m_inline, m_inline + m_size);
+      }
+      m_overflow.resize(size);
+    } else if (m_size > inline_capacity) {
+      std::copy(m_overflow.begin(), m_overflow.begin() + size, m_inline);
+      m_overflow.clear();
+    }
+    m_size = size;
+  }
+
+  /** Appends a level */
+  void push_back(market_update_level_t const &level) {
+    resize(m_size + 1);
+    back() = level;
+  }
+
+  /** Removes every level keeping the memory */
+  void clear() {
+    m_size = 0;
+    m_overflow.clear();
+  }
+
+  /** Accessors */
+  size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+  market_update_level_t *data() {
+    return m_size > inline_capacity ? m_overflow.data() : m_inline;
+  }
+  market_update_level_t const *data() const {
+    return m_size > inline_capacity ? m_overflow.data() : m_inline;
+  }
+  market_update_level_t &operator[](size_t index) { return data()[index]; }
+  market_update_level_t const &operator[](size_t index) const {
+    return data()[index];
+  }
+  market_update_level_t &back() { return data()[m_size - 1]; }
+  market_update_level_t *begin() { return data(); }
+  market_update_level_t *end() { return data() + m_size; }
+  market_update_level_t const *begin() const { return data(); }
+  market_update_level_t const *end() const { return data() + m_size; }
+
+ private:
+  size_t m_size;
+  market_update_level_t m_inline[inline_capacity];
+  vector<market_update_level_t> m_overflow;
+};
+
 struct market_update_t {
-  string symbol;
+  symbol_t symbol;
 
   optional<double> contract_multiplier;
-  optional<string> underlying_symbol;
+  optional<symbol_t> underlying_symbol;
   optional<price_t> underlying_mid_price;
 
-  vector<market_update_level_t> updates;
+  market_update_levels_t updates;
+
+  // Snapshot replacing the whole book, otherwise an incremental on top of it
+  bool snapshot = false;
+
+  /** Leaves the update empty to decode the next message into it */
+  void clear() {
+    symbol = symbol_t();
+    contract_multiplier = boost::none;
+    underlying_symbol = boost::none;
+    underlying_mid_price = boost::none;
+    updates.clear();
+    snapshot = false;
+  }
 
   friend std::ostream &operator<<(std::ostream &os,
                                   market_update_t const &update) {
@@ -68,3 +149,20 @@ struct market_update_t {
     return os;
   }
 };
+
+/**
+ * @returns the best bid and offer carried by an update of the top of the book
+ */
+inline BBO_t get_bbo(market_update_t const &update) {
+  BBO_t bbo;
+  for (auto const &level : update.updates) {
+    if (level.side == market_side_t::BID) {
+      bbo.bid_volume = level.level_volume;
+      bbo.bid = level.level_price;
+    } else {
+      bbo.ask_volume = level.level_volume;
+      bbo.ask = level.level_price;
+    }
+  }
+  return bbo;
+}
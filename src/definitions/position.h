@@ -1,10 +1,11 @@
 #pragma once
 
 #include <ostream>
+#include "../memory/arena.h"
 #include "basic_types.h"
 
 struct position_t {
-  string symbol;
+  symbol_t symbol;
   volume_t quantity;
   side_t side;
   price_t settlement_price;
@@ -18,4 +19,5 @@ struct position_t {
   }
 };
 
-using positions_list_t = vector<position_t>;
+// Decoded from a position report, only valid during the user's callback
+using positions_list_t = arena_vector<position_t>;
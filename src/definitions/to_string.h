@@ -69,6 +69,17 @@ inline string to_string(currency const& object) {
   return object.t;
 }
 
+// fixed strings
+template <>
+inline string to_string(symbol_t const& object) {
+  return object.str();
+}
+
+template <>
+inline string to_string(order_id_t const& object) {
+  return object.str();
+}
+
 // ptime
 template <>
 inline string to_string(ptime const& object) {
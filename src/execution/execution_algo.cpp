@@ -0,0 +1,299 @@
+#include "execution_algo.h"
+
+#include "peg_algo.h"
+#include "sweep_algo.h"
+#include "twap_algo.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace details {
+
+/**
+ * @returns the algorithm with the given name in the configuration
+ */
+execution_algo::algorithm_t algorithm_of_name(string const &name) {
+  if (name == "limit") {
+    return execution_algo::algorithm_t::LIMIT;
+  }
+  if (name == "join") {
+    return execution_algo::algorithm_t::JOIN;
+  }
+  if (name == "peg") {
+    return execution_algo::algorithm_t::PEG;
+  }
+  if (name == "sweep") {
+    return execution_algo::algorithm_t::SWEEP;
+  }
+  if (name == "twap") {
+    return execution_algo::algorithm_t::TWAP;
+  }
+  BOOST_THROW_EXCEPTION(std::invalid_argument(
+      "Invalid value for the configuration key HedgeAlgorithm: " + name +
+      ", expected limit, join, peg, sweep or twap"));
+}
+
+}  // namespace details
+
+execution_algo::settings_t execution_algo::load_settings(
+    config_file_t const &configuration) {
+  settings_t settings;
+  settings.algorithm = details::algorithm_of_name(
+      config_file::get<string>(configuration, "HedgeAlgorithm", "limit"));
+  settings.peg_offset_ticks = config_file::get(
+      configuration, "HedgePegOffsetTicks", settings.peg_offset_ticks);
+  settings.sweep_ticks =
+      config_file::get(configuration, "HedgeSweepTicks", settings.sweep_ticks);
+  settings.twap_slices =
+      config_file::get(configuration, "HedgeTwapSlices", settings.twap_slices);
+  settings.twap_slice_interval = seconds(config_file::get(
+      configuration, "HedgeTwapSliceSeconds",
+      settings.twap_slice_interval.total_seconds()));
+
+  if (settings.twap_slices < 1 ||
+      settings.twap_slice_interval.total_seconds() < 1) {
+    BOOST_THROW_EXCEPTION(std::invalid_argument(
+        "HedgeTwapSlices and HedgeTwapSliceSeconds must be at least 1"));
+  }
+  return settings;
+}
+
+std::unique_ptr<execution_algo> execution_algo::create(
+    settings_t const &settings, parent_t const &parent,
+    instrument_registry const &instruments, order_sender &sender,
+    ptime const &now) {
+  switch (settings.algorithm) {
+    case algorithm_t::JOIN:
+      return std::make_unique<peg_algo>(parent, instruments, sender, 0);
+    case algorithm_t::PEG:
+      return std::make_unique<peg_algo>(parent, instruments, sender,
+                                        settings.peg_offset_ticks);
+    case algorithm_t::SWEEP:
+      return std::make_unique<sweep_algo>(parent, instruments, sender,
+                                          settings.sweep_ticks);
+    case algorithm_t::TWAP:
+      return std::make_unique<twap_algo>(parent, instruments, sender,
+                                         settings.twap_slices,
+                                         settings.twap_slice_interval, now);
+    case algorithm_t::LIMIT:
+      break;
+  }
+  BOOST_THROW_EXCEPTION(
+      std::logic_error("create: No algorithm for a single limit order"));
+}
+
+execution_algo::execution_algo(parent_t const &parent,
+                               instrument_registry const &instruments,
+                               order_sender &sender)
+    : m_instruments(instruments),
+      m_sender(sender),
+      m_parent(parent),
+      m_filled(0),
+      m_child(),
+      m_stopped(false) {}
+
+bool execution_algo::on_report(execution_report_t &report) {
+  if (!m_child) {
+    return false;
+  }
+
+  // Reports of a cancel have an identifier of their own, the child's is the
+  // original one
+  auto &orders = m_child->orders;
+  auto const find = [&orders](bool present, order_id_t const &id) {
+    return present ? std::find_if(orders.begin(), orders.end(),
+                                  [&id](order_t const &candidate) {
+                                    return candidate.id == id;
+                                  })
+                   : orders.end();
+  };
+  auto const order =
+      find(report.has(execution_report_t::ORDER_ID), report.order_id);
+  auto const original = find(report.has(execution_report_t::ORIGINAL_ORDER_ID),
+                             report.original_order_id);
+  if (order == orders.end() && original == orders.end()) {
+    return false;
+  }
+
+  // Executed volume is cumulative along the replaces of the child
+  if (report.has(execution_report_t::EXECUTED_VOLUME)) {
+    auto const filled = report.executed_volume - m_child->filled;
+    m_child->filled = report.executed_volume;
+    report.executed_volume = filled;
+    m_filled += filled;
+  }
+
+  switch (report.order_status) {
+    case order_status_t::FILLED:
+      m_child = boost::none;
+      break;
+    case order_status_t::CANCELED:
+    case order_status_t::REJECTED: {
+      // An order replaced is canceled, or a replace is rejected: the child
+      // goes on with the others
+      auto const canceled = report.order_status == order_status_t::CANCELED;
+      if (order != orders.end() && orders.size() > 1 &&
+          (canceled ? order + 1 != orders.end() : order != orders.begin())) {
+        orders.erase(order);
+        break;
+      }
+
+      // The child itself, or the order a cancel named
+      m_child = boost::none;
+      break;
+    }
+    case order_status_t::NEW:
+    case order_status_t::PARTIAL:
+      // The order reported is live, the ones before it were replaced
+      if (order != orders.end()) {
+        orders.erase(orders.begin(), order);
+      }
+      break;
+  }
+  return true;
+}
+
+bool execution_algo::on_reject(order_cancel_reject_t const &reject) {
+  if (!m_child) {
+    return false;
+  }
+
+  // The order live is never a replace rejected
+  auto &orders = m_child->orders;
+  auto const order = std::find_if(
+      orders.begin() + 1, orders.end(),
+      [&reject](order_t const &candidate) {
+        return candidate.id == reject.order_id;
+      });
+  if (order == orders.end()) {
+    return false;
+  }
+
+  // Replaces coalesced into the one rejected are gone with it
+  auto const original = std::find_if(
+      orders.begin(), order, [&reject](order_t const &candidate) {
+        return candidate.id == reject.original_order_id;
+      });
+  orders.erase(original == order ? order : original + 1, order + 1);
+  return true;
+}
+
+void execution_algo::cancel() {
+  stop();
+  if (m_child) {
+    m_sender.cancel_order(m_child->orders.back().id);
+  }
+}
+
+bool execution_algo::done() const {
+  return m_filled >= m_parent.volume || (m_stopped && !m_child);
+}
+
+void execution_algo::work(price_t price, volume_t volume,
+                          time_in_force_t time_in_force) {
+  if (m_stopped || static_cast<double>(volume) <= 0) {
+    return;
+  }
+
+  if (!m_child) {
+    auto const id = m_sender.send_order(m_parent.id, m_parent.side, price,
+                                        volume, time_in_force);
+    if (id) {
+      m_child = child_t{{{*id, price, volume, volume}},
+                        volume_t(0),
+                        time_in_force};
+    }
+    return;
+  }
+
+  // Immediate or cancel orders are never moved, they are gone soon
+  auto const &last = m_child->orders.back();
+  if (m_child->time_in_force == time_in_force_t::IOC ||
+      (last.price == price && last.volume == volume)) {
+    return;
+  }
+
+  // The volume of a replace counts what the child filled already
+  auto const quantity = static_cast<volume_t>(m_child->filled + volume);
+  auto const id = m_sender.replace_order(last.id, m_parent.id, m_parent.side,
+                                         price, quantity);
+  if (id) {
+    m_child->orders.push_back({*id, price, volume, quantity});
+  }
+}
+
+optional<price_t> execution_algo::passive_price(int ticks) const {
+  // The best price without the child order is unknown, following the one
+  // with it would move the child ahead of itself at every update
+  if (alone_at_touch()) {
+    return m_child->orders.back().price;
+  }
+
+  auto const &bbo = m_instruments.bbo(m_parent.id);
+  auto const tick = m_instruments.get(m_parent.id).tick_size;
+
+  // Never crossing the book, at most a tick from the other side
+  if (m_parent.side == side_t::BUY) {
+    if (!bbo.bid) {
+      return boost::none;
+    }
+    auto price = static_cast<price_t>(*bbo.bid + ticks * tick);
+    if (bbo.ask && price >= *bbo.ask) {
+      price = std::max(*bbo.bid, static_cast<price_t>(*bbo.ask - tick));
+    }
+    return within_limit(price);
+  }
+
+  if (!bbo.ask) {
+    return boost::none;
+  }
+  auto price = static_cast<price_t>(*bbo.ask - ticks * tick);
+  if (bbo.bid && price <= *bbo.bid) {
+    price = std::min(*bbo.ask, static_cast<price_t>(*bbo.bid + tick));
+  }
+  return within_limit(price);
+}
+
+optional<price_t> execution_algo::aggressive_price(int ticks) const {
+  auto const &bbo = m_instruments.bbo(m_parent.id);
+  auto const tick = m_instruments.get(m_parent.id).tick_size;
+
+  if (m_parent.side == side_t::BUY) {
+    if (!bbo.ask) {
+      return boost::none;
+    }
+    return within_limit(static_cast<price_t>(*bbo.ask + ticks * tick));
+  }
+
+  if (!bbo.bid) {
+    return boost::none;
+  }
+  return within_limit(static_cast<price_t>(*bbo.bid - ticks * tick));
+}
+
+volume_t execution_algo::round_lot(double volume) const {
+  auto const multiplier = m_instruments.get(m_parent.id).contract_multiplier;
+  auto const lot = multiplier > 0 ? multiplier : 1.0;
+  return static_cast<volume_t>(std::floor(volume / lot) * lot);
+}
+
+price_t execution_algo::within_limit(price_t price) const {
+  if (!m_parent.limit) {
+    return price;
+  }
+  return m_parent.side == side_t::BUY ? std::min(price, *m_parent.limit)
+                                      : std::max(price, *m_parent.limit);
+}
+
+bool execution_algo::alone_at_touch() const {
+  if (!m_child) {
+    return false;
+  }
+
+  auto const &bbo = m_instruments.bbo(m_parent.id);
+  auto const &touch = m_parent.side == side_t::BUY ? bbo.bid : bbo.ask;
+  auto const &volume =
+      m_parent.side == side_t::BUY ? bbo.bid_volume : bbo.ask_volume;
+  return touch && *touch == m_child->orders.back().price &&
+         (!volume || *volume <= working_volume());
+}
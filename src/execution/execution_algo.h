@@ -0,0 +1,172 @@
+#pragma once
+
+#include "../config.h"
+#include "../instruments/instrument_registry.h"
+#include "order_sender.h"
+
+#include <memory>
+
+/**
+ * Works a parent order of a strategy in the market through child orders,
+ * reacting to the book updates of the instrument and to the reports of the
+ * children.
+ *
+ * An algorithm keeps at most one child order working. Moving it is a
+ * replace, so the outbound scheduler can coalesce the ones superseded. The
+ * parent may have a limit price, the child orders never go beyond it
+ */
+class execution_algo {
+ public:
+  // Algorithms available. LIMIT is a single order sent by the strategy, with
+  // no algorithm
+  enum class algorithm_t { LIMIT, JOIN, PEG, SWEEP, TWAP };
+
+  // Algorithm to use and how it behaves
+  struct settings_t {
+    algorithm_t algorithm = algorithm_t::LIMIT;
+
+    // Ticks ahead of the best price of the own side a pegged order goes, never
+    // crossing the book
+    int peg_offset_ticks = 0;
+
+    // Ticks through the other side of the book an immediate or cancel order
+    // sweeps
+    int sweep_ticks = 0;
+
+    // Slices of a time sliced parent and seconds between them
+    int twap_slices = 4;
+    time_duration twap_slice_interval = seconds(30);
+  };
+
+  // Order the strategy hands to the algorithm
+  struct parent_t {
+    instrument_id_t id;
+    side_t side;
+    volume_t volume;
+    optional<price_t> limit;
+  };
+
+  /** @returns the settings read from the configuration */
+  static settings_t load_settings(config_file_t const &configuration);
+
+  /** @returns the algorithm of the settings working a parent order */
+  static std::unique_ptr<execution_algo> create(
+      settings_t const &settings, parent_t const &parent,
+      instrument_registry const &instruments, order_sender &sender,
+      ptime const &now);
+
+  /** Constructor */
+  execution_algo(parent_t const &parent,
+                 instrument_registry const &instruments, order_sender &sender);
+
+  /** Destructor */
+  virtual ~execution_algo() = default;
+
+  /** Places, moves or leaves the child order after a book update */
+  virtual void on_book(ptime const &now) = 0;
+
+  /**
+   * Applies a report if it's for the child order. Its executed volume becomes
+   * the volume filled since the last report, as the positions expect it
+   * @returns true if the report was for the child order
+   */
+  bool on_report(execution_report_t &report);
+
+  /**
+   * Applies the reject of a replace of the child order, matched by its
+   * ClOrdID: the order it replaced is still the one wanted. The outbound
+   * scheduler sets the OrigClOrdID to the order live when coalescing, the
+   * replaces sent after that one were never sent to the exchange
+   * @returns true if the reject was for the child order
+   */
+  bool on_reject(order_cancel_reject_t const &reject);
+
+  /** Cancels the child order, the rest of the parent is left */
+  void cancel();
+
+  /** @returns true once the parent is filled or the algorithm stopped */
+  bool done() const;
+
+  /** Parent order */
+  parent_t const &parent() const { return m_parent; }
+  volume_t filled() const { return m_filled; }
+
+  /** @returns the volume of the child order not filled yet, 0 without one */
+  volume_t working_volume() const {
+    return m_child ? static_cast<volume_t>(m_child->orders.back().quantity -
+                                           m_child->filled)
+                   : volume_t(0);
+  }
+
+  /** @returns the volume the child order filled along its replaces */
+  volume_t child_filled() const {
+    return m_child ? m_child->filled : volume_t(0);
+  }
+
+ protected:
+  // Keeps a child order at a price and volume, sending or replacing it
+  void work(price_t price, volume_t volume, time_in_force_t time_in_force);
+
+  // Stops sending child orders, the working one is left
+  void stop() { m_stopped = true; }
+
+  // @returns the best price of a side, moved the ticks given towards the
+  // other side and within the parent's limit. None without market. The child
+  // order alone at the best price stays there, it's not a price to follow
+  optional<price_t> passive_price(int ticks) const;
+  optional<price_t> aggressive_price(int ticks) const;
+
+  // @returns volume rounded down to the lot of the instrument
+  volume_t round_lot(double volume) const;
+
+  // @returns true while a child order is in the market
+  bool working() const { return m_child.is_initialized(); }
+
+  // Volume of the parent not filled yet
+  volume_t remaining() const {
+    return static_cast<volume_t>(m_parent.volume - m_filled);
+  }
+
+  // Instruments and their market
+  instrument_registry const &m_instruments;
+
+ private:
+  // Order of the child in the exchange, or sent to replace it
+  struct order_t {
+    string id;
+    price_t price;
+    volume_t volume;
+
+    // Volume of the order in the market, what it filled included
+    volume_t quantity;
+  };
+
+  // Child order in the market
+  struct child_t {
+    // Order last reported live first, then the replaces sent since. The last
+    // one is the price and volume wanted, reports can come with any of them
+    vector<order_t> orders;
+    volume_t filled;
+    time_in_force_t time_in_force;
+  };
+
+  // @returns the price within the parent's limit
+  price_t within_limit(price_t price) const;
+
+  // @returns true when the best price of the own side is the child order
+  // alone, the volume there being its own
+  bool alone_at_touch() const;
+
+  // Sends the child orders
+  order_sender &m_sender;
+
+  // Order of the strategy and how much was filled
+  parent_t m_parent;
+  volume_t m_filled;
+
+  // Child order working, none between children
+  optional<child_t> m_child;
+
+  // No more child orders are sent
+  bool m_stopped;
+};
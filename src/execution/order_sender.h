@@ -0,0 +1,31 @@
+#pragma once
+
+#include "../config.h"
+#include "../instruments/instrument_registry.h"
+
+// How long an order stays in the book
+enum class time_in_force_t { GTC, IOC };
+
+/**
+ * Sends the child orders of the execution algorithms, checking them first
+ */
+class order_sender {
+ public:
+  virtual ~order_sender() = default;
+
+  /** @returns the identifier of the order sent, none if it was rejected */
+  virtual optional<string> send_order(instrument_id_t id, side_t side,
+                                      price_t price, volume_t volume,
+                                      time_in_force_t time_in_force) = 0;
+
+  /**
+   * @returns the identifier of the order replacing the given one, none if
+   * the replace was rejected
+   */
+  virtual optional<string> replace_order(string const &order_id,
+                                         instrument_id_t id, side_t side,
+                                         price_t price, volume_t volume) = 0;
+
+  /** Cancels an order */
+  virtual void cancel_order(string const &order_id) = 0;
+};
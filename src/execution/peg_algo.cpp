@@ -0,0 +1,15 @@
+#include "peg_algo.h"
+
+peg_algo::peg_algo(parent_t const &parent,
+                   instrument_registry const &instruments,
+                   order_sender &sender, int offset_ticks)
+    : execution_algo(parent, instruments, sender),
+      m_offset_ticks(offset_ticks) {}
+
+void peg_algo::on_book(ptime const & /*now*/) {
+  auto const price = passive_price(m_offset_ticks);
+  if (!price) {
+    return;
+  }
+  work(*price, remaining(), time_in_force_t::GTC);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "execution_algo.h"
+
+/**
+ * Keeps the child order at the best price of its side, or some ticks ahead
+ * of it without crossing the book, following the price as it moves. Joining
+ * the best price is a peg with no offset
+ */
+class peg_algo : public execution_algo {
+ public:
+  /** Constructor */
+  peg_algo(parent_t const &parent, instrument_registry const &instruments,
+           order_sender &sender, int offset_ticks);
+
+  /** Implementing execution_algo interface */
+  void on_book(ptime const &now) override;
+
+ private:
+  // Ticks ahead of the best price
+  int m_offset_ticks;
+};
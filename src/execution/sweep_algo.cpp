@@ -0,0 +1,19 @@
+#include "sweep_algo.h"
+
+sweep_algo::sweep_algo(parent_t const &parent,
+                       instrument_registry const &instruments,
+                       order_sender &sender, int ticks)
+    : execution_algo(parent, instruments, sender), m_ticks(ticks) {}
+
+void sweep_algo::on_book(ptime const & /*now*/) {
+  auto const price = aggressive_price(m_ticks);
+  if (!price) {
+    return;
+  }
+
+  // A single order, the parent is done with its report
+  work(*price, remaining(), time_in_force_t::IOC);
+  if (working()) {
+    stop();
+  }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "execution_algo.h"
+
+/**
+ * Takes the parent at once with an immediate or cancel order through the
+ * other side of the book. Only the best prices are known, so instead of a
+ * number of levels the order goes a number of ticks beyond the best one.
+ * What isn't filled is left to the strategy
+ */
+class sweep_algo : public execution_algo {
+ public:
+  /** Constructor */
+  sweep_algo(parent_t const &parent, instrument_registry const &instruments,
+             order_sender &sender, int ticks);
+
+  /** Implementing execution_algo interface */
+  void on_book(ptime const &now) override;
+
+ private:
+  // Ticks beyond the best price of the other side
+  int m_ticks;
+};
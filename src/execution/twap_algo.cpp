@@ -0,0 +1,32 @@
+#include "twap_algo.h"
+
+#include <algorithm>
+
+twap_algo::twap_algo(parent_t const &parent,
+                     instrument_registry const &instruments,
+                     order_sender &sender, int slices,
+                     time_duration slice_interval, ptime const &now)
+    : execution_algo(parent, instruments, sender),
+      m_slices(slices),
+      m_slice_interval(slice_interval),
+      m_start(now) {}
+
+void twap_algo::on_book(ptime const &now) {
+  // Volume to have filled by the end of the current slice, in whole lots but
+  // the last one
+  auto const slice = std::min<long>(
+      m_slices, (now - m_start).total_seconds() /
+                        m_slice_interval.total_seconds() +
+                    1);
+  auto const target =
+      slice == m_slices
+          ? parent().volume
+          : round_lot(static_cast<double>(parent().volume) * slice / m_slices);
+
+  auto const price = passive_price(0);
+  if (!price || target <= filled()) {
+    return;
+  }
+  work(*price, static_cast<volume_t>(target - filled()),
+       time_in_force_t::GTC);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "execution_algo.h"
+
+/**
+ * Slices the parent in equal parts over time. Every slice adds its part to
+ * the child order, which joins the best price of its side, so what a slice
+ * doesn't fill is carried to the next one. After the last slice the child
+ * keeps working the rest
+ */
+class twap_algo : public execution_algo {
+ public:
+  /** Constructor. The first slice starts now */
+  twap_algo(parent_t const &parent, instrument_registry const &instruments,
+            order_sender &sender, int slices, time_duration slice_interval,
+            ptime const &now);
+
+  /** Implementing execution_algo interface */
+  void on_book(ptime const &now) override;
+
+ private:
+  // Slices, time between them and when the first one started
+  int m_slices;
+  time_duration m_slice_interval;
+  ptime m_start;
+};
@@ -1,46 +1,56 @@
 #include "gamma_scalper.h"
 #include "../pricing/black_scholes.h"
 
-#include <boost/bind.hpp>
-
+#include <chrono>
 #include <cmath>
 #include <fstream>
+#include <limits>
 #include <regex>
 
 namespace details {
 
 string const levels_file = "levels";
-string const pnl_file = "pnl";
-string const pnl_log_file = "pnl_log";
+
+// Full pricing thresholds when missing in the configuration
+double const default_reprice_move = 0.001;
+long const default_reprice_interval = 60;
+
+// Strikes on each side of the straddle's one quoted for the smile
+size_t const default_surface_strikes = 5;
 
 /**
  * @return mid price if bid and ask are present, bid or ask if one is
  * missing or none if no bbo is present*/
-optional<price_t> get_price(optional<BBO_t> const &bbo) {
-  // Empty bbo
-  if (!bbo) {
-    return optional<price_t>(boost::none);
-  }
+optional<price_t> get_price(BBO_t const &bbo) {
   // Missing any of the two
-  if (!bbo->ask || !bbo->bid) {
+  if (!bbo.ask || !bbo.bid) {
     return optional<price_t>(boost::none);
   }
 
   // Both are present, getting mid
   // TODO: ponderating with the volume
-  return static_cast<price_t>(static_cast<double>(*bbo->ask + *bbo->bid) * 0.5);
+  return static_cast<price_t>(static_cast<double>(*bbo.ask + *bbo.bid) * 0.5);
 }
 
-optional<price_t> get_call_price(optional<BBO_t> const &call_bbo,
-                                 optional<BBO_t> const &put_bbo,
+optional<price_t> get_call_price(BBO_t const &call_bbo, BBO_t const &put_bbo,
                                  optional<price_t> const &underlying_price,
                                  double time_to_expiration, double strike,
-                                 double interest_rate) {
+                                 double interest_rate,
+                                 optional<double> const &volatility) {
   // We have market, return the mid point
   auto const call_price = get_price(call_bbo);
   if (call_price) {
     return call_price;
   }
+  // Pricing from the volatility surface if it knows the strike
+  if (volatility) {
+    auto const S = *underlying_price;
+    return optional<price_t>(
+        generalized_black_scholes_merton(option_type_t::CALL, S, strike,
+                                         interest_rate, time_to_expiration,
+                                         interest_rate, *volatility) /
+        S);  // Converting back to CCY
+  }
   // If we don't have the other side of the market either, price is empty
   auto const put_price = get_price(put_bbo);
   if (!put_price) {
@@ -55,16 +65,25 @@ optional<price_t> get_call_price(optional<BBO_t> const &call_bbo,
   return optional<price_t>((P + S - K) / S);  // Converting back to CCY
 }
 
-optional<price_t> get_put_price(optional<BBO_t> const &call_bbo,
-                                optional<BBO_t> const &put_bbo,
+optional<price_t> get_put_price(BBO_t const &call_bbo, BBO_t const &put_bbo,
                                 optional<price_t> const &underlying_price,
                                 double time_to_expiration, double strike,
-                                double interest_rate) {
+                                double interest_rate,
+                                optional<double> const &volatility) {
   // We have market, return the mid point
   auto const put_price = get_price(put_bbo);
   if (put_price) {
     return put_price;
   }
+  // Pricing from the volatility surface if it knows the strike
+  if (volatility) {
+    auto const S = *underlying_price;
+    return optional<price_t>(
+        generalized_black_scholes_merton(option_type_t::PUT, S, strike,
+                                         interest_rate, time_to_expiration,
+                                         interest_rate, *volatility) /
+        S);  // Converting back to CCY
+  }
   // If we don't have the other side of the market either, price is empty
   auto const call_price = get_price(call_bbo);
   if (!call_price) {
@@ -80,65 +99,134 @@ optional<price_t> get_put_price(optional<BBO_t> const &call_bbo,
 }
 
 /**
- * @return the delta for the given option based on the black-scholes formula*/
-optional<double> get_delta(option_type_t call_or_put, double stock_price,
-                           double strike_price, double risk_free_interest,
-                           double time_to_expiration, double cost_of_carry,
-                           double raw_option_price) {
+ * @return the implied volatility for the given option based on the
+ * black-scholes formula*/
+optional<double> get_implied_volatility(option_type_t call_or_put,
+                                        double stock_price,
+                                        double strike_price,
+                                        double risk_free_interest,
+                                        double time_to_expiration,
+                                        double cost_of_carry,
+                                        double raw_option_price) {
   // convert raw price into USD price
   double option_price = raw_option_price * stock_price;
-  // Calculate implied volatility
-  auto implied_volatility = black_scholes_implied_volatility(
+  return black_scholes_implied_volatility(
       call_or_put, stock_price, strike_price, time_to_expiration,
       risk_free_interest, cost_of_carry, option_price);
+}
 
-  // If not possible to get the implied volatility, delta will be empty
-  if (!implied_volatility) {
-    return optional<double>(boost::none);
-  }
+/**
+ * @return the delta of a position for a report, or Empty if it has none*/
+string get_delta_string(optional<greeks_t> const &greeks) {
+  return greeks ? to_string(greeks->delta) : "Empty";
+}
 
-  return black_scholes_delta(call_or_put, stock_price, strike_price,
-                             risk_free_interest, time_to_expiration,
-                             cost_of_carry, *implied_volatility);
+/**
+ * @return the quantity of a position with its sign*/
+double get_signed_quantity(position_t const &position) {
+  return position.side == side_t::BUY ? position.quantity
+                                      : -position.quantity;
 }
 
 /**
- * Updates filled volume in an order from an order and an execution report
+ * Updates filled and open volumes in an order from an order and an execution
+ * report
  */
 void update_filled_volume(order_t &order, execution_report_t &report) {
-  auto const filled = *report.executed_volume - order.full_volume;
-  order.full_volume = *report.executed_volume;
-  *report.executed_volume = filled;
+  auto const filled = report.executed_volume - order.full_volume;
+  order.full_volume = report.executed_volume;
+  if (report.has(execution_report_t::OPEN_VOLUME)) {
+    order.open_volume = report.open_volume;
+  }
+  report.executed_volume = filled;
 }
 
 }  // namespace details
 
-gamma_scalper::gamma_scalper(config_file_t &configuration)
+gamma_scalper::gamma_scalper(config_file_t &configuration,
+                             string const &configuration_file)
+    : gamma_scalper(configuration, configuration_file, nullptr) {}
+
+gamma_scalper::gamma_scalper(config_file_t &configuration,
+                             string const &configuration_file,
+                             strategy_host &host)
+    : gamma_scalper(configuration, configuration_file, &host) {}
+
+gamma_scalper::gamma_scalper(config_file_t &configuration,
+                             string const &configuration_file,
+                             strategy_host *host)
     : m_config_file(configuration),
       m_mutex(),
       m_condition_variable(),
       m_is_running(),
-      m_market(std::make_unique<FIX::quickfix>(configuration, *this)),
+      m_host(host),
+      m_queue(host ? &host->attach(*this,
+                                   threads::load_thread_settings(
+                                       configuration, "Strategy"))
+                   : nullptr),
+      m_attachment{m_host, m_queue},
+      m_market(std::make_unique<FIX::quickfix>(
+          configuration,
+          m_queue ? static_cast<FIX::quickfix_user &>(*m_queue) : *this)),
+      m_market_data(
+          m_queue ? static_cast<FIX::market_data_source &>(*m_queue)
+                  : static_cast<FIX::market_data_source &>(*m_market)),
       m_positions(),
-      m_straddle_call(),
-      m_straddle_put(),
-      m_future(),
-      m_levels(configuration["AuxFolder"],
-               boost::lexical_cast<double>(configuration["PriceSweetener"])),
-      m_snapshots(),
-      m_delta_future(0),
-      m_delta_call(0),
-      m_delta_put(0),
+      m_own_instruments(
+          host ? nullptr
+               : std::make_unique<instrument_registry>(
+                     config_file::get<string>(configuration, "AuxFolder",
+                                              ""))),
+      m_instruments(host ? host->instruments() : *m_own_instruments),
+      m_chain(m_instruments),
+      m_instruments_selected(false),
+      m_surface(m_chain),
+      m_surface_strikes(config_file::get(configuration, "SurfaceStrikes",
+                                         details::default_surface_strikes)),
+      m_straddle_call_id(no_instrument_id),
+      m_straddle_put_id(no_instrument_id),
+      m_future_id(no_instrument_id),
+      m_levels(config_file::get<string>(configuration, "AuxFolder", "")),
+      m_greeks(),
+      m_risk(m_instruments, risk_gate::load_settings(configuration)),
+      m_ledger(m_instruments,
+               config_file::get<string>(configuration, "AuxFolder", ""),
+               pnl_ledger::load_settings(configuration)),
+      m_priced_time(),
+      m_priced_underlying(0),
+      m_straddle_quoted(true),
       m_order(),
+      m_execution_settings(execution_algo::load_settings(configuration)),
+      m_execution(),
       m_mass_reports_incoming(0),
-      m_interest_rate() {
-  m_interest_rate = boost::lexical_cast<double>(configuration["InterestRate"]);
+      m_parameters(
+          std::make_shared<parameters_t const>(load_parameters(configuration))),
+      m_snapshot(),
+      m_latency{0, 0, 0, 0},
+      m_monitor(),
+      m_watcher() {
+  auto const monitor_settings = monitor_endpoint::load_settings(configuration);
+  if (!monitor_settings.path.empty()) {
+    m_monitor = std::make_unique<monitor_endpoint>(
+        monitor_settings, [this]() { return to_json(m_snapshot.load()); });
+  }
+
+  // Changing the parameters doesn't need starting again from scratch
+  if (config_file::get_flag(configuration, "ReloadParameters", false)) {
+    m_watcher = std::make_unique<config_watcher>(
+        configuration_file, [this](config_file_t const &reloaded) {
+          reload_parameters(reloaded);
+        });
+  }
 }
 
 gamma_scalper::~gamma_scalper() {
   if (m_market) {
     m_market->stop();
   }
+
+  // Once the own session is stopped nothing else is queued
+  m_attachment.detach();
 }
 
 bool gamma_scalper::run() {
@@ -158,6 +246,47 @@ bool gamma_scalper::run() {
   return true;
 }
 
+gamma_scalper::parameters_t gamma_scalper::load_parameters(
+    config_file_t const &configuration) {
+  parameters_t parameters;
+  parameters.price_sweetener =
+      config_file::require<double>(configuration, "PriceSweetener");
+  parameters.interest_rate =
+      config_file::require<double>(configuration, "InterestRate");
+  parameters.reprice_move = config_file::get(
+      configuration, "RepriceMoveThreshold", details::default_reprice_move);
+  parameters.reprice_interval = seconds(
+      config_file::get(configuration, "RepriceIntervalSeconds",
+                       details::default_reprice_interval));
+
+  if (!std::isfinite(parameters.price_sweetener) ||
+      parameters.price_sweetener < 0) {
+    BOOST_THROW_EXCEPTION(
+        std::invalid_argument("PriceSweetener can't be negative"));
+  }
+  if (!std::isfinite(parameters.interest_rate)) {
+    BOOST_THROW_EXCEPTION(
+        std::invalid_argument("InterestRate must be a number"));
+  }
+  if (!std::isfinite(parameters.reprice_move) || parameters.reprice_move < 0) {
+    BOOST_THROW_EXCEPTION(std::invalid_argument(
+        "RepriceMoveThreshold can't be negative"));
+  }
+  if (parameters.reprice_interval.is_negative()) {
+    BOOST_THROW_EXCEPTION(std::invalid_argument(
+        "RepriceIntervalSeconds can't be negative"));
+  }
+  return parameters;
+}
+
+void gamma_scalper::reload_parameters(config_file_t const &configuration) {
+  auto parameters =
+      std::make_shared<parameters_t const>(load_parameters(configuration));
+
+  // Evaluations running keep the version they started with
+  std::atomic_store(&m_parameters, std::move(parameters));
+}
+
 void gamma_scalper::on_logon() {
   // Susbscribe for positions feed
   m_market->request_positions();
@@ -179,9 +308,7 @@ void gamma_scalper::on_mass_status_report(int const report_number) {
   // No need to wait for execution reports. Open market
   m_mass_reports_incoming = report_number;
   if (report_number == 0) {
-    m_market->request_market_data(m_future->symbol);
-    m_market->request_market_data(m_straddle_call->symbol);
-    m_market->request_market_data(m_straddle_put->symbol);
+    request_market_data();
   }
 }
 
@@ -194,71 +321,25 @@ void gamma_scalper::on_message(
     return;
   }
 
-  // Filling position's instruments
-  for (auto &position : m_positions) {
-    auto it =
-        std::find_if(instruments->begin(), instruments->end(),
-                     boost::bind(&instrument_t::symbol, _1) == position.first);
-    if (it == instruments->end()) {
-      report_error(
-          "There's no instrument information for instrument's position" +
-          position.first + ". Exiting before something goes wrong");
-    }
-
-    position.second.instrument = *it;
-
-    // Calculating what is the straddle and what is the future to use
-    if (position.second.instrument.type == "OPT") {
-      if (position.second.instrument.put_call.get() == option_type_t::CALL) {
-        m_straddle_call = position.second.instrument;
-      } else {
-        m_straddle_put = position.second.instrument;
-      }
-    } else {
-      m_future = position.second.instrument;
-    }
+  // The host already applied it to the registry it shares
+  if (!m_host) {
+    auto const diff = m_instruments.update(*instruments);
+    m_instruments.store_snapshot();
+    std::cout << "Instruments: " << diff.added << " added, " << diff.updated
+              << " updated, " << diff.removed << " removed" << std::endl;
   }
 
-  // Checking that we have the straddle and that it's a valid one
-  if (!m_straddle_call || !m_straddle_put) {
-    report_error(
-        "After getting the instrument list, impossible to determine the "
-        "straddle. This should never happen!");
+  // Already started from the snapshot. Only refresh what we trade
+  if (m_instruments_selected) {
+    refresh_instruments();
+    return;
   }
-  if ((m_straddle_call->main_currency != m_straddle_put->main_currency) ||
-      (m_straddle_call->maturity_date != m_straddle_put->maturity_date) ||
-      (m_straddle_call->strike_price != m_straddle_put->strike_price)) {
-    report_error("The straddle is not correct. " + m_straddle_call->symbol +
-                 " and " + m_straddle_put->symbol +
-                 " are not allowed to be together");
-  }
-
-  // If we don't have the future, search for one that fits, else the
-  // perpetual
-  if (!m_future) {
-    auto const future_symbol = m_straddle_call->symbol.substr(0, 11);
-    auto fitting_future =
-        std::find_if(instruments->begin(), instruments->end(),
-                     boost::bind(&instrument_t::symbol, _1) == future_symbol);
-    if (fitting_future != instruments->end()) {
-      m_future = *fitting_future;
-    } else {
-      auto const perpetual_symbol = future_symbol.substr(0, 3) + "-PERPETUAL";
-      auto perpetual = std::find_if(
-          instruments->begin(), instruments->end(),
-          boost::bind(&instrument_t::symbol, _1) == perpetual_symbol);
-      if (perpetual == instruments->end()) {
-        report_error("Impossible to find the Perpetual (" + perpetual_symbol +
-                     "). Exiting before something wrong happens");
-      }
-      m_future = *perpetual;
-    }
 
-    // Create an empty position for the future
-    m_positions[m_future->symbol].instrument = *m_future;
-    m_positions[m_future->symbol].position = position_t{
-        m_future->symbol, volume_t(0), side_t::BUY, price_t(0), price_t(0)};
+  auto const error = select_instruments();
+  if (error) {
+    report_error(*error);
   }
+  m_instruments_selected = true;
 
   // Requesting now all active orders (It could be that we have some hanging
   // from last run)
@@ -277,7 +358,14 @@ void gamma_scalper::on_message(optional<positions_list_t> const &positions) {
     m_positions[position.symbol].position = position;
   }
 
-  m_market->request_instrument_list();
+  // If the snapshot from the last run knows every instrument, there's no need
+  // to wait for the instrument list to start
+  m_instruments_selected = !select_instruments();
+  if (m_instruments_selected) {
+    m_market->request_mass_status();
+  }
+
+  m_market_data.request_instrument_list();
 }
 
 void gamma_scalper::on_message(execution_report_t &report) {
@@ -286,34 +374,43 @@ void gamma_scalper::on_message(execution_report_t &report) {
     // Store the execution report in the correct side
     m_order = order_t{};
 
-    m_order->id = report.order_id.get();
-    m_order->original_id = report.original_order_id.get();
-    m_order->side = report.side.get();
-    m_order->order_price = report.order_price.get();
-    m_order->full_volume = report.executed_volume.get();
-    m_order->open_volume = report.open_volume.get();
+    m_order->id = report.order_id.str();
+    m_order->original_id = report.original_order_id.str();
+    m_order->side = report.side;
+    m_order->order_price = report.order_price;
+    m_order->full_volume = report.executed_volume;
+    m_order->open_volume = report.open_volume;
 
     --m_mass_reports_incoming;
 
     // All orders were received already
     if (m_mass_reports_incoming == 0) {
-      m_market->request_market_data(m_future->symbol);
-      m_market->request_market_data(m_straddle_call->symbol);
-      m_market->request_market_data(m_straddle_put->symbol);
+      request_market_data();
     }
     return;
   }
 
   // Normal processing of an execution report
-  if (!report.symbol) {
+  if (!report.has_all(execution_report_t::SYMBOL |
+                      execution_report_t::ORDER_STATUS)) {
+    return;
+  }
+
+  // Children of the hedge being worked
+  if (m_execution && m_execution->on_report(report)) {
+    if (report.order_status == order_status_t::FILLED ||
+        report.order_status == order_status_t::PARTIAL) {
+      update_position(report);
+    }
     return;
   }
 
   // If it's an order sent by the strategy, check what to do
-  if ((m_order && report.order_id && m_order->id == *report.order_id) ||
-      (m_order && report.original_order_id &&
-       m_order->original_id == *report.original_order_id)) {
-    switch (*report.order_status) {
+  if ((m_order && report.has(execution_report_t::ORDER_ID) &&
+       m_order->id == report.order_id) ||
+      (m_order && report.has(execution_report_t::ORIGINAL_ORDER_ID) &&
+       m_order->original_id == report.original_order_id)) {
+    switch (report.order_status) {
       case order_status_t::FILLED:
         details::update_filled_volume(*m_order, report);
         update_position(report);
@@ -322,18 +419,18 @@ void gamma_scalper::on_message(execution_report_t &report) {
         m_order = optional<order_t>(boost::none);
         break;
       case order_status_t::PARTIAL: {
-        m_order->id = *report.order_id;
+        m_order->id = report.order_id.str();
         details::update_filled_volume(*m_order, report);
         update_position(report);
         break;
       }
       case order_status_t::NEW:
-        m_order->id = *report.order_id;
+        m_order->id = report.order_id.str();
         break;
     }
   } else {
     // Order not sent by the strategy
-    switch (*report.order_status) {
+    switch (report.order_status) {
       case order_status_t::FILLED:
       case order_status_t::PARTIAL:
         update_position(report);
@@ -341,45 +438,78 @@ void gamma_scalper::on_message(execution_report_t &report) {
   }
 }
 
+void gamma_scalper::on_message(order_cancel_reject_t const &report) {
+  // A replace of the hedge rejected leaves the child it replaced working
+  if (m_execution) {
+    m_execution->on_reject(report);
+  }
+}
+
+void gamma_scalper::on_subscription_rejected(symbol_t const &symbol,
+                                             string const &reason) {
+  // The smile does without the quotes of an option around the straddle
+  auto const id = m_instruments.find(symbol);
+  if (id && *id != m_future_id && *id != m_straddle_call_id &&
+      *id != m_straddle_put_id) {
+    std::cerr << "Market data for " << symbol << " was rejected: " << reason
+              << std::endl;
+    return;
+  }
+  report_error("Market data for " + symbol.str() + " was rejected: " +
+               reason + ". Exiting before something goes wrong");
+}
+
 void gamma_scalper::on_message(market_update_t const &update) {
   // We are always expecting to get one bid and one ask
   if (update.updates.size() > 2) {
     report_error("Received an bbo with more than two legs. This is wrong");
   }
 
-  BBO_t target_bbo;
-  for (auto const &update_component : update.updates) {
-    if (update_component.side == market_side_t::BID) {
-      target_bbo.bid_volume = update_component.level_volume;
-      target_bbo.bid = update_component.level_price;
-    } else {
-      target_bbo.ask_volume = update_component.level_volume;
-      target_bbo.ask = update_component.level_price;
-    }
+  auto const target_bbo = get_bbo(update);
+
+  auto const id = m_instruments.find(update.symbol);
+  if (!id) {
+    return;
   }
 
-  if (update.symbol == m_future->symbol) {
-    m_future->bbo = target_bbo;
-  } else if (update.symbol == m_straddle_call->symbol) {
-    m_straddle_call->bbo = target_bbo;
-  } else if (update.symbol == m_straddle_put->symbol) {
-    m_straddle_put->bbo = target_bbo;
-  } else {
+  // Keeping the market data, the chain and the smiles up to date. The host
+  // keeps the books it shares
+  if (!m_host) {
+    m_instruments.bbo(*id) = target_bbo;
+  }
+  m_ledger.mark(*id, target_bbo);
+  if (m_chain.update_bbo(*id, target_bbo)) {
+    m_surface.invalidate(*id);
+  }
+
+  if (*id == m_straddle_call_id || *id == m_straddle_put_id) {
+    m_straddle_quoted = true;
+  } else if (*id != m_future_id) {
     // Ignore this update. Not for straddle nor underlying
     return;
   }
 
-  // We're subscribing to three instruments, therefore, we wait for the
-  // snapshots of each before considering the strategy to be initialized
-  if (m_snapshots.size() < 3) {
-    m_snapshots.emplace(update.symbol);
-    // This double check will only happen three times
-    if (m_snapshots.size() < 3) {
-      return;
-    }
+  // Waiting for the snapshots of the three instruments before evaluating,
+  // also while any of them is recovering from a gap
+  if (!market_data_ready()) {
+    return;
+  }
+
+  // The hedge follows the book of the future
+  if (*id == m_future_id && m_execution) {
+    m_execution->on_book(second_clock::local_time());
   }
 
+  auto const start = std::chrono::steady_clock::now();
   evaluate();
+  auto const elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+  ++m_latency.evaluations;
+  m_latency.last_ns = elapsed;
+  m_latency.max_ns = std::max<int64_t>(m_latency.max_ns, elapsed);
+  m_latency.total_ns += elapsed;
+  publish_snapshot();
 }
 
 void gamma_scalper::print_report() {
@@ -389,55 +519,227 @@ void gamma_scalper::print_report() {
     std::cout << position.second.position << std::endl;
   }
   std::cout << "+----------- Instruments to use -----------+" << std::endl;
-  std::cout << "Straddle call: " << m_straddle_call << std::endl;
-  std::cout << "Straddle put : " << m_straddle_put << std::endl;
-  std::cout << "fufure       : " << m_future << std::endl;
-  std::cout << "+--------- Straddle's strike price --------+" << std::endl;
-  std::cout << to_string(m_straddle_call->strike_price) << std::endl;
+  if (!m_instruments_selected) {
+    std::cout << "None selected" << std::endl;
+  } else {
+    std::cout << "Straddle call: " << straddle_call() << std::endl;
+    std::cout << "Straddle put : " << straddle_put() << std::endl;
+    std::cout << "fufure       : " << future() << std::endl;
+    std::cout << "+--------- Straddle's strike price --------+" << std::endl;
+    std::cout << to_string(straddle_call().strike_price) << std::endl;
+  }
   std::cout << "+--------------- Active order -------------+" << std::endl;
   std::cout << "- " << m_order << std::endl;
+  if (m_execution) {
+    std::cout << "- hedge " << to_string(m_execution->parent().side) << " "
+              << to_string(m_execution->filled()) << " of "
+              << to_string(m_execution->parent().volume) << std::endl;
+  }
   std::cout << "+------------------- BBOs -----------------+" << std::endl;
-  if (m_future) {
-    std::cout << "future " << m_future->symbol << ": " << std::endl;
-    if (m_future->bbo) {
-      std::cout << to_string(m_future->bbo->bid_volume) << " # "
-                << to_string(m_future->bbo->bid) << " - "
-                << to_string(m_future->bbo->ask) << " # "
-                << to_string(m_future->bbo->ask_volume) << std::endl;
+  if (m_instruments_selected) {
+    for (auto const id : {m_future_id, m_straddle_call_id, m_straddle_put_id}) {
+      auto const &bbo = m_instruments.bbo(id);
+      std::cout << m_instruments.get(id).symbol << ": " << std::endl;
+      std::cout << to_string(bbo.bid_volume) << " # " << to_string(bbo.bid)
+                << " - " << to_string(bbo.ask) << " # "
+                << to_string(bbo.ask_volume) << std::endl;
     }
   }
-  if (m_straddle_call) {
-    std::cout << "call " << m_straddle_call->symbol << ": " << std::endl;
-    if (m_straddle_call->bbo) {
-      std::cout << to_string(m_straddle_call->bbo->bid_volume) << " # "
-                << to_string(m_straddle_call->bbo->bid) << " - "
-                << to_string(m_straddle_call->bbo->ask) << " # "
-                << to_string(m_straddle_call->bbo->ask_volume) << std::endl;
-    }
+  std::cout << "+------------------- Deltas ---------------+" << std::endl;
+  std::cout << "future: "
+            << details::get_delta_string(m_greeks.position(m_future_id))
+            << std::endl;
+  std::cout << "call  : "
+            << details::get_delta_string(m_greeks.position(m_straddle_call_id))
+            << std::endl;
+  std::cout << "put   : "
+            << details::get_delta_string(m_greeks.position(m_straddle_put_id))
+            << std::endl;
+  auto const pnl = m_ledger.totals();
+  std::cout << "+-------------------- PnL -----------------+" << std::endl;
+  std::cout << "realized: " << pnl.realized
+            << " unrealized: " << pnl.unrealized << " fees: " << pnl.fees
+            << std::endl;
+  auto const outbound = m_market->outbound_metrics();
+  if (outbound) {
+    std::cout << "+----------------- Outbound ---------------+" << std::endl;
+    std::cout << "cancels: " << outbound->depth[FIX::outbound_scheduler::CANCEL]
+              << " orders: " << outbound->depth[FIX::outbound_scheduler::ORDER]
+              << " requests: "
+              << outbound->depth[FIX::outbound_scheduler::REQUEST]
+              << " max: " << outbound->max_depth << std::endl;
+    std::cout << "sent: " << outbound->sent
+              << " delayed: " << outbound->delayed
+              << " coalesced: " << outbound->coalesced << std::endl;
   }
-  if (m_straddle_put) {
-    std::cout << "put " << m_straddle_put->symbol << ": " << std::endl;
-    if (m_straddle_put->bbo) {
-      std::cout << to_string(m_straddle_put->bbo->bid_volume) << " # "
-                << to_string(m_straddle_put->bbo->bid) << " - "
-                << to_string(m_straddle_put->bbo->ask) << " # "
-                << to_string(m_straddle_put->bbo->ask_volume) << std::endl;
+  std::cout << "+------------- Risk rejections ------------+" << std::endl;
+  for (auto verdict = risk_gate::verdict_t::ORDER_VOLUME;
+       verdict != risk_gate::verdict_t::VERDICTS;
+       verdict = static_cast<risk_gate::verdict_t>(
+           static_cast<int>(verdict) + 1)) {
+    if (m_risk.rejections(verdict) > 0) {
+      std::cout << risk_gate::describe(verdict) << ": "
+                << m_risk.rejections(verdict) << std::endl;
     }
   }
-  std::cout << "+------------------- Deltas ---------------+" << std::endl;
-  std::cout << "future: " << m_delta_future << std::endl;
-  std::cout << "call  : " << m_delta_call << std::endl;
-  std::cout << "put   : " << m_delta_put << std::endl;
   std::cout << "############################################" << std::endl;
   std::cout << std::endl;
 }
 
+optional<string> gamma_scalper::select_instruments() {
+  m_straddle_call_id = no_instrument_id;
+  m_straddle_put_id = no_instrument_id;
+  m_future_id = no_instrument_id;
+
+  // Filling position's instruments
+  for (auto &position : m_positions) {
+    auto const id = m_instruments.find(position.first);
+    if (!id) {
+      return string(
+          "There's no instrument information for instrument's position" +
+          position.first.str() + ". Exiting before something goes wrong");
+    }
+    position.second.id = *id;
+
+    // Calculating what is the straddle and what is the future to use
+    auto const &instrument = m_instruments.get(*id);
+    if (instrument.type == "OPT") {
+      if (instrument.put_call == option_type_t::CALL) {
+        m_straddle_call_id = *id;
+      } else {
+        m_straddle_put_id = *id;
+      }
+    } else {
+      m_future_id = *id;
+    }
+  }
+
+  // Checking that we have the straddle and that it's a valid one
+  if (m_straddle_call_id == no_instrument_id ||
+      m_straddle_put_id == no_instrument_id) {
+    return string(
+        "After getting the instrument list, impossible to determine the "
+        "straddle. This should never happen!");
+  }
+  auto const &call = straddle_call();
+  auto const &put = straddle_put();
+  if ((call.main_currency != put.main_currency) ||
+      !call.has(instrument_t::MATURITY_DATE) ||
+      !put.has(instrument_t::MATURITY_DATE) ||
+      (call.maturity_date != put.maturity_date) ||
+      (call.strike_price != put.strike_price)) {
+    return string("The straddle is not correct. " + call.symbol.str() +
+                  " and " + put.symbol.str() +
+                  " are not allowed to be together");
+  }
+
+  m_chain.rebuild(call.main_currency);
+  m_surface.reset();
+
+  // If we don't have the future, use the one expiring with the straddle, else
+  // the perpetual
+  if (m_future_id == no_instrument_id) {
+    auto fitting_future = m_chain.find_future(call.maturity_date);
+    if (!fitting_future) {
+      fitting_future = m_chain.perpetual();
+      if (!fitting_future) {
+        return string("Impossible to find the Perpetual for " +
+                      to_string(call.main_currency) +
+                      ". Exiting before something wrong happens");
+      }
+    }
+    m_future_id = *fitting_future;
+
+    // Create an empty position for the future
+    auto const &symbol = future().symbol;
+    m_positions[symbol].id = m_future_id;
+    m_positions[symbol].position = position_t{
+        symbol, volume_t(0), side_t::BUY, price_t(0), price_t(0)};
+  }
+
+  register_positions();
+  return boost::none;
+}
+
+void gamma_scalper::register_positions() {
+  // Everything is hedged with the future, its price moves all the positions
+  m_greeks = portfolio_greeks();
+  for (auto const &position : m_positions) {
+    auto const quantity =
+        details::get_signed_quantity(position.second.position);
+    m_greeks.set_position(position.second.id,
+                          m_instruments.get(position.second.id), m_future_id,
+                          quantity);
+    m_risk.set_position(position.second.id, quantity);
+    m_ledger.reconcile(position.second.id, quantity,
+                       position.second.position.settlement_price);
+  }
+}
+
+void gamma_scalper::request_market_data() {
+  // A single request for all the instruments in use, and the options around
+  // the straddle's strike feeding its smile
+  vector<string> symbols{future().symbol.str(), straddle_call().symbol.str(),
+                         straddle_put().symbol.str()};
+  auto const location = m_chain.locate(m_straddle_call_id);
+  if (location) {
+    auto const &expiry = m_chain.expiries()[location->expiry];
+    auto const first =
+        location->strike - std::min(location->strike, m_surface_strikes);
+    auto const last = std::min(expiry.strikes.size(),
+                               location->strike + m_surface_strikes + 1);
+    for (auto strike = first; strike < last; ++strike) {
+      for (auto const id :
+           {expiry.calls.instrument[strike], expiry.puts.instrument[strike]}) {
+        if (id != no_instrument_id && id != m_straddle_call_id &&
+            id != m_straddle_put_id) {
+          symbols.push_back(m_instruments.get(id).symbol.str());
+        }
+      }
+    }
+  }
+  m_market_data.request_market_data(symbols);
+}
+
+bool gamma_scalper::market_data_ready() const {
+  for (auto const id : {m_future_id, m_straddle_call_id, m_straddle_put_id}) {
+    auto const &symbol = m_instruments.get(id).symbol;
+    auto const state = m_market_data.market_data_state(symbol);
+    if (state != FIX::market_data_subscriptions::state_t::ACTIVE) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void gamma_scalper::refresh_instruments() {
+  // Identifiers are stable, only check nothing we use was delisted
+  for (auto const &position : m_positions) {
+    check_listed(position.second.id);
+  }
+  check_listed(m_straddle_call_id);
+  check_listed(m_straddle_put_id);
+  check_listed(m_future_id);
+
+  m_chain.rebuild(straddle_call().main_currency);
+  m_surface.reset();
+  register_positions();
+}
+
+void gamma_scalper::check_listed(instrument_id_t id) {
+  if (!m_instruments.is_active(id)) {
+    report_error("Instrument " + m_instruments.get(id).symbol.str() +
+                 " is not listed anymore. Exiting before something goes "
+                 "wrong");
+  }
+}
+
 void gamma_scalper::evaluate() {
   std::cout << "gammas_scalper::evaluate" << std::endl;
   // Getting time to expiration
   ptime now = second_clock::local_time();
   double time_to_expiration =
-      (m_straddle_call->maturity_date->date() - now.date()).days() / 360.0;
+      (straddle_call().maturity_date.date() - now.date()).days() / 360.0;
 
   if (time_to_expiration < 0) {
     report_error("Straddles maturity was reached, stopping strategy");
@@ -445,31 +747,45 @@ void gamma_scalper::evaluate() {
         std::logic_error("Stopping because maturity was reached"));
   }
 
-  // Updating deltas
-  auto error = update_deltas(time_to_expiration);
+  // A single version of the parameters for the whole evaluation
+  auto const parameters = std::atomic_load(&m_parameters);
 
-  if (error) {
-    std::cout << "Skipping: " << to_string(error) << std::endl;
-    // If we can't calculate deltas, ignore this cicle
-    return;
+  // Small underlying moves don't need pricing the straddle again
+  auto total_delta = estimate_delta(now, *parameters);
+  if (!total_delta) {
+    auto error = update_deltas(now, time_to_expiration, *parameters);
+
+    if (error) {
+      std::cout << "Skipping: " << to_string(error) << std::endl;
+      // If we can't calculate deltas, ignore this cicle
+      return;
+    }
+    total_delta = m_greeks.total(m_future_id).delta;
   }
 
   // Calculating if new orders are needed
-  auto total_delta = m_delta_put + m_delta_call + m_delta_future;
 
+  auto const &future_bbo = m_instruments.bbo(m_future_id);
+  auto const contract_multiplier = future().contract_multiplier;
   auto delta_per_future =
-      *m_future->contract_multiplier /
-      static_cast<double>(*details::get_price(m_future->bbo));
+      contract_multiplier /
+      static_cast<double>(*details::get_price(future_bbo));
 
   int corrections_todo = static_cast<int>(
-      (static_cast<int>(std::round(total_delta / delta_per_future)) /
-       *m_future->contract_multiplier) *
-      *m_future->contract_multiplier);
-
-  std::cout << "Future delta     : " << m_delta_future << std::endl;
-  std::cout << "Call delta       : " << m_delta_call << std::endl;
-  std::cout << "Put  delta       : " << m_delta_put << std::endl;
-  std::cout << "Total delta      : " << total_delta << std::endl;
+      (static_cast<int>(std::round(*total_delta / delta_per_future)) /
+       contract_multiplier) *
+      contract_multiplier);
+
+  std::cout << "Future delta     : "
+            << details::get_delta_string(m_greeks.position(m_future_id))
+            << std::endl;
+  std::cout << "Call delta       : "
+            << details::get_delta_string(m_greeks.position(m_straddle_call_id))
+            << std::endl;
+  std::cout << "Put  delta       : "
+            << details::get_delta_string(m_greeks.position(m_straddle_put_id))
+            << std::endl;
+  std::cout << "Total delta      : " << *total_delta << std::endl;
   std::cout << "Delta per future : " << delta_per_future << std::endl;
   std::cout << "Corrections to do: " << corrections_todo << std::endl;
 
@@ -490,43 +806,74 @@ void gamma_scalper::evaluate() {
       return;
     }
 
-    price_t price_to_use = m_levels.get_price_to_use(side, *m_future);
     volume_t volume_to_use =
         m_levels.get_volume_to_use(side, volume_t(std::abs(corrections_todo)));
-    std::cout << "Price to use: " << to_string(price_to_use) << std::endl;
     std::cout << "Volume to use: " << to_string(volume_to_use) << std::endl;
 
+    // Algorithms work the hedge with orders of their own
+    if (m_execution_settings.algorithm !=
+        execution_algo::algorithm_t::LIMIT) {
+      hedge(side, volume_to_use,
+            m_levels.get_limit_price(side, future(),
+                                     parameters->price_sweetener),
+            now);
+      return;
+    }
+
+    price_t price_to_use =
+        m_levels.get_price_to_use(side, future(), future_bbo,
+                                  parameters->price_sweetener);
+    std::cout << "Price to use: " << to_string(price_to_use) << std::endl;
+
+    // Refused orders are counted by the gate, see the report
+    if (check_risk(m_future_id, side, price_to_use, volume_to_use) !=
+        risk_gate::verdict_t::ACCEPTED) {
+      return;
+    }
+
     m_order = order_t{};
     auto const order_id =
-        m_market->send_gtc_order(m_future->symbol, side, price_to_use,
+        m_market->send_gtc_order(future().symbol.str(), side, price_to_use,
                                  static_cast<volume_t>(volume_to_use));
     m_order->original_id = order_id;
     m_order->open_volume = volume_to_use;
     m_order->full_volume = 0;
     m_order->side = side;
     m_order->order_price = price_to_use;
-    std::cout << m_future->symbol << " " << m_order << std::endl;
+    std::cout << future().symbol << " " << m_order << std::endl;
   }
 }
 
-optional<string> gamma_scalper::update_deltas(double time_to_expiration) {
+optional<string> gamma_scalper::update_deltas(ptime const &now,
+                                              double time_to_expiration,
+                                              parameters_t const &parameters) {
   // Underlying price
-  auto underlying_price = details::get_price(m_future->bbo);
+  auto underlying_price = details::get_price(m_instruments.bbo(m_future_id));
   if (!underlying_price) {
     // Impossible to do calculations if there's no underlying price
     return optional<string>("Missing underlying price");
   }
 
-  double cost_of_carry = m_interest_rate;
+  double cost_of_carry = parameters.interest_rate;
 
-  // Calculating mid prices. If any is missing, try to get the other using the
-  // put-call parity property of european options
+  // Fitting again the smiles whose quotes changed or whose underlying moved
+  m_surface.refit(*underlying_price, parameters.interest_rate,
+                  parameters.reprice_move, now);
+  auto const &call = straddle_call();
+  auto const &call_bbo = m_instruments.bbo(m_straddle_call_id);
+  auto const &put_bbo = m_instruments.bbo(m_straddle_put_id);
+  auto const surface_volatility =
+      m_surface.volatility(call.strike_price, call.maturity_date);
+
+  // Calculating mid prices. If any is missing, price it from the volatility
+  // surface or try to get the other using the put-call parity property of
+  // european options
   auto call_price = details::get_call_price(
-      m_straddle_call->bbo, m_straddle_put->bbo, underlying_price,
-      time_to_expiration, *m_straddle_call->strike_price, m_interest_rate);
+      call_bbo, put_bbo, underlying_price, time_to_expiration,
+      call.strike_price, parameters.interest_rate, surface_volatility);
   auto put_price = details::get_put_price(
-      m_straddle_call->bbo, m_straddle_put->bbo, underlying_price,
-      time_to_expiration, *m_straddle_call->strike_price, m_interest_rate);
+      call_bbo, put_bbo, underlying_price, time_to_expiration,
+      call.strike_price, parameters.interest_rate, surface_volatility);
 
   // If after everything we have no prices. Ignore this cicle... imposible to
   // calculate deltas without market
@@ -538,63 +885,41 @@ optional<string> gamma_scalper::update_deltas(double time_to_expiration) {
   call_price = *call_price < 0 ? optional<price_t>(0) : call_price;
   put_price = *put_price < 0 ? optional<price_t>(0) : put_price;
 
-  // calculating call delta
-  auto call_delta = details::get_delta(
-      option_type_t::CALL, *underlying_price, *m_straddle_call->strike_price,
-      m_interest_rate, time_to_expiration, cost_of_carry, *call_price);
-
-  // calculating put delta
-  auto put_delta = details::get_delta(
-      option_type_t::PUT, *underlying_price, *m_straddle_call->strike_price,
-      m_interest_rate, time_to_expiration, cost_of_carry, *put_price);
-  //  put deltas are supposed to be negative. Reverting sign if there's a value
-  if (put_delta) {
-    put_delta = -*put_delta;
+  // Calculating the volatility of each leg
+  auto call_volatility = details::get_implied_volatility(
+      option_type_t::CALL, *underlying_price, call.strike_price,
+      parameters.interest_rate, time_to_expiration, cost_of_carry, *call_price);
+  auto put_volatility = details::get_implied_volatility(
+      option_type_t::PUT, *underlying_price, call.strike_price,
+      parameters.interest_rate, time_to_expiration, cost_of_carry, *put_price);
+
+  // We have at leas one volatility
+  if (!call_volatility && !put_volatility) {
+    return string("Missing both volatilities");
   }
 
-  // We have at leas one delta
-  if (!call_delta && !put_delta) {
-    return string("Missing both deltas");
+  // Both legs share strike and maturity. The one missing its volatility uses
+  // the other's, which keeps the put-call parity between deltas
+  if (!call_volatility) {
+    call_volatility = put_volatility;
+  } else if (!put_volatility) {
+    put_volatility = call_volatility;
   }
 
-  // Trying to deduce one delta from the other (dS + dP = dC) in case one is
-  // missing
-  if (!call_delta && put_delta) {
-    if (*put_delta > 0) {
-      put_delta = 0.0;
-    }
-    call_delta = 1 + *put_delta;
-  } else if (call_delta && !put_delta) {
-    if (*call_delta < 0) {
-      call_delta = 0.0;
-    }
-    put_delta = 1 - *call_delta;
-  }
+  // Pricing again only what changed
+  m_greeks.set_volatility(m_straddle_call_id, *call_volatility);
+  m_greeks.set_volatility(m_straddle_put_id, *put_volatility);
+  m_greeks.set_underlying_price(m_future_id, *underlying_price);
+  m_greeks.update(now, parameters.interest_rate);
 
-  // If any delta is nan, skip this cicle
-  if (isnan(*call_delta) || isnan(*put_delta)) {
-    return optional<string>("Some delta is NaN");
+  // If any delta is missing or NaN, skip this cicle
+  if (m_greeks.total(m_future_id).missing) {
+    return optional<string>("Some delta is missing");
   }
 
-  // Updating cached values taking into consideration the position
-  auto &future_position = m_positions[m_future->symbol];
-  int future_quantity_sign =
-      future_position.position.side == side_t::BUY ? 1 : -1;
-  m_delta_future = ((future_position.position.quantity * future_quantity_sign) *
-                    *future_position.instrument.contract_multiplier) /
-                   *underlying_price;
-
-  auto &call_position = m_positions[m_straddle_call->symbol];
-  int call_quantity_sign = call_position.position.side == side_t::BUY ? 1 : -1;
-  m_delta_call = *call_delta *
-                 (call_position.position.quantity * call_quantity_sign) *
-                 *call_position.instrument.contract_multiplier;
-
-  auto &put_position = m_positions[m_straddle_put->symbol];
-  int put_quantity_sign = put_position.position.side == side_t::BUY ? 1 : -1;
-  m_delta_put = *put_delta *
-                (put_position.position.quantity * put_quantity_sign) *
-                *put_position.instrument.contract_multiplier;
+  m_priced_time = now;
+  m_priced_underlying = *underlying_price;
+  m_straddle_quoted = false;
 
   std::cout << " Underlying price: " << underlying_price << std::endl;
   std::cout << " call price      : " << call_price << std::endl;
@@ -603,14 +928,118 @@ optional<string> gamma_scalper::update_deltas(double time_to_expiration) {
   return boost::none;
 }
 
+optional<double> gamma_scalper::estimate_delta(
+    ptime const &now, parameters_t const &parameters) {
+  // New straddle quotes or positions change the volatilities or the greeks
+  if (m_straddle_quoted || m_greeks.is_stale() || m_priced_time.is_special()) {
+    return boost::none;
+  }
+
+  // Time to expiration only changes with the day
+  if (now.date() != m_priced_time.date() ||
+      now - m_priced_time > parameters.reprice_interval) {
+    return boost::none;
+  }
+
+  auto const underlying_price =
+      details::get_price(m_instruments.bbo(m_future_id));
+  if (!underlying_price) {
+    return boost::none;
+  }
+  auto const price = static_cast<double>(*underlying_price);
+  if (std::abs(price / m_priced_underlying - 1) > parameters.reprice_move) {
+    return boost::none;
+  }
+
+  auto const greeks = m_greeks.estimate(m_future_id, price);
+  if (greeks.missing) {
+    return boost::none;
+  }
+  return greeks.delta;
+}
+
 void gamma_scalper::report_error(string const &message) {
   print_report();
   std::cerr << message << std::endl;
   BOOST_THROW_EXCEPTION(std::runtime_error(message));
 }
 
+void gamma_scalper::hedge(side_t side, volume_t volume,
+                          optional<price_t> const &limit, ptime const &now) {
+  // A hedge on the same side goes on. On the other side it's canceled and the
+  // next cycle hedges again
+  if (m_execution && !m_execution->done()) {
+    if (m_execution->parent().side != side) {
+      m_execution->cancel();
+    }
+    return;
+  }
+
+  m_execution = execution_algo::create(m_execution_settings,
+                                       {m_future_id, side, volume, limit},
+                                       m_instruments, *this, now);
+  m_execution->on_book(now);
+}
+
+optional<string> gamma_scalper::send_order(instrument_id_t id, side_t side,
+                                           price_t price, volume_t volume,
+                                           time_in_force_t time_in_force) {
+  if (check_risk(id, side, price, volume) != risk_gate::verdict_t::ACCEPTED) {
+    return boost::none;
+  }
+
+  auto const symbol = m_instruments.get(id).symbol.str();
+  if (time_in_force == time_in_force_t::IOC) {
+    return m_market->send_ioc_order(symbol, side, price, volume);
+  }
+  return m_market->send_gtc_order(symbol, side, price, volume);
+}
+
+optional<string> gamma_scalper::replace_order(string const &order_id,
+                                              instrument_id_t id, side_t side,
+                                              price_t price, volume_t volume) {
+  // Only the child of the algorithm is replaced. What it filled is already in
+  // the position, the rest of the replace is the new volume
+  auto const working =
+      m_execution ? m_execution->working_volume() : volume_t(0);
+  auto const filled = m_execution ? m_execution->child_filled() : volume_t(0);
+  if (check_risk(id, side, price, static_cast<volume_t>(volume - filled),
+                 working) != risk_gate::verdict_t::ACCEPTED) {
+    return boost::none;
+  }
+
+  return m_market->send_replace_order(
+      order_id, m_instruments.get(id).symbol.str(), side, price, volume);
+}
+
+risk_gate::verdict_t gamma_scalper::check_risk(instrument_id_t id,
+                                               side_t side, price_t price,
+                                               volume_t volume,
+                                               volume_t replaced) {
+  // The strategy only works orders on the future: its own order or the
+  // child of the algorithm hedging
+  auto buy_volume = 0.0;
+  auto sell_volume = 0.0;
+  if (id == m_future_id) {
+    if (m_order) {
+      (m_order->side == side_t::BUY ? buy_volume : sell_volume) +=
+          static_cast<double>(m_order->open_volume);
+    }
+    if (m_execution) {
+      (m_execution->parent().side == side_t::BUY ? buy_volume : sell_volume) +=
+          static_cast<double>(m_execution->working_volume());
+    }
+  }
+  m_risk.set_working(id, buy_volume, sell_volume);
+  return m_risk.check(id, side, price, volume, replaced);
+}
+
+void gamma_scalper::cancel_order(string const &order_id) {
+  m_market->send_cancel_order(order_id);
+}
+
 void gamma_scalper::cancel_all_orders() {
-  if (!m_order) {
+  if (!m_order && !m_execution) {
     // Nothing to cancel
     return;
   }
@@ -618,25 +1047,28 @@ void gamma_scalper::cancel_all_orders() {
   // Cancel and remove
   m_market->send_mass_cancellation_order();
   m_order = optional<order_t>(boost::none);
+  m_execution.reset();
 }
 
 void gamma_scalper::update_position(execution_report_t &report) {
   std::stringstream ss;
   ss << report;
 
-  if ((m_positions.find(*report.symbol) == m_positions.end()) ||
-      !report.average_execution_price || !report.side ||
-      !report.executed_volume || !report.average_execution_price) {
+  auto const required = execution_report_t::SYMBOL | execution_report_t::SIDE |
+                        execution_report_t::EXECUTED_VOLUME |
+                        execution_report_t::AVERAGE_EXECUTION_PRICE;
+  auto const found = m_positions.find(report.symbol);
+  if (found == m_positions.end() || !report.has_all(required)) {
     // If pre-conditions don't apply, don't update position
     return;
   }
 
   std::cout << "Updating position" << std::endl;
   // Updating position quantity and sign
-  auto &position = m_positions[*report.symbol];
-  auto const filled_volume = *report.side == side_t::BUY
-                                 ? *report.executed_volume
-                                 : -*report.executed_volume;
+  auto &position = found->second;
+  auto const filled_volume = report.side == side_t::BUY
+                                 ? report.executed_volume
+                                 : -report.executed_volume;
   auto const signed_quantity = position.position.side == side_t::BUY
                                    ? position.position.quantity
                                    : -position.position.quantity;
@@ -648,16 +1080,93 @@ void gamma_scalper::update_position(execution_report_t &report) {
 
   position.position.quantity = std::abs(new_quantity);
   position.position.side = new_quantity >= 0 ? side_t::BUY : side_t::SELL;
+  m_greeks.set_position(position.id, m_instruments.get(position.id),
+                        m_future_id, new_quantity);
+  m_risk.set_position(position.id, new_quantity);
+  // The volume is the one of this fill, the average price the one of the
+  // whole order
+  auto const fill_price = report.has(execution_report_t::LAST_EXECUTION_PRICE)
+                              ? report.last_execution_price
+                              : report.average_execution_price;
+  m_ledger.on_fill(position.id, report.side, report.executed_volume,
+                   fill_price);
 
   // Updating prices
-  position.position.settlement_price = *report.average_execution_price;
-  position.position.underlying_end_price =
-      static_cast<price_t>(*details::get_price(m_future->bbo));
+  position.position.settlement_price = report.average_execution_price;
+  position.position.underlying_end_price = static_cast<price_t>(
+      *details::get_price(m_instruments.bbo(m_future_id)));
 
   std::cout << "position: " << position.position << std::endl;
 
   // Updating levels
-  m_levels.update_levels(*report.executed_volume,
-                         *report.average_execution_price, *report.side,
-                         *m_future);
+  m_levels.update_levels(report.executed_volume, fill_price, report.side,
+                         future());
+  publish_snapshot();
+}
+
+void gamma_scalper::publish_snapshot() {
+  auto const missing = std::numeric_limits<double>::quiet_NaN();
+  strategy_snapshot_t snapshot;
+  snapshot.timestamp =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count();
+
+  snapshot.positions_count = 0;
+  snapshot.positions_dropped = 0;
+  for (auto const &position : m_positions) {
+    if (snapshot.positions_count == strategy_snapshot_t::max_positions) {
+      ++snapshot.positions_dropped;
+      continue;
+    }
+    auto const greeks = m_greeks.position(position.second.id);
+    snapshot.positions[snapshot.positions_count++] = {
+        position.first, details::get_signed_quantity(position.second.position),
+        greeks ? greeks->delta : missing};
+  }
+
+  snapshot.orders_count = 0;
+  if (m_order && m_instruments_selected) {
+    snapshot.orders[snapshot.orders_count++] = {
+        m_order->id,
+        future().symbol,
+        m_order->side,
+        static_cast<double>(m_order->order_price),
+        static_cast<double>(m_order->full_volume + m_order->open_volume),
+        static_cast<double>(m_order->full_volume)};
+  }
+  if (m_execution && m_instruments_selected) {
+    auto const &parent = m_execution->parent();
+    snapshot.orders[snapshot.orders_count++] = {
+        "hedge",
+        future().symbol,
+        parent.side,
+        parent.limit ? static_cast<double>(*parent.limit) : missing,
+        static_cast<double>(parent.volume),
+        static_cast<double>(m_execution->filled())};
+  }
+
+  snapshot.books_count = 0;
+  if (m_instruments_selected) {
+    for (auto const id : {m_future_id, m_straddle_call_id, m_straddle_put_id}) {
+      auto const &bbo = m_instruments.bbo(id);
+      snapshot.books[snapshot.books_count++] = {
+          m_instruments.get(id).symbol,
+          bbo.bid_volume ? static_cast<double>(*bbo.bid_volume) : missing,
+          bbo.bid ? static_cast<double>(*bbo.bid) : missing,
+          bbo.ask ? static_cast<double>(*bbo.ask) : missing,
+          bbo.ask_volume ? static_cast<double>(*bbo.ask_volume) : missing};
+    }
+  }
+
+  auto const total = m_greeks.total(m_future_id);
+  snapshot.total_delta = total.missing ? missing : total.delta;
+
+  auto const pnl = m_ledger.totals();
+  snapshot.realized = pnl.realized;
+  snapshot.unrealized = pnl.unrealized;
+  snapshot.fees = pnl.fees;
+
+  snapshot.latency = m_latency;
+  m_snapshot.store(snapshot);
 }
@@ -2,25 +2,60 @@
 
 #include "../config.h"
 
+#include "../config_file/config_watcher.h"
+#include "../execution/execution_algo.h"
+#include "../host/strategy_host.h"
+#include "../instruments/instrument_registry.h"
+#include "../instruments/option_chain.h"
+#include "../monitoring/monitor_endpoint.h"
+#include "../monitoring/seqlock.h"
+#include "../monitoring/strategy_snapshot.h"
+#include "../portfolio/pnl_ledger.h"
+#include "../portfolio/portfolio_greeks.h"
+#include "../pricing/volatility_surface.h"
 #include "../quickfix/quickfix.h"
+#include "../risk/risk_gate.h"
 
 #include "levels.h"
 
 #include <condition_variable>
 #include <deque>
+#include <memory>
 #include <mutex>
-#include <unordered_set>
 
-class gamma_scalper : public FIX::quickfix_user {
+class gamma_scalper : public FIX::quickfix_user, public order_sender {
   struct position_info {
     position_t position;
-    instrument_t instrument;
+    instrument_id_t id;
   };
-  using positions_t = std::unordered_map<string, position_info>;
+  using positions_t = std::unordered_map<symbol_t, position_info>;
 
  public:
-  /** Constructor */
-  gamma_scalper(config_file_t &configuration);
+  // Parameters that can change while running, replaced as a whole when the
+  // configuration file is reloaded. Every evaluation uses a single version
+  struct parameters_t {
+    // Contracts away from the last level to price the hedges
+    double price_sweetener = 0;
+
+    // Rate for the pricing and the cost of carry
+    double interest_rate = 0;
+
+    // Relative underlying move and time before pricing again in full
+    double reprice_move = 0;
+    time_duration reprice_interval;
+  };
+
+  /**
+   * Constructor. Runs alone, with its own market data. The parameters are
+   * reloaded from the configuration file when it changes if
+   * ReloadParameters is enabled
+   */
+  gamma_scalper(config_file_t &configuration,
+                string const &configuration_file);
+
+  /** Constructor. Runs in a host, sharing its market data */
+  gamma_scalper(config_file_t &configuration, string const &configuration_file,
+                strategy_host &host);
 
   /** Destructor */
   ~gamma_scalper();
@@ -28,6 +63,12 @@ class gamma_scalper : public FIX::quickfix_user {
   /** Run the strategy */
   bool run();
 
+  /**
+   * @returns the parameters read from the configuration, failing with the
+   * key when one is missing or invalid
+   */
+  static parameters_t load_parameters(config_file_t const &configuration);
+
   // Overriden methods of the quickfix_user interface
   virtual void on_logon() override;
   virtual void on_logout() override;
@@ -36,27 +77,92 @@ class gamma_scalper : public FIX::quickfix_user {
       optional<instruments_list_t> const &positions) override;
   virtual void on_message(optional<positions_list_t> const &positions) override;
   virtual void on_message(execution_report_t &report) override;
+  virtual void on_message(order_cancel_reject_t const &report) override;
   virtual void on_message(market_update_t const &update);
+  virtual void on_subscription_rejected(symbol_t const &symbol,
+                                        string const &reason) override;
+
+  // Overriden methods of the order_sender interface. Orders are checked
+  // against the risk limits
+  virtual optional<string> send_order(instrument_id_t id, side_t side,
+                                      price_t price, volume_t volume,
+                                      time_in_force_t time_in_force) override;
+  virtual optional<string> replace_order(string const &order_id,
+                                         instrument_id_t id, side_t side,
+                                         price_t price,
+                                         volume_t volume) override;
+  virtual void cancel_order(string const &order_id) override;
 
  private:
+  // Constructor for both, without host when running alone
+  gamma_scalper(config_file_t &configuration, string const &configuration_file,
+                strategy_host *host);
+
+  // Replaces the parameters with the ones of a configuration reloaded
+  void reload_parameters(config_file_t const &configuration);
+
   // Prints a report of the current positions and open orders
   void print_report();
 
   // Evaluates market data, position and orders in the market
   void evaluate();
 
+  // Selects straddle and future from the positions and the known instruments
+  optional<string> select_instruments();
+
+  // Registers the positions in the greeks engine
+  void register_positions();
+
+  // Subscribes to the market data of the instruments in use
+  void request_market_data();
+
+  // Checks the books of the instruments in use are up to date
+  bool market_data_ready() const;
+
+  // Checks the instruments in use are still listed after a security list
+  void refresh_instruments();
+  void check_listed(instrument_id_t id);
+
+  // Instruments in use, owned by the registry
+  instrument_t const &straddle_call() const {
+    return m_instruments.get(m_straddle_call_id);
+  }
+  instrument_t const &straddle_put() const {
+    return m_instruments.get(m_straddle_put_id);
+  }
+  instrument_t const &future() const { return m_instruments.get(m_future_id); }
+
   // Updates delta values for the given position
-  optional<string> update_deltas(double time_to_expiration);
+  optional<string> update_deltas(ptime const &now, double time_to_expiration,
+                                 parameters_t const &parameters);
+
+  // Estimates the total delta from the last pricing if the underlying barely
+  // moved. Empty if a full pricing is needed
+  optional<double> estimate_delta(ptime const &now,
+                                  parameters_t const &parameters);
 
   // Reports and exits the program with an exception
   void report_error(string const &message);
 
+  // Hands a hedge to the execution algorithm, unless one is working
+  void hedge(side_t side, volume_t volume, optional<price_t> const &limit,
+             ptime const &now);
+
+  // Checks an order with the risk gate, counting the orders working on the
+  // future. A replace gives the volume working of the order it replaces
+  risk_gate::verdict_t check_risk(instrument_id_t id, side_t side,
+                                  price_t price, volume_t volume,
+                                  volume_t replaced = volume_t(0));
+
   // Cancel the current strategy order
   void cancel_all_orders();
 
   // Update the position based on an execution report
   void update_position(execution_report_t &report);
 
+  // Publishes the state for the monitoring
+  void publish_snapshot();
+
   // Configuration file to use
   config_file_t &m_config_file;
 
@@ -65,34 +171,92 @@ class gamma_scalper : public FIX::quickfix_user {
   std::condition_variable m_condition_variable;
   bool m_is_running;
 
-  // Market access
+  // Host sharing the market data with other strategies, null when alone.
+  // When hosted every callback comes through the queue
+  strategy_host *m_host;
+  strategy_queue *m_queue;
+
+  // Detaches the queue from the host when the strategy goes, also when its
+  // construction fails after attaching
+  struct attachment_t {
+    strategy_host *host;
+    strategy_queue *queue;
+
+    ~attachment_t() { detach(); }
+    void detach() {
+      if (host && queue) {
+        host->detach(*queue);
+      }
+      queue = nullptr;
+    }
+  };
+  attachment_t m_attachment;
+
+  // Market access. Orders always go through the own session
   std::unique_ptr<FIX::quickfix> m_market;
+  FIX::market_data_source &m_market_data;
 
   // Strategy's position
   positions_t m_positions;
 
+  // Every instrument known, persisted between runs, and the straddle's chain.
+  // The registry is the host's one when hosted
+  std::unique_ptr<instrument_registry> m_own_instruments;
+  instrument_registry &m_instruments;
+  option_chain m_chain;
+  bool m_instruments_selected;
+
+  // Implied volatilities of the chain, fitted from the quotes of the strikes
+  // around the straddle's one on each side
+  volatility_surface m_surface;
+  size_t m_surface_strikes;
+
   // Instruments to use. Straddle and future
-  optional<instrument_t> m_straddle_call;
-  optional<instrument_t> m_straddle_put;
-  optional<instrument_t> m_future;
+  instrument_id_t m_straddle_call_id;
+  instrument_id_t m_straddle_put_id;
+  instrument_id_t m_future_id;
 
   // Storing information about the last buys and sells
   levels m_levels;
 
-  // Market data snapshots done
-  std::unordered_set<string> m_snapshots;
+  // Greeks of the straddle and the future
+  portfolio_greeks m_greeks;
+
+  // Checks of the orders before they are sent
+  risk_gate m_risk;
 
-  // Deltas for the straddle and the future
-  double m_delta_future;
-  double m_delta_call;
-  double m_delta_put;
+  // Profit and loss of the fills
+  pnl_ledger m_ledger;
+
+  // Last full pricing. Smaller underlying moves are estimated from gamma and
+  // speed until the move or the elapsed time get over the thresholds
+  ptime m_priced_time;
+  double m_priced_underlying;
+  bool m_straddle_quoted;
 
   // Bid and ask orders open for this strategy
   optional<order_t> m_order;
 
+  // Algorithm hedging with the future, and the hedge it's working
+  execution_algo::settings_t m_execution_settings;
+  std::unique_ptr<execution_algo> m_execution;
+
   // Number of incoming execution report that are part of the mass status report
   int m_mass_reports_incoming;
 
-  // Interest rates
-  double m_interest_rate;
+  // Current parameters. Read and replaced atomically, an evaluation keeps the
+  // version it started with
+  std::shared_ptr<parameters_t const> m_parameters;
+
+  // State published after every evaluation and fill, read by the monitoring
+  // without blocking the strategy
+  seqlock<strategy_snapshot_t> m_snapshot;
+  strategy_snapshot_t::latency_t m_latency;
+
+  // Endpoint serving the state to the dashboards, null when not configured
+  std::unique_ptr<monitor_endpoint> m_monitor;
+
+  // Reloads the parameters when the configuration file changes, null when
+  // not enabled. Stopped before anything else is destroyed
+  std::unique_ptr<config_watcher> m_watcher;
 };
@@ -6,15 +6,11 @@
 namespace details {
 
 string const levels_file = "levels";
-string const pnl_file = "pnl";
-string const pnl_log_file = "pnl_log";
 
 }  // namespace details
 
-levels::levels(string aux_folder_path, double price_sweetener)
-    : m_aux_folder_path(aux_folder_path),
-      m_levels(),
-      m_price_sweetener(price_sweetener) {
+levels::levels(string aux_folder_path)
+    : m_aux_folder_path(aux_folder_path), m_levels() {
   load_levels();
 }
 
@@ -53,62 +49,8 @@ void levels::load_levels() {
   file.close();
 }
 
-void levels::store_pnl(price_t front_price, price_t report_price,
-                       side_t report_side, volume_t raw_paired_volume,
-                       instrument_t const& future) {
-  auto const file_path = m_aux_folder_path + details::pnl_file;
-  auto const log_file_path = m_aux_folder_path + details::pnl_log_file;
-
-  double calculated_pnl;
-  auto const paired_volume = raw_paired_volume * *future.contract_multiplier;
-
-  auto top_value = paired_volume / front_price;
-  top_value = report_side == side_t::SELL ? top_value : -top_value;
-
-  auto report_value = paired_volume / report_price;
-  report_value = report_side == side_t::SELL ? -report_value : report_value;
-
-  calculated_pnl = report_value + top_value;
-
-  // Read PNL from file
-  std::ifstream input_file;
-  input_file.open(file_path, std::ios::in);
-
-  string line;
-  optional<double> pnl = optional<double>(boost::none);
-  std::getline(input_file, line);
-  pnl = atof(line.c_str());
-
-  input_file.close();
-
-  // Store PNL in the file
-  std::ofstream output_file;
-  output_file.open(file_path, std::ios::out);
-
-  auto to_write = pnl ? *pnl + calculated_pnl : calculated_pnl;
-  output_file << to_write << std::endl;
-
-  output_file.close();
-
-  // Store PNL log in the file
-  std::ofstream output_log_file;
-  output_log_file.open(log_file_path, std::ios::app);
-
-  output_log_file << "Formula: " << std::endl;
-  output_log_file << "top_value = " << paired_volume << " / " << front_price
-                  << " = " << top_value << std::endl;
-  output_log_file << "report_value = " << paired_volume << " / " << report_price
-                  << " = " << report_value << std::endl;
-  output_log_file << "report side : " << to_string(report_side) << std::endl;
-  output_log_file << top_value << " + " << report_value << " = "
-                  << calculated_pnl << std::endl;
-
-  output_log_file.close();
-}
-
 void levels::update_levels(volume_t traded_volume, price_t traded_price,
                            side_t side, instrument_t const& future) {
-  // Update PnL
   // If we have no levels or front is the same side, insert
   if (m_levels.empty() || (m_levels.front().side == side)) {
     m_levels.push_front({traded_volume, traded_price, side});
@@ -116,9 +58,6 @@ void levels::update_levels(volume_t traded_volume, price_t traded_price,
     // Substract current execution from level
     auto& front = m_levels.front();
     auto const front_volume = front.volume;
-    auto const front_price = front.price;
-    auto filled_volume =
-        front_volume < traded_volume ? front_volume : traded_volume;
 
     front.volume -= traded_volume;
 
@@ -134,7 +73,6 @@ void levels::update_levels(volume_t traded_volume, price_t traded_price,
       // Executed volume was not enough to cover the whole level
       front.volume = traded_volume;
     }
-    store_pnl(front_price, traded_price, side, filled_volume, future);
   }
 
   store_levels();
@@ -142,25 +80,28 @@ void levels::update_levels(volume_t traded_volume, price_t traded_price,
 }
 
 price_t levels::get_price_to_use(side_t const& side,
-                                 instrument_t const& future) {
-  // If front from levels is the same side use future price
-  if (m_levels.empty()) {
-    return side == side_t::BUY ? (*future.bbo->bid) : (*future.bbo->ask);
+                                 instrument_t const& future,
+                                 BBO_t const& bbo, double price_sweetener) {
+  // Without levels use future price
+  auto const limit = get_limit_price(side, future, price_sweetener);
+  if (side == side_t::BUY) {
+    return limit && *limit < *bbo.bid ? *limit : *bbo.bid;
   }
+  return limit && *limit > *bbo.ask ? *limit : *bbo.ask;
+}
 
-  price_t to_return(0);
-  if (side == side_t::BUY) {
-    auto front_price =
-        static_cast<price_t>(m_levels.front().price -
-                             (*future.contract_multiplier * m_price_sweetener));
-    to_return = *future.bbo->bid < front_price ? *future.bbo->bid : front_price;
-  } else {
-    auto front_price =
-        static_cast<price_t>(m_levels.front().price +
-                             (*future.contract_multiplier * m_price_sweetener));
-    to_return = *future.bbo->ask > front_price ? *future.bbo->ask : front_price;
+optional<price_t> levels::get_limit_price(side_t const& side,
+                                          instrument_t const& future,
+                                          double price_sweetener) const {
+  if (m_levels.empty()) {
+    return boost::none;
   }
-  return to_return;
+
+  // Sweetened away from the last level, not to undo it at a loss
+  auto const sweetener = future.contract_multiplier * price_sweetener;
+  return static_cast<price_t>(side == side_t::BUY
+                                  ? m_levels.front().price - sweetener
+                                  : m_levels.front().price + sweetener);
 }
 
 volume_t levels::get_volume_to_use(side_t const& side,
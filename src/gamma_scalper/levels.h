@@ -18,15 +18,27 @@ class levels {
 
  public:
   // Constructor and destructor
-  levels(string aux_folder_path, double m_price_sweetener);
+  levels(string aux_folder_path);
   ~levels();
 
   /** Update the levels with a given execution report */
   void update_levels(volume_t filled, price_t traded_price, side_t side,
                      instrument_t const& future);
 
-  /** @returns price that should be used based on levels */
-  price_t get_price_to_use(side_t const& side, instrument_t const& future);
+  /**
+   * @returns price that should be used based on levels, the sweetener added
+   * to the last one
+   */
+  price_t get_price_to_use(side_t const& side, instrument_t const& future,
+                           BBO_t const& bbo, double price_sweetener);
+
+  /**
+   * @returns the worst price an order can have based on levels, none
+   * without levels
+   */
+  optional<price_t> get_limit_price(side_t const& side,
+                                    instrument_t const& future,
+                                    double price_sweetener) const;
 
   /** @returns volume that should be used based on levels */
   volume_t get_volume_to_use(side_t const& side, volume_t corrections_todo);
@@ -35,16 +47,10 @@ class levels {
   // Load and stores the levels from/into a file
   void store_levels();
   void load_levels();
-  // Stores PNL in the PNL file
-  void store_pnl(price_t front_price, price_t report_price, side_t report_side,
-                 volume_t raw_paired_volume, instrument_t const& future);
 
   // Path to the auxiliar folder to store levels
   string m_aux_folder_path;
 
   // Storing information about the last buys and sells
   levels_t m_levels;
-
-  // Sweetener to add to the price when calculating price for order
-  double m_price_sweetener;
 };
@@ -0,0 +1,236 @@
+#include "strategy_host.h"
+
+#include <algorithm>
+
+namespace details {
+
+/**
+ * Removes a queue from a list of queues
+ */
+void remove_queue(vector<strategy_queue *> &queues,
+                  strategy_queue const *queue) {
+  queues.erase(std::remove(queues.begin(), queues.end(), queue), queues.end());
+}
+
+/**
+ * @returns a snapshot of the book of an instrument, for a strategy
+ * subscribing after the one of the session came
+ */
+market_update_t make_book_snapshot(symbol_t const &symbol, BBO_t const &bbo) {
+  market_update_t update;
+  update.symbol = symbol;
+  update.snapshot = true;
+  if (bbo.bid && bbo.bid_volume) {
+    update.updates.push_back({market_update_action_t::NEW, market_side_t::BID,
+                              *bbo.bid_volume, *bbo.bid});
+  }
+  if (bbo.ask && bbo.ask_volume) {
+    update.updates.push_back({market_update_action_t::NEW, market_side_t::ASK,
+                              *bbo.ask_volume, *bbo.ask});
+  }
+  return update;
+}
+
+}  // namespace details
+
+strategy_host::strategy_host(config_file_t &configuration)
+    : m_queues(),
+      m_subscribers(),
+      m_instrument_subscribers(),
+      m_instrument_list(),
+      m_mutex(),
+      m_instruments(config_file::get<string>(configuration, "AuxFolder", "")),
+      m_market_mutex(),
+      m_market(std::make_unique<FIX::quickfix>(configuration, *this)),
+      m_logged_on(false) {}
+
+strategy_host::~strategy_host() {
+  if (m_market) {
+    m_market->stop();
+  }
+
+  // Strategies are detached before anything they use is destroyed
+  m_queues.clear();
+}
+
+bool strategy_host::run() {
+  std::cout << "Running strategy host..." << std::endl;
+  return m_market->run();
+}
+
+strategy_queue &strategy_host::attach(FIX::quickfix_user &strategy,
+                                      thread_settings_t const &settings) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_queues.push_back(
+      std::make_unique<strategy_queue>(*this, strategy, settings));
+  return *m_queues.back();
+}
+
+void strategy_host::detach(strategy_queue &queue) {
+  std::unique_ptr<strategy_queue> detached;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto &subscribers : m_subscribers) {
+      details::remove_queue(subscribers.second, &queue);
+    }
+    details::remove_queue(m_instrument_subscribers, &queue);
+
+    auto const attached = std::find_if(
+        m_queues.begin(), m_queues.end(),
+        [&queue](std::unique_ptr<strategy_queue> const &candidate) {
+          return candidate.get() == &queue;
+        });
+    if (attached == m_queues.end()) {
+      return;
+    }
+    detached = std::move(*attached);
+    m_queues.erase(attached);
+  }
+
+  // Stopped out of the lock, its thread may be waiting for it
+  detached.reset();
+}
+
+void strategy_host::request_instrument_list(strategy_queue &queue) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (std::find(m_instrument_subscribers.begin(),
+                m_instrument_subscribers.end(),
+                &queue) == m_instrument_subscribers.end()) {
+    m_instrument_subscribers.push_back(&queue);
+  }
+
+  // The session requests the list on logon, the last one is already valid
+  if (m_instrument_list) {
+    auto const list = m_instrument_list;
+    queue.push(
+        [list](FIX::quickfix_user &strategy) { strategy.on_message(*list); });
+  }
+}
+
+void strategy_host::request_market_data(strategy_queue &queue,
+                                        vector<string> const &symbols) {
+  bool logged_on = false;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::shared_lock<std::shared_timed_mutex> market(m_market_mutex);
+    logged_on = m_logged_on;
+
+    for (auto const &symbol : symbols) {
+      auto &subscribers = m_subscribers[symbol_t(symbol)];
+      if (std::find(subscribers.begin(), subscribers.end(), &queue) !=
+          subscribers.end()) {
+        continue;
+      }
+      subscribers.push_back(&queue);
+
+      // Books already known are sent right away
+      auto const id = m_instruments.find(symbol_t(symbol));
+      if (id && market_data_state(symbol_t(symbol)) ==
+                    FIX::market_data_subscriptions::state_t::ACTIVE) {
+        auto const update = std::make_shared<market_update_t const>(
+            details::make_book_snapshot(symbol_t(symbol),
+                                        m_instruments.bbo(*id)));
+        queue.push([update](FIX::quickfix_user &strategy) {
+          strategy.on_message(*update);
+        });
+      }
+    }
+  }
+
+  // Requested again on logon otherwise. Sent without the market mutex, the
+  // session thread may be waiting for it with the session locked
+  if (logged_on) {
+    m_market->request_market_data(symbols);
+  }
+}
+
+optional<FIX::market_data_subscriptions::state_t>
+strategy_host::market_data_state(symbol_t const &symbol) const {
+  return m_market->market_data_state(symbol);
+}
+
+void strategy_host::on_logon() {
+  vector<string> symbols;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_logged_on = true;
+    for (auto const &subscribers : m_subscribers) {
+      if (!subscribers.second.empty()) {
+        symbols.push_back(subscribers.first.str());
+      }
+    }
+  }
+
+  m_market->request_instrument_list();
+  if (!symbols.empty()) {
+    m_market->request_market_data(symbols);
+  }
+}
+
+void strategy_host::on_logout() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_logged_on = false;
+}
+
+void strategy_host::on_message(
+    optional<instruments_list_t> const &instruments) {
+  if (!instruments) {
+    std::cerr << "No instruments where retrieved" << std::endl;
+    return;
+  }
+
+  // Only this thread changes the registry, strategies wait for it
+  {
+    std::unique_lock<std::shared_timed_mutex> market(m_market_mutex);
+    auto const diff = m_instruments.update(*instruments);
+    std::cout << "Instruments: " << diff.added << " added, " << diff.updated
+              << " updated, " << diff.removed << " removed" << std::endl;
+  }
+  m_instruments.store_snapshot();
+
+  // Copied once into the heap for every strategy
+  auto const list =
+      std::make_shared<optional<instruments_list_t> const>(instruments);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_instrument_list = list;
+  for (auto *queue : m_instrument_subscribers) {
+    queue->push(
+        [list](FIX::quickfix_user &strategy) { strategy.on_message(*list); });
+  }
+}
+
+void strategy_host::on_message(market_update_t const &update) {
+  // Single book for all the strategies
+  auto const id = m_instruments.find(update.symbol);
+  if (id) {
+    std::unique_lock<std::shared_timed_mutex> market(m_market_mutex);
+    m_instruments.bbo(*id) = get_bbo(update);
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto const subscribers = m_subscribers.find(update.symbol);
+  if (subscribers == m_subscribers.end() || subscribers->second.empty()) {
+    return;
+  }
+
+  // Copied once for every strategy
+  auto const shared_update = std::make_shared<market_update_t const>(update);
+  for (auto *queue : subscribers->second) {
+    queue->push([shared_update](FIX::quickfix_user &strategy) {
+      strategy.on_message(*shared_update);
+    });
+  }
+}
+
+void strategy_host::on_subscription_rejected(symbol_t const &symbol,
+                                             string const &reason) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto const subscribers = m_subscribers.find(symbol);
+  if (subscribers == m_subscribers.end()) {
+    return;
+  }
+  for (auto *queue : subscribers->second) {
+    queue->on_subscription_rejected(symbol, reason);
+  }
+}
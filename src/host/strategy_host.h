@@ -0,0 +1,95 @@
+#pragma once
+
+#include "../config.h"
+
+#include "../instruments/instrument_registry.h"
+#include "../quickfix/quickfix.h"
+
+#include "strategy_queue.h"
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+/**
+ * Runs several strategies in one process over a single market data session.
+ *
+ * The host owns the market data session, the instrument registry and the
+ * books, and fans out the instrument lists and market updates to the
+ * strategies that asked for them. Each strategy keeps its own order session
+ * and account, and receives every callback through its own queue (see
+ * strategy_queue)
+ */
+class strategy_host : public FIX::quickfix_user {
+ public:
+  /** Constructor. The configuration is the one of the market data session */
+  strategy_host(config_file_t &configuration);
+
+  /** Destructor */
+  ~strategy_host();
+
+  /** Starts the market data session */
+  bool run();
+
+  /**
+   * Attaches a strategy to the host, its callbacks are delivered from a thread
+   * with the given settings
+   * @returns the queue delivering its callbacks, also its market data source
+   */
+  strategy_queue &attach(FIX::quickfix_user &strategy,
+                         thread_settings_t const &settings);
+
+  /** Detaches a strategy, its pending callbacks are dropped */
+  void detach(strategy_queue &queue);
+
+  /** @returns the instruments and books shared by the strategies */
+  instrument_registry &instruments() { return m_instruments; }
+
+  /**
+   * @returns the mutex guarding the instruments and books. Strategies hold it
+   * shared while processing a callback
+   */
+  std::shared_timed_mutex &market_mutex() { return m_market_mutex; }
+
+  /**
+   * Requests made by the strategies through their queues, never while
+   * holding the market mutex: market data is requested on the session
+   */
+  void request_instrument_list(strategy_queue &queue);
+  void request_market_data(strategy_queue &queue,
+                           vector<string> const &symbols);
+  optional<FIX::market_data_subscriptions::state_t> market_data_state(
+      symbol_t const &symbol) const;
+
+  /** Implementing quickfix_user interface for the market data session */
+  void on_logon() override;
+  void on_logout() override;
+  void on_message(optional<instruments_list_t> const &instruments) override;
+  void on_message(market_update_t const &update) override;
+  void on_subscription_rejected(symbol_t const &symbol,
+                                string const &reason) override;
+
+ private:
+  // Strategies attached
+  std::list<std::unique_ptr<strategy_queue>> m_queues;
+
+  // Strategies subscribed to each symbol and to the instrument lists
+  std::unordered_map<symbol_t, vector<strategy_queue *>> m_subscribers;
+  vector<strategy_queue *> m_instrument_subscribers;
+
+  // Last instrument list, for strategies attached after it came
+  std::shared_ptr<optional<instruments_list_t> const> m_instrument_list;
+
+  // Guards the strategies attached, their requests and the session state
+  mutable std::mutex m_mutex;
+
+  // Instruments and books shared by the strategies
+  instrument_registry m_instruments;
+  std::shared_timed_mutex m_market_mutex;
+
+  // Market data session
+  std::unique_ptr<FIX::quickfix> m_market;
+  bool m_logged_on;
+};
@@ -0,0 +1,172 @@
+#include "strategy_queue.h"
+
+#include "strategy_host.h"
+
+#include <shared_mutex>
+
+strategy_queue::strategy_queue(strategy_host &host,
+                               FIX::quickfix_user &strategy,
+                               thread_settings_t const &settings)
+    : m_host(host),
+      m_strategy(strategy),
+      m_mutex(),
+      m_condition_variable(),
+      m_callbacks(),
+      m_running(true),
+      m_requested_symbols(),
+      m_worker() {
+  m_worker = std::thread(&strategy_queue::process, this, settings);
+}
+
+strategy_queue::~strategy_queue() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_running = false;
+  }
+  m_condition_variable.notify_all();
+  m_worker.join();
+}
+
+void strategy_queue::push(
+    std::function<void(FIX::quickfix_user &)> callback) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_running) {
+      return;
+    }
+    m_callbacks.push_back(std::move(callback));
+  }
+  m_condition_variable.notify_one();
+}
+
+size_t strategy_queue::depth() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_callbacks.size();
+}
+
+void strategy_queue::on_logon() {
+  push([](FIX::quickfix_user &strategy) { strategy.on_logon(); });
+}
+
+void strategy_queue::on_logout() {
+  push([](FIX::quickfix_user &strategy) { strategy.on_logout(); });
+}
+
+void strategy_queue::on_mass_status_report(int const report_number) {
+  push([report_number](FIX::quickfix_user &strategy) {
+    strategy.on_mass_status_report(report_number);
+  });
+}
+
+// Lists decoded in an arena are copied into the heap to outlive the callback
+void strategy_queue::on_message(optional<positions_list_t> const &positions) {
+  push([positions](FIX::quickfix_user &strategy) {
+    strategy.on_message(positions);
+  });
+}
+
+void strategy_queue::on_message(
+    optional<instruments_list_t> const &instruments) {
+  push([instruments](FIX::quickfix_user &strategy) {
+    strategy.on_message(instruments);
+  });
+}
+
+void strategy_queue::on_message(execution_report_t &report) {
+  push([report](FIX::quickfix_user &strategy) mutable {
+    strategy.on_message(report);
+  });
+}
+
+void strategy_queue::on_message(market_update_t const &update) {
+  push([update](FIX::quickfix_user &strategy) {
+    strategy.on_message(update);
+  });
+}
+
+void strategy_queue::on_message(mass_cancel_report_t const &report) {
+  push([report](FIX::quickfix_user &strategy) {
+    strategy.on_message(report);
+  });
+}
+
+void strategy_queue::on_message(order_cancel_reject_t const &report) {
+  push([report](FIX::quickfix_user &strategy) {
+    strategy.on_message(report);
+  });
+}
+
+void strategy_queue::on_message(string const &message) {
+  push([message](FIX::quickfix_user &strategy) {
+    strategy.on_message(message);
+  });
+}
+
+void strategy_queue::on_subscription_rejected(symbol_t const &symbol,
+                                              string const &reason) {
+  push([symbol, reason](FIX::quickfix_user &strategy) {
+    strategy.on_subscription_rejected(symbol, reason);
+  });
+}
+
+void strategy_queue::request_instrument_list() {
+  m_host.request_instrument_list(*this);
+}
+
+void strategy_queue::request_market_data(vector<string> const &symbols) {
+  // From a callback, the market mutex is held
+  if (std::this_thread::get_id() == m_worker.get_id()) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_requested_symbols.insert(m_requested_symbols.end(), symbols.begin(),
+                               symbols.end());
+    return;
+  }
+  m_host.request_market_data(*this, symbols);
+}
+
+optional<FIX::market_data_subscriptions::state_t>
+strategy_queue::market_data_state(symbol_t const &symbol) const {
+  return m_host.market_data_state(symbol);
+}
+
+void strategy_queue::process(thread_settings_t const settings) {
+  threads::apply_thread_settings(settings);
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true) {
+    m_condition_variable.wait(
+        lock, [this]() { return !m_running || !m_callbacks.empty(); });
+    if (!m_running) {
+      return;
+    }
+
+    auto callback = std::move(m_callbacks.front());
+    m_callbacks.pop_front();
+    lock.unlock();
+
+    // The shared instruments and books don't change during the callback
+    try {
+      std::shared_lock<std::shared_timed_mutex> market(m_host.market_mutex());
+      callback(m_strategy);
+    } catch (std::exception const &exception) {
+      // As its own session would do, the strategy is disconnected
+      std::cerr << "Strategy stopped: " << exception.what() << std::endl;
+      std::shared_lock<std::shared_timed_mutex> market(m_host.market_mutex());
+      m_strategy.on_logout();
+    }
+    forward_requests();
+
+    lock.lock();
+  }
+}
+
+void strategy_queue::forward_requests() {
+  vector<string> symbols;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    symbols.swap(m_requested_symbols);
+  }
+  if (!symbols.empty()) {
+    m_host.request_market_data(*this, symbols);
+  }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "../config.h"
+#include "../quickfix/market_data_source.h"
+#include "../quickfix/quickfix_user.h"
+#include "../threads/thread_settings.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+class strategy_host;
+
+/**
+ * Queue of the callbacks of a strategy run by a host.
+ *
+ * Everything the strategy receives, from its own order session or from the
+ * market data shared by the host, is queued and delivered by a single thread,
+ * so the strategy never sees two callbacks at the same time. While a callback
+ * runs the host doesn't change the instruments nor the books it shares.
+ *
+ * It's also the market data source of the strategy, forwarding its requests
+ * to the host. The ones made during a callback are forwarded once it
+ * returned: the host sends them on the market data session, whose thread may
+ * be waiting for the market mutex the callback holds
+ */
+class strategy_queue : public FIX::quickfix_user,
+                       public FIX::market_data_source {
+ public:
+  /**
+   * Constructor. Starts delivering callbacks from a thread with the given
+   * settings
+   */
+  strategy_queue(strategy_host &host, FIX::quickfix_user &strategy,
+                 thread_settings_t const &settings);
+
+  /** Destructor. Stops delivering, pending callbacks are dropped */
+  ~strategy_queue();
+
+  strategy_queue(strategy_queue const &) = delete;
+  strategy_queue &operator=(strategy_queue const &) = delete;
+
+  /** Queues a callback of the strategy */
+  void push(std::function<void(FIX::quickfix_user &)> callback);
+
+  /** @returns the callbacks waiting to be delivered */
+  size_t depth() const;
+
+  /** Implementing quickfix_user interface. Everything is queued */
+  void on_logon() override;
+  void on_logout() override;
+  void on_mass_status_report(int const report_number) override;
+  void on_message(optional<positions_list_t> const &positions) override;
+  void on_message(optional<instruments_list_t> const &instruments) override;
+  void on_message(execution_report_t &report) override;
+  void on_message(market_update_t const &update) override;
+  void on_message(mass_cancel_report_t const &report) override;
+  void on_message(order_cancel_reject_t const &report) override;
+  void on_message(string const &message) override;
+  void on_subscription_rejected(symbol_t const &symbol,
+                                string const &reason) override;
+
+  /** Implementing market_data_source interface. Forwarded to the host */
+  void request_instrument_list() override;
+  void request_market_data(vector<string> const &symbols) override;
+  optional<FIX::market_data_subscriptions::state_t> market_data_state(
+      symbol_t const &symbol) const override;
+
+ private:
+  // Delivers the callbacks until stopped
+  void process(thread_settings_t const settings);
+
+  // Forwards to the host the market data requested during a callback
+  void forward_requests();
+
+  // Host running the strategy
+  strategy_host &m_host;
+
+  // Strategy receiving the callbacks
+  FIX::quickfix_user &m_strategy;
+
+  // Callbacks waiting to be delivered
+  mutable std::mutex m_mutex;
+  std::condition_variable m_condition_variable;
+  std::deque<std::function<void(FIX::quickfix_user &)>> m_callbacks;
+  bool m_running;
+
+  // Symbols requested during the callback being delivered
+  vector<string> m_requested_symbols;
+
+  // Thread delivering the callbacks
+  std::thread m_worker;
+};
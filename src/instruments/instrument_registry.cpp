@@ -0,0 +1,345 @@
+#include "instrument_registry.h"
+
+#include <boost/functional/hash.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace details {
+
+string const instruments_snapshot_file = "instruments";
+
+// Snapshot layout: magic, version, count and then one record per instrument
+char const snapshot_magic[8] = {'D', 'R', 'B', 'T', 'I', 'N', 'S', 'T'};
+uint32_t const snapshot_version = 1;
+
+// Records store the presence bits of instrument_t plus the active flag
+uint8_t const active_bit = 1 << 7;
+static_assert(instrument_t::TICK_SIZE < active_bit,
+              "Presence bits of instrument_t overlap the active flag");
+
+ptime const snapshot_epoch(boost::gregorian::date(1970, 1, 1));
+int64_t const not_a_date = std::numeric_limits<int64_t>::min();
+
+template <typename T>
+void write_raw(std::ofstream &file, T const &value) {
+  file.write(reinterpret_cast<char const *>(&value), sizeof(T));
+}
+
+void write_string(std::ofstream &file, char const *data, size_t size) {
+  write_raw(file, static_cast<uint16_t>(size));
+  file.write(data, size);
+}
+
+void write_string(std::ofstream &file, string const &value) {
+  write_string(file, value.data(), value.size());
+}
+
+/**
+ * Reads values from a mapped snapshot, checking it never goes past the end
+ */
+class snapshot_reader {
+ public:
+  snapshot_reader(char const *begin, size_t size)
+      : m_current(begin), m_end(begin + size) {}
+
+  template <typename T>
+  T read() {
+    T value;
+    std::memcpy(&value, consume(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  string read_string() {
+    auto const size = read<uint16_t>();
+    return string(consume(size), size);
+  }
+
+ private:
+  char const *consume(size_t bytes) {
+    if (static_cast<size_t>(m_end - m_current) < bytes) {
+      BOOST_THROW_EXCEPTION(
+          std::runtime_error("Instruments snapshot is truncated"));
+    }
+    auto const to_return = m_current;
+    m_current += bytes;
+    return to_return;
+  }
+
+  char const *m_current;
+  char const *m_end;
+};
+
+/**
+ * @returns true if both instruments have the same contract specification
+ */
+bool same_specification(instrument_t const &a, instrument_t const &b) {
+  return a.symbol == b.symbol && a.present == b.present &&
+         a.description == b.description && a.type == b.type &&
+         a.main_currency == b.main_currency &&
+         (!a.has(instrument_t::CONTRACT_MULTIPLIER) ||
+          a.contract_multiplier == b.contract_multiplier) &&
+         (!a.has(instrument_t::PUT_CALL) || a.put_call == b.put_call) &&
+         (!a.has(instrument_t::STRIKE_PRICE) ||
+          a.strike_price == b.strike_price) &&
+         (!a.has(instrument_t::STRIKE_CURRENCY) ||
+          a.strike_currency == b.strike_currency) &&
+         (!a.has(instrument_t::MATURITY_DATE) ||
+          a.maturity_date == b.maturity_date) &&
+         (!a.has(instrument_t::MIN_TRADE_VOLUME) ||
+          a.min_trade_volume == b.min_trade_volume) &&
+         (!a.has(instrument_t::TICK_SIZE) || a.tick_size == b.tick_size);
+}
+
+/**
+ * @returns the option key of an instrument if it's an option
+ */
+optional<option_key_t> get_option_key(instrument_t const &instrument) {
+  auto const fields = instrument_t::PUT_CALL | instrument_t::STRIKE_PRICE |
+                      instrument_t::MATURITY_DATE;
+  if ((instrument.present & fields) != fields) {
+    return boost::none;
+  }
+  return option_key_t{instrument.main_currency, instrument.maturity_date,
+                      instrument.strike_price, instrument.put_call};
+}
+
+}  // namespace details
+
+size_t option_key_hash::operator()(option_key_t const &key) const {
+  size_t seed = 0;
+  boost::hash_combine(seed, key.main_currency.t);
+  boost::hash_combine(seed, key.maturity_date.is_special()
+                                ? details::not_a_date
+                                : (key.maturity_date - details::snapshot_epoch)
+                                      .total_seconds());
+  boost::hash_combine(seed, static_cast<double>(key.strike_price));
+  boost::hash_combine(seed, static_cast<int>(key.put_call));
+  return seed;
+}
+
+instrument_registry::instrument_registry(string aux_folder_path)
+    : m_snapshot_path(aux_folder_path + details::instruments_snapshot_file),
+      m_instruments(),
+      m_active(),
+      m_bbos(),
+      m_by_symbol(),
+      m_by_option_key() {
+  try {
+    load_snapshot();
+  } catch (std::exception const &exception) {
+    // A broken snapshot only costs a cold start, never the strategy
+    std::cerr << "Ignoring instruments snapshot: " << exception.what()
+              << std::endl;
+    m_instruments.clear();
+    m_active.clear();
+    m_bbos.clear();
+    m_by_symbol.clear();
+    m_by_option_key.clear();
+  }
+}
+
+instrument_registry::diff_t instrument_registry::update(
+    instruments_list_t const &instruments) {
+  diff_t diff{0, 0, 0};
+  vector<bool> listed(m_instruments.size(), false);
+
+  for (auto const &instrument : instruments) {
+    auto const known = m_by_symbol.find(instrument.symbol);
+    if (known == m_by_symbol.end()) {
+      // Never seen before, hand out a new identifier
+      auto const id = static_cast<instrument_id_t>(m_instruments.size());
+      m_instruments.push_back(instrument);
+      m_active.push_back(true);
+      m_bbos.emplace_back();
+      listed.push_back(true);
+      index(id);
+      ++diff.added;
+      continue;
+    }
+
+    auto const id = known->second;
+    listed[id] = true;
+    auto &stored = m_instruments[id];
+    if (m_active[id] && details::same_specification(stored, instrument)) {
+      continue;
+    }
+
+    // Specification changed or instrument is back. Market data is kept apart,
+    // so it survives
+    unindex(id);
+    stored = instrument;
+    index(id);
+    if (m_active[id]) {
+      ++diff.updated;
+    } else {
+      m_active[id] = true;
+      ++diff.added;
+    }
+  }
+
+  // Whatever is not in the list anymore is not tradeable
+  for (instrument_id_t id = 0; id < m_instruments.size(); ++id) {
+    if (m_active[id] && !listed[id]) {
+      unindex(id);
+      m_active[id] = false;
+      ++diff.removed;
+    }
+  }
+
+  return diff;
+}
+
+void instrument_registry::store_snapshot() const {
+  // Write in a temporary file and swap it, a crash never leaves half snapshot
+  auto const temporary_path = m_snapshot_path + ".tmp";
+  std::ofstream file;
+  file.open(temporary_path, std::ios::out | std::ios::binary);
+  if (!file) {
+    std::cerr << "Impossible to store the instruments snapshot in "
+              << m_snapshot_path << std::endl;
+    return;
+  }
+
+  file.write(details::snapshot_magic, sizeof(details::snapshot_magic));
+  details::write_raw(file, details::snapshot_version);
+  details::write_raw(file, static_cast<uint32_t>(m_instruments.size()));
+
+  for (instrument_id_t id = 0; id < m_instruments.size(); ++id) {
+    auto const &instrument = m_instruments[id];
+
+    details::write_raw(
+        file, static_cast<uint8_t>(instrument.present |
+                                   (m_active[id] ? details::active_bit : 0)));
+
+    details::write_string(file, instrument.symbol.str());
+    details::write_string(file, instrument.description.data(),
+                          instrument.description.size());
+    details::write_string(file, instrument.type.str());
+    details::write_string(file, instrument.main_currency);
+
+    // Missing fields are stored with their default value
+    details::write_raw(file, instrument.contract_multiplier);
+    details::write_raw(file, static_cast<int8_t>(instrument.put_call));
+    details::write_raw(file, static_cast<double>(instrument.strike_price));
+    details::write_string(file, instrument.strike_currency);
+    auto const &maturity = instrument.maturity_date;
+    details::write_raw(
+        file, maturity.is_special()
+                  ? details::not_a_date
+                  : (maturity - details::snapshot_epoch).total_microseconds());
+    details::write_raw(file, static_cast<double>(instrument.min_trade_volume));
+    details::write_raw(file, instrument.tick_size);
+  }
+
+  file.close();
+  if (!file || std::rename(temporary_path.c_str(), m_snapshot_path.c_str())) {
+    std::cerr << "Impossible to store the instruments snapshot in "
+              << m_snapshot_path << std::endl;
+  }
+}
+
+optional<instrument_id_t> instrument_registry::find(
+    symbol_t const &symbol) const {
+  auto const it = m_by_symbol.find(symbol);
+  if (it == m_by_symbol.end() || !m_active[it->second]) {
+    return boost::none;
+  }
+  return it->second;
+}
+
+optional<instrument_id_t> instrument_registry::find_option(
+    option_key_t const &key) const {
+  auto const it = m_by_option_key.find(key);
+  if (it == m_by_option_key.end()) {
+    return boost::none;
+  }
+  return it->second;
+}
+
+void instrument_registry::load_snapshot() {
+  using namespace boost::interprocess;
+
+  // First run, nothing to load
+  if (!std::ifstream(m_snapshot_path)) {
+    return;
+  }
+
+  file_mapping mapping(m_snapshot_path.c_str(), read_only);
+  mapped_region region(mapping, read_only);
+  details::snapshot_reader reader(
+      static_cast<char const *>(region.get_address()), region.get_size());
+
+  char magic[sizeof(details::snapshot_magic)];
+  for (auto &character : magic) {
+    character = reader.read<char>();
+  }
+  if (std::memcmp(magic, details::snapshot_magic, sizeof(magic)) != 0 ||
+      reader.read<uint32_t>() != details::snapshot_version) {
+    BOOST_THROW_EXCEPTION(
+        std::runtime_error("Instruments snapshot has an unknown format"));
+  }
+
+  auto const count = reader.read<uint32_t>();
+  m_instruments.reserve(count);
+  m_active.reserve(count);
+  m_bbos.reserve(count);
+  m_by_symbol.reserve(count);
+
+  for (uint32_t record = 0; record < count; ++record) {
+    auto const presence = reader.read<uint8_t>();
+    instrument_t instrument;
+
+    instrument.symbol = reader.read_string();
+    auto const description = reader.read_string();
+    instrument.description.assign(description.data(), description.size());
+    instrument.type = reader.read_string();
+    instrument.main_currency = static_cast<currency>(reader.read_string());
+
+    instrument.contract_multiplier = reader.read<double>();
+    instrument.put_call = static_cast<option_type_t>(reader.read<int8_t>());
+    instrument.strike_price = static_cast<price_t>(reader.read<double>());
+    instrument.strike_currency = static_cast<currency>(reader.read_string());
+    auto const maturity = reader.read<int64_t>();
+    instrument.maturity_date =
+        maturity == details::not_a_date
+            ? ptime()
+            : details::snapshot_epoch + microseconds(maturity);
+    instrument.min_trade_volume = static_cast<volume_t>(reader.read<double>());
+    instrument.tick_size = reader.read<double>();
+    instrument.present = presence & ~details::active_bit;
+
+    auto const id = static_cast<instrument_id_t>(m_instruments.size());
+    m_instruments.push_back(std::move(instrument));
+    m_active.push_back((presence & details::active_bit) != 0);
+    m_bbos.emplace_back();
+    m_by_symbol[m_instruments[id].symbol] = id;
+    if (m_active[id]) {
+      index(id);
+    }
+  }
+}
+
+void instrument_registry::index(instrument_id_t id) {
+  auto const &instrument = m_instruments[id];
+  m_by_symbol[instrument.symbol] = id;
+
+  auto const key = details::get_option_key(instrument);
+  if (key) {
+    m_by_option_key[*key] = id;
+  }
+}
+
+void instrument_registry::unindex(instrument_id_t id) {
+  auto const &instrument = m_instruments[id];
+
+  // Symbols keep their identifier, only the specification index is dropped
+  auto const key = details::get_option_key(instrument);
+  if (key) {
+    m_by_option_key.erase(*key);
+  }
+}
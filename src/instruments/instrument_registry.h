@@ -0,0 +1,103 @@
+#pragma once
+
+#include "../config.h"
+
+#include <cstdint>
+#include <unordered_map>
+
+// Stable identifier of an instrument inside the registry
+using instrument_id_t = uint32_t;
+instrument_id_t const no_instrument_id = ~instrument_id_t(0);
+
+/**
+ * Contract specification that identifies an option inside a currency
+ */
+struct option_key_t {
+  currency main_currency;
+  ptime maturity_date;
+  price_t strike_price;
+  option_type_t put_call;
+
+  bool operator==(option_key_t const &other) const {
+    return main_currency == other.main_currency &&
+           maturity_date == other.maturity_date &&
+           strike_price == other.strike_price && put_call == other.put_call;
+  }
+};
+
+struct option_key_hash {
+  size_t operator()(option_key_t const &key) const;
+};
+
+/**
+ * Keeps every instrument known by the exchange under a stable identifier.
+ *
+ * The registry is persisted in a binary snapshot so the next start can resolve
+ * instruments straight away. Incoming security lists are applied as a diff
+ * against what is already known: identifiers never change for a symbol and
+ * instruments missing from the list are deactivated instead of removed.
+ * Market data lives in its own dense array by identifier, away from the
+ * specifications.
+ */
+class instrument_registry {
+ public:
+  /** Result of applying a security list to the registry */
+  struct diff_t {
+    size_t added;
+    size_t updated;
+    size_t removed;
+  };
+
+  /** Constructor. Loads the snapshot stored in the auxiliar folder */
+  instrument_registry(string aux_folder_path);
+
+  /** Applies a fresh instrument list as a diff against the registry */
+  diff_t update(instruments_list_t const &instruments);
+
+  /** Stores the registry in the snapshot file */
+  void store_snapshot() const;
+
+  /** @returns the identifier of the active instrument with that symbol */
+  optional<instrument_id_t> find(symbol_t const &symbol) const;
+
+  /** @returns the identifier of the active option with that specification */
+  optional<instrument_id_t> find_option(option_key_t const &key) const;
+
+  /** @returns the instrument stored under the given identifier */
+  instrument_t const &get(instrument_id_t id) const {
+    return m_instruments[id];
+  }
+
+  /** @returns the last best bid and offer of an instrument */
+  BBO_t const &bbo(instrument_id_t id) const { return m_bbos[id]; }
+  BBO_t &bbo(instrument_id_t id) { return m_bbos[id]; }
+
+  /** @returns false if the instrument was not in the last security list */
+  bool is_active(instrument_id_t id) const { return m_active[id]; }
+
+  /** @returns the number of identifiers handed out, active or not */
+  size_t size() const { return m_instruments.size(); }
+
+ private:
+  // Loads the registry from the snapshot file (memory mapped)
+  void load_snapshot();
+
+  // Adds or refreshes the indexes for an instrument
+  void index(instrument_id_t id);
+  void unindex(instrument_id_t id);
+
+  // Path to the snapshot file
+  string m_snapshot_path;
+
+  // Instruments by identifier
+  vector<instrument_t> m_instruments;
+  vector<bool> m_active;
+
+  // Market data by identifier
+  vector<BBO_t> m_bbos;
+
+  // Every symbol ever seen and the options that are still active
+  std::unordered_map<symbol_t, instrument_id_t> m_by_symbol;
+  std::unordered_map<option_key_t, instrument_id_t, option_key_hash>
+      m_by_option_key;
+};
@@ -0,0 +1,248 @@
+#include "option_chain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+
+namespace details {
+
+double const no_value = std::numeric_limits<double>::quiet_NaN();
+
+// Both legs of a strike while the chain is being built
+struct strike_legs_t {
+  instrument_id_t call = no_instrument_id;
+  instrument_id_t put = no_instrument_id;
+};
+
+/**
+ * @returns the index of the sorted element closest to the target
+ */
+template <typename T, typename Distance>
+optional<size_t> nearest_index(vector<T> const &sorted, T const &target,
+                               Distance distance) {
+  if (sorted.empty()) {
+    return boost::none;
+  }
+
+  auto const upper = std::lower_bound(sorted.begin(), sorted.end(), target);
+  if (upper == sorted.begin()) {
+    return size_t(0);
+  }
+  if (upper == sorted.end()) {
+    return sorted.size() - 1;
+  }
+
+  auto const lower = upper - 1;
+  auto const index = static_cast<size_t>(lower - sorted.begin());
+  return distance(*lower, target) <= distance(*upper, target) ? index
+                                                              : index + 1;
+}
+
+}  // namespace details
+
+void option_chain::leg_t::resize(size_t size) {
+  instrument.assign(size, no_instrument_id);
+  bid.assign(size, details::no_value);
+  ask.assign(size, details::no_value);
+  implied_volatility.assign(size, details::no_value);
+  delta.assign(size, details::no_value);
+  gamma.assign(size, details::no_value);
+}
+
+option_chain::option_chain(instrument_registry const &instruments)
+    : m_instruments(instruments),
+      m_expiries(),
+      m_maturities(),
+      m_futures(),
+      m_perpetual(no_instrument_id),
+      m_locations() {}
+
+void option_chain::rebuild(currency const &main_currency) {
+  // Quotes and greeks of the options still listed survive the rebuild
+  auto previous_expiries = std::move(m_expiries);
+  auto const previous_locations = std::move(m_locations);
+
+  m_expiries.clear();
+  m_maturities.clear();
+  m_futures.clear();
+  m_perpetual = no_instrument_id;
+  m_locations.clear();
+
+  // Grouping the options by maturity and strike
+  std::map<ptime, std::map<double, details::strike_legs_t>> options;
+
+  for (instrument_id_t id = 0; id < m_instruments.size(); ++id) {
+    auto const &instrument = m_instruments.get(id);
+    if (!m_instruments.is_active(id) ||
+        instrument.main_currency != main_currency) {
+      continue;
+    }
+
+    if (instrument.type != "OPT") {
+      if (instrument.symbol.str().find("PERPETUAL") != string::npos) {
+        m_perpetual = id;
+      } else if (instrument.has(instrument_t::MATURITY_DATE)) {
+        m_futures.emplace_back(instrument.maturity_date, id);
+      }
+      continue;
+    }
+
+    auto const fields = instrument_t::PUT_CALL | instrument_t::STRIKE_PRICE |
+                        instrument_t::MATURITY_DATE;
+    if ((instrument.present & fields) != fields) {
+      continue;
+    }
+
+    auto &legs = options[instrument.maturity_date][instrument.strike_price];
+    if (instrument.put_call == option_type_t::CALL) {
+      legs.call = id;
+    } else {
+      legs.put = id;
+    }
+  }
+  std::sort(m_futures.begin(), m_futures.end());
+
+  // Flattening into the structure of arrays
+  m_expiries.reserve(options.size());
+  m_maturities.reserve(options.size());
+  for (auto const &maturity : options) {
+    m_expiries.emplace_back();
+    auto &expiry = m_expiries.back();
+    auto const expiry_index = m_expiries.size() - 1;
+
+    expiry.maturity_date = maturity.first;
+    m_maturities.push_back(maturity.first);
+    expiry.future = find_future(maturity.first).value_or(no_instrument_id);
+    expiry.strikes.reserve(maturity.second.size());
+    expiry.calls.resize(maturity.second.size());
+    expiry.puts.resize(maturity.second.size());
+
+    for (auto const &strike : maturity.second) {
+      auto const strike_index = expiry.strikes.size();
+      expiry.strikes.push_back(strike.first);
+      expiry.calls.instrument[strike_index] = strike.second.call;
+      expiry.puts.instrument[strike_index] = strike.second.put;
+
+      if (strike.second.call != no_instrument_id) {
+        m_locations[strike.second.call] = {expiry_index, strike_index,
+                                           option_type_t::CALL};
+      }
+      if (strike.second.put != no_instrument_id) {
+        m_locations[strike.second.put] = {expiry_index, strike_index,
+                                          option_type_t::PUT};
+      }
+    }
+  }
+
+  for (auto const &location : m_locations) {
+    auto const previous = previous_locations.find(location.first);
+    if (previous == previous_locations.end()) {
+      continue;
+    }
+    auto const &from = leg(previous_expiries[previous->second.expiry],
+                           previous->second.put_call);
+    auto &to =
+        leg(m_expiries[location.second.expiry], location.second.put_call);
+    auto const source = previous->second.strike;
+    auto const target = location.second.strike;
+    to.bid[target] = from.bid[source];
+    to.ask[target] = from.ask[source];
+    to.implied_volatility[target] = from.implied_volatility[source];
+    to.delta[target] = from.delta[source];
+    to.gamma[target] = from.gamma[source];
+  }
+}
+
+optional<size_t> option_chain::nearest_expiry(ptime const &date) const {
+  return details::nearest_index(
+      m_maturities, date, [](ptime const &a, ptime const &b) {
+        return a < b ? (b - a).total_seconds() : (a - b).total_seconds();
+      });
+}
+
+optional<size_t> option_chain::nearest_strike(size_t expiry,
+                                              double price) const {
+  if (expiry >= m_expiries.size()) {
+    return boost::none;
+  }
+  return details::nearest_index(
+      m_expiries[expiry].strikes, price,
+      [](double a, double b) { return std::abs(a - b); });
+}
+
+optional<std::pair<instrument_id_t, instrument_id_t>>
+option_chain::nearest_atm_straddle(ptime const &maturity_date,
+                                   double underlying_price) const {
+  auto const expiry_index = nearest_expiry(maturity_date);
+  if (!expiry_index) {
+    return boost::none;
+  }
+  auto const &expiry = m_expiries[*expiry_index];
+  auto const strike = nearest_strike(*expiry_index, underlying_price);
+  if (!strike) {
+    return boost::none;
+  }
+
+  // Walking away from the money until both legs are listed
+  auto const size = expiry.strikes.size();
+  for (size_t offset = 0; offset < size; ++offset) {
+    for (auto const index : {*strike + offset, *strike - offset}) {
+      if (index >= size) {
+        continue;
+      }
+      auto const call = expiry.calls.instrument[index];
+      auto const put = expiry.puts.instrument[index];
+      if (call != no_instrument_id && put != no_instrument_id) {
+        return std::make_pair(call, put);
+      }
+    }
+  }
+  return boost::none;
+}
+
+optional<instrument_id_t> option_chain::find_future(
+    ptime const &maturity_date) const {
+  auto const it = std::lower_bound(
+      m_futures.begin(), m_futures.end(),
+      std::make_pair(maturity_date, instrument_id_t(0)));
+  if (it == m_futures.end() || it->first != maturity_date) {
+    return boost::none;
+  }
+  return it->second;
+}
+
+optional<instrument_id_t> option_chain::perpetual() const {
+  if (m_perpetual == no_instrument_id) {
+    return boost::none;
+  }
+  return m_perpetual;
+}
+
+optional<option_chain::location_t> option_chain::locate(
+    instrument_id_t id) const {
+  auto const it = m_locations.find(id);
+  if (it == m_locations.end()) {
+    return boost::none;
+  }
+  return it->second;
+}
+
+bool option_chain::update_bbo(instrument_id_t id, BBO_t const &bbo) {
+  auto const location = locate(id);
+  if (!location) {
+    return false;
+  }
+
+  auto &slots = leg(m_expiries[location->expiry], location->put_call);
+  slots.bid[location->strike] =
+      bbo.bid ? static_cast<double>(*bbo.bid) : details::no_value;
+  slots.ask[location->strike] =
+      bbo.ask ? static_cast<double>(*bbo.ask) : details::no_value;
+  return true;
+}
+
+option_chain::leg_t &option_chain::leg(expiry_t &expiry,
+                                       option_type_t put_call) {
+  return put_call == option_type_t::CALL ? expiry.calls : expiry.puts;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "instrument_registry.h"
+
+#include <unordered_map>
+
+/**
+ * Structured view over the options and futures of a currency.
+ *
+ * Maturities are kept sorted and every maturity stores its strikes sorted in
+ * a structure of arrays, with the instruments of both legs and a cache slot
+ * for their market data and greeks. Navigation is done with binary searches,
+ * so nearest strike and nearest maturity cost O(log n).
+ */
+class option_chain {
+ public:
+  /** One side (calls or puts) of a maturity. One slot per strike */
+  struct leg_t {
+    vector<instrument_id_t> instrument;
+    vector<double> bid;
+    vector<double> ask;
+    vector<double> implied_volatility;
+    vector<double> delta;
+    vector<double> gamma;
+
+    void resize(size_t size);
+  };
+
+  /** Options of a single maturity */
+  struct expiry_t {
+    ptime maturity_date;
+    instrument_id_t future;
+    vector<double> strikes;
+    leg_t calls;
+    leg_t puts;
+  };
+
+  /** Location of an option inside the chain */
+  struct location_t {
+    size_t expiry;
+    size_t strike;
+    option_type_t put_call;
+  };
+
+  /** Constructor */
+  option_chain(instrument_registry const &instruments);
+
+  /** Rebuilds the chain for the currency from the active instruments */
+  void rebuild(currency const &main_currency);
+
+  /** @returns the maturities sorted, with their strikes */
+  vector<expiry_t> const &expiries() const { return m_expiries; }
+  vector<expiry_t> &expiries() { return m_expiries; }
+
+  /** @returns the index of the maturity closest to the given date */
+  optional<size_t> nearest_expiry(ptime const &date) const;
+
+  /** @returns the index of the strike closest to the price in a maturity */
+  optional<size_t> nearest_strike(size_t expiry, double price) const;
+
+  /** @returns call and put of the listed straddle closest to the money */
+  optional<std::pair<instrument_id_t, instrument_id_t>> nearest_atm_straddle(
+      ptime const &maturity_date, double underlying_price) const;
+
+  /** @returns the future that expires at the given date */
+  optional<instrument_id_t> find_future(ptime const &maturity_date) const;
+
+  /** @returns the perpetual of the currency */
+  optional<instrument_id_t> perpetual() const;
+
+  /** @returns where an option is inside the chain */
+  optional<location_t> locate(instrument_id_t id) const;
+
+  /** Stores the BBO of an option in its cache slot. @returns false if the
+   * instrument is not part of the chain */
+  bool update_bbo(instrument_id_t id, BBO_t const &bbo);
+
+ private:
+  // Leg to use for an option type
+  leg_t &leg(expiry_t &expiry, option_type_t put_call);
+
+  // Registry the chain is built from
+  instrument_registry const &m_instruments;
+
+  // Options by maturity and strike. Maturities alone to search them
+  vector<expiry_t> m_expiries;
+  vector<ptime> m_maturities;
+
+  // Futures sorted by maturity and the perpetual
+  vector<std::pair<ptime, instrument_id_t>> m_futures;
+  instrument_id_t m_perpetual;
+
+  // Position of every option of the chain
+  std::unordered_map<instrument_id_t, location_t> m_locations;
+};
@@ -1,14 +1,103 @@
 #include "config.h"
 
 #include "gamma_scalper/gamma_scalper.h"
+#include "host/strategy_host.h"
 #include "testing_strategy.h"
 
 #include "argparse/argparse.h"
 #include "config_file/config_file.h"
 
 #include <chrono>
+#include <functional>
+#include <sstream>
 #include <thread>
 
+/**
+ * Reads a configuration file again when a previous session took the secret
+ * out of its configuration, before starting a new one
+ */
+void restore_configuration(config_file_t &configuration,
+                           std::string const &file) {
+  if (configuration.find("AccessSecret") == configuration.end()) {
+    configuration = config_file::load_config_file(file);
+  }
+}
+
+/**
+ * Runs a gamma scalper, starting it again after it stops
+ */
+void run_gamma_scalper(std::unique_ptr<gamma_scalper> strategy,
+                       std::function<std::unique_ptr<gamma_scalper>()> create) {
+  while (strategy->run()) {
+    strategy.reset();
+    std::this_thread::sleep_for(std::chrono::minutes(5));
+    try {
+      strategy = create();
+    } catch (std::exception const &exception) {
+      std::cerr << "ERROR: Impossible to start the gamma scalper again: "
+                << exception.what() << std::endl;
+      return;
+    }
+  }
+}
+
+/**
+ * Runs the gamma scalpers listed in the host configuration, each with its own
+ * configuration and account, sharing the market data of the host
+ */
+int run_host(config_file_t &configuration) {
+  strategy_host host(configuration);
+
+  // Strategies' configuration files, separated by commas
+  std::vector<std::pair<config_file_t, std::string>> strategies;
+  std::stringstream files(
+      config_file::get<std::string>(configuration, "Strategies", ""));
+  std::string file;
+  while (std::getline(files, file, ',')) {
+    strategies.emplace_back(config_file::load_config_file(file), file);
+    if (strategies.back().first.empty()) {
+      std::cerr << "ERROR: Impossible to process the configuration file "
+                << file << std::endl;
+      return 1;
+    }
+  }
+
+  if (!host.run()) {
+    std::cerr << "ERROR: Impossible to initialize the market" << std::endl;
+    return 1;
+  }
+
+  // Every strategy is created before any of them runs, a failure leaves no
+  // runner behind
+  std::vector<std::function<std::unique_ptr<gamma_scalper>()>> creators;
+  std::vector<std::unique_ptr<gamma_scalper>> created;
+  for (auto &strategy : strategies) {
+    creators.push_back([&strategy, &host]() {
+      restore_configuration(strategy.first, strategy.second);
+      return std::make_unique<gamma_scalper>(strategy.first, strategy.second,
+                                             host);
+    });
+    created.push_back(creators.back()());
+  }
+
+  std::vector<std::thread> runners;
+  try {
+    for (size_t index = 0; index < created.size(); ++index) {
+      runners.emplace_back(run_gamma_scalper, std::move(created[index]),
+                           creators[index]);
+    }
+  } catch (...) {
+    for (auto &runner : runners) {
+      runner.join();
+    }
+    throw;
+  }
+  for (auto &runner : runners) {
+    runner.join();
+  }
+  return 0;
+}
+
 /**
  * Creates the entry for the program
  */
@@ -31,12 +120,14 @@ int main(int argc, const char **argv) {
   }
 
   if (parser.retrieve<std::string>("strategy") == "gamma_scalper") {
-    auto strategy = std::make_unique<gamma_scalper>(configuration);
-    while (strategy->run()) {
-      strategy.reset();
-      std::this_thread::sleep_for(std::chrono::minutes(5));
-      strategy = std::make_unique<gamma_scalper>(configuration);
-    }
+    auto create = [&]() {
+      restore_configuration(configuration, user_configuration_file);
+      return std::make_unique<gamma_scalper>(configuration,
+                                             user_configuration_file);
+    };
+    run_gamma_scalper(create(), create);
+  } else if (parser.retrieve<std::string>("strategy") == "host") {
+    return run_host(configuration);
   } else {
     testing_strategy strategy(configuration);
     while (strategy.run()) {
@@ -0,0 +1,106 @@
+#include "arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace details {
+
+// Arena scopes open in this thread, only the outermost one resets
+thread_local size_t open_arena_scopes = 0;
+
+/**
+ * @returns the offset rounded up to the alignment (power of two)
+ */
+size_t align_offset(char const *data, size_t offset, size_t alignment) {
+  auto const address = reinterpret_cast<uintptr_t>(data) + offset;
+  auto const aligned = (address + alignment - 1) & ~(alignment - 1);
+  return offset + (aligned - address);
+}
+
+}  // namespace details
+
+arena::arena(size_t block_size)
+    : m_blocks(),
+      m_current(0),
+      m_offset(0),
+      m_block_size(block_size),
+      m_used(0) {}
+
+arena::~arena() {
+  for (auto const &block : m_blocks) {
+    ::operator delete(block.data);
+  }
+}
+
+void *arena::allocate(size_t bytes, size_t alignment) {
+  if (m_current < m_blocks.size()) {
+    auto const &block = m_blocks[m_current];
+    auto const offset = details::align_offset(block.data, m_offset, alignment);
+    if (offset + bytes <= block.size) {
+      m_offset = offset + bytes;
+      m_used += bytes;
+      return block.data + offset;
+    }
+  }
+
+  next_block(bytes, alignment);
+  auto const &block = m_blocks[m_current];
+  auto const offset = details::align_offset(block.data, 0, alignment);
+  m_offset = offset + bytes;
+  m_used += bytes;
+  return block.data + offset;
+}
+
+void arena::reset() {
+  m_current = 0;
+  m_offset = 0;
+  m_used = 0;
+}
+
+void arena::reserve(size_t bytes) {
+  // Pages already touched stay where they are
+  for (auto const &block : m_blocks) {
+    if (block.size >= bytes) {
+      return;
+    }
+  }
+
+  m_blocks.push_back({static_cast<char *>(::operator new(bytes)), bytes});
+  std::memset(m_blocks.back().data, 0, bytes);
+}
+
+void arena::next_block(size_t bytes, size_t alignment) {
+  auto const needed = bytes + alignment;
+
+  // Reusing the blocks kept from before the last reset
+  for (++m_current; m_current < m_blocks.size(); ++m_current) {
+    if (m_blocks[m_current].size >= needed) {
+      m_offset = 0;
+      return;
+    }
+  }
+
+  // Bigger allocations than a block get a block of their own
+  auto const size = std::max(m_block_size, needed);
+  m_blocks.push_back({static_cast<char *>(::operator new(size)), size});
+  m_current = m_blocks.size() - 1;
+  m_offset = 0;
+}
+
+arena &thread_arena() {
+  thread_local arena memory;
+  return memory;
+}
+
+arena_scope::arena_scope(arena &memory)
+    : m_arena(memory), m_outermost(details::open_arena_scopes == 0) {
+  ++details::open_arena_scopes;
+}
+
+arena_scope::~arena_scope() {
+  --details::open_arena_scopes;
+  if (m_outermost) {
+    m_arena.reset();
+  }
+}
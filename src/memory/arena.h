@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Monotonic memory arena.
+ *
+ * Allocations only move a pointer forward inside big blocks and nothing is
+ * freed one by one: `reset` makes the whole arena available again while
+ * keeping its blocks, so a process that decodes the same kind of messages over
+ * and over stops asking the heap for memory once warmed up
+ */
+class arena {
+ public:
+  /** Constructor */
+  explicit arena(size_t block_size = 1 << 20);
+
+  /** Destructor. Releases every block */
+  ~arena();
+
+  arena(arena const &) = delete;
+  arena &operator=(arena const &) = delete;
+
+  /** @returns memory for the given bytes and alignment */
+  void *allocate(size_t bytes, size_t alignment);
+
+  /** Makes all the memory available again. Everything allocated is lost */
+  void reset();
+
+  /**
+   * Makes sure a block holds the given bytes and touches its pages, so they
+   * are placed on the NUMA node of the calling thread before being used
+   */
+  void reserve(size_t bytes);
+
+  /** @returns the bytes handed out since the last reset */
+  size_t used() const { return m_used; }
+
+ private:
+  struct block_t {
+    char *data;
+    size_t size;
+  };
+
+  // Moves to the next block able to hold the allocation, creating it if needed
+  void next_block(size_t bytes, size_t alignment);
+
+  // Blocks owned, the one in use and the position inside it
+  std::vector<block_t> m_blocks;
+  size_t m_current;
+  size_t m_offset;
+
+  // Size of the regular blocks
+  size_t m_block_size;
+
+  // Bytes handed out
+  size_t m_used;
+};
+
+/**
+ * @returns the arena of the calling thread, used for decoded messages
+ */
+arena &thread_arena();
+
+/**
+ * Resets an arena when leaving the scope, once whatever was allocated from it
+ * is not used anymore. When scopes are nested in a thread only the outermost
+ * one resets
+ */
+class arena_scope {
+ public:
+  explicit arena_scope(arena &memory);
+  ~arena_scope();
+
+  arena_scope(arena_scope const &) = delete;
+  arena_scope &operator=(arena_scope const &) = delete;
+
+  /** @returns the arena of the scope */
+  arena &memory() { return m_arena; }
+
+ private:
+  arena &m_arena;
+  bool m_outermost;
+};
+
+/**
+ * Standard allocator over an arena. Without arena it uses the heap.
+ *
+ * Copies of containers using it go to the heap, so whatever the user keeps
+ * from a decoded message outlives the arena's reset. Moves keep the arena
+ */
+template <typename T>
+class arena_allocator {
+ public:
+  using value_type = T;
+
+  arena_allocator() noexcept : m_arena(nullptr) {}
+  explicit arena_allocator(arena *memory) noexcept : m_arena(memory) {}
+  template <typename U>
+  arena_allocator(arena_allocator<U> const &other) noexcept
+      : m_arena(other.memory()) {}
+
+  T *allocate(size_t count) {
+    if (!m_arena) {
+      return static_cast<T *>(::operator new(count * sizeof(T)));
+    }
+    return static_cast<T *>(m_arena->allocate(count * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T *pointer, size_t /*count*/) noexcept {
+    // Arena memory is only released on reset
+    if (!m_arena) {
+      ::operator delete(pointer);
+    }
+  }
+
+  arena_allocator select_on_container_copy_construction() const {
+    return arena_allocator();
+  }
+
+  arena *memory() const noexcept { return m_arena; }
+
+  template <typename U>
+  bool operator==(arena_allocator<U> const &other) const noexcept {
+    return m_arena == other.memory();
+  }
+  template <typename U>
+  bool operator!=(arena_allocator<U> const &other) const noexcept {
+    return m_arena != other.memory();
+  }
+
+ private:
+  arena *m_arena;
+};
+
+// Containers that can live in an arena
+template <typename T>
+using arena_vector = std::vector<T, arena_allocator<T>>;
+using arena_string =
+    std::basic_string<char, std::char_traits<char>, arena_allocator<char>>;
@@ -0,0 +1,116 @@
+#include "monitor_endpoint.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace details {
+
+// Milliseconds waiting for clients before checking if it has to stop
+int const monitor_poll_milliseconds = 200;
+
+// Seconds a client has to read the state, a stuck dashboard is dropped
+long const monitor_send_seconds = 1;
+
+}  // namespace details
+
+monitor_endpoint::settings_t monitor_endpoint::load_settings(
+    config_file_t const &configuration) {
+  settings_t settings;
+  settings.path = config_file::get<string>(configuration, "MonitorSocket", "");
+  settings.thread = threads::load_thread_settings(configuration, "Monitor");
+  return settings;
+}
+
+monitor_endpoint::monitor_endpoint(settings_t const &settings,
+                                   render_t render)
+    : m_settings(settings),
+      m_render(std::move(render)),
+      m_socket(-1),
+      m_running(true),
+      m_thread() {
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (m_settings.path.empty() ||
+      m_settings.path.size() >= sizeof(address.sun_path)) {
+    BOOST_THROW_EXCEPTION(std::invalid_argument(
+        "MonitorSocket '" + m_settings.path + "' is not a valid socket path"));
+  }
+  std::memcpy(address.sun_path, m_settings.path.data(),
+              m_settings.path.size());
+
+  m_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (m_socket < 0) {
+    BOOST_THROW_EXCEPTION(std::runtime_error(
+        "Impossible to create the monitoring socket: " +
+        string(std::strerror(errno))));
+  }
+
+  unlink(m_settings.path.c_str());
+  if (bind(m_socket, reinterpret_cast<sockaddr const *>(&address),
+           sizeof(address)) != 0 ||
+      listen(m_socket, SOMAXCONN) != 0) {
+    auto const error = string(std::strerror(errno));
+    close(m_socket);
+    BOOST_THROW_EXCEPTION(std::runtime_error(
+        "Impossible to listen in " + m_settings.path + ": " + error));
+  }
+
+  m_thread = std::thread(&monitor_endpoint::process, this);
+}
+
+monitor_endpoint::~monitor_endpoint() {
+  m_running = false;
+  m_thread.join();
+  close(m_socket);
+  unlink(m_settings.path.c_str());
+}
+
+void monitor_endpoint::process() {
+  threads::apply_thread_settings(m_settings.thread);
+
+  pollfd listening{m_socket, POLLIN, 0};
+  while (m_running) {
+    if (poll(&listening, 1, details::monitor_poll_milliseconds) <= 0) {
+      continue;
+    }
+    auto const client = accept4(m_socket, nullptr, nullptr, SOCK_CLOEXEC);
+    if (client < 0) {
+      continue;
+    }
+    serve(client);
+    close(client);
+  }
+}
+
+void monitor_endpoint::serve(int client) {
+  timeval timeout{details::monitor_send_seconds, 0};
+  setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+  string state;
+  try {
+    state = m_render();
+  } catch (std::exception const &e) {
+    std::cerr << "Impossible to render the monitoring state: " << e.what()
+              << std::endl;
+    return;
+  }
+
+  size_t sent = 0;
+  while (sent < state.size()) {
+    auto const written =
+        send(client, state.data() + sent, state.size() - sent, MSG_NOSIGNAL);
+    if (written <= 0) {
+      return;
+    }
+    sent += static_cast<size_t>(written);
+  }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "../config.h"
+#include "../threads/thread_settings.h"
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+/**
+ * Local endpoint for the dashboards of a running strategy.
+ *
+ * Listens on a Unix socket from a thread of its own. Every client connecting
+ * is sent what the render callback returns and disconnected, so
+ * "socat - UNIX-CONNECT:<path>" polls it. The callback runs in the thread of
+ * the endpoint, it must only read state published for other threads
+ */
+class monitor_endpoint {
+ public:
+  // Where it listens and where its thread runs
+  struct settings_t {
+    // Path of the socket, no endpoint when empty
+    string path;
+
+    // Thread of the endpoint, read with the "Monitor" role
+    thread_settings_t thread;
+  };
+
+  using render_t = std::function<string()>;
+
+  /** @returns the settings of the configuration, key MonitorSocket */
+  static settings_t load_settings(config_file_t const &configuration);
+
+  /** Constructor. Starts listening, replacing a socket left behind */
+  monitor_endpoint(settings_t const &settings, render_t render);
+
+  /** Destructor. Stops listening and removes the socket */
+  ~monitor_endpoint();
+
+  monitor_endpoint(monitor_endpoint const &) = delete;
+  monitor_endpoint &operator=(monitor_endpoint const &) = delete;
+
+ private:
+  // Serves the clients until stopped
+  void process();
+
+  // Sends the state to a client
+  void serve(int client);
+
+  settings_t m_settings;
+  render_t m_render;
+
+  // Listening socket
+  int m_socket;
+
+  std::atomic<bool> m_running;
+  std::thread m_thread;
+};
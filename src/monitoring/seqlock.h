@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * Value published by a single writer and read by any thread without locks.
+ *
+ * The sequence is odd while the value is being written. A reader copies the
+ * value and tries again when the sequence was odd or changed meanwhile, so
+ * the writer never waits for the readers. Values are copied bytewise, they
+ * must be trivially copyable
+ */
+template <typename T>
+class seqlock {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "seqlock values are copied bytewise");
+
+ public:
+  /** Constructor */
+  seqlock() : m_sequence(0), m_value() {}
+
+  seqlock(seqlock const &) = delete;
+  seqlock &operator=(seqlock const &) = delete;
+
+  /** Publishes a value. Only called from the writer */
+  void store(T const &value) {
+    auto const sequence = m_sequence.load(std::memory_order_relaxed);
+    m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&m_value, &value, sizeof(T));
+    m_sequence.store(sequence + 2, std::memory_order_release);
+  }
+
+  /** @returns a copy of the last value published */
+  T load() const {
+    T value;
+    size_t before = 0;
+    size_t after = 0;
+    do {
+      before = m_sequence.load(std::memory_order_acquire);
+      std::memcpy(&value, &m_value, sizeof(T));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = m_sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+    return value;
+  }
+
+  /** @returns how many values were published */
+  size_t published() const {
+    return m_sequence.load(std::memory_order_acquire) / 2;
+  }
+
+ private:
+  // Odd while writing
+  std::atomic<size_t> m_sequence;
+
+  // Last value published
+  T m_value;
+};
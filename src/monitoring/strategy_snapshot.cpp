@@ -0,0 +1,97 @@
+#include "strategy_snapshot.h"
+
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+namespace details {
+
+// Numbers as JSON, NaN is not valid there
+void write_json_number(std::ostream &os, double value) {
+  if (std::isfinite(value)) {
+    os << value;
+  } else {
+    os << "null";
+  }
+}
+
+// Symbols and identifiers have no characters to escape
+template <size_t N>
+void write_json_string(std::ostream &os, fixed_string<N> const &value) {
+  os << '"';
+  os.write(value.data(), value.size());
+  os << '"';
+}
+
+}  // namespace details
+
+string to_json(strategy_snapshot_t const &snapshot) {
+  std::ostringstream os;
+  os << std::setprecision(std::numeric_limits<double>::digits10);
+  os << "{\"timestamp\":" << snapshot.timestamp;
+
+  os << ",\"positions\":[";
+  for (size_t i = 0; i < snapshot.positions_count; ++i) {
+    auto const &position = snapshot.positions[i];
+    os << (i ? ",{" : "{") << "\"symbol\":";
+    details::write_json_string(os, position.symbol);
+    os << ",\"quantity\":";
+    details::write_json_number(os, position.quantity);
+    os << ",\"delta\":";
+    details::write_json_number(os, position.delta);
+    os << '}';
+  }
+  os << "],\"positions_dropped\":" << snapshot.positions_dropped;
+
+  os << ",\"orders\":[";
+  for (size_t i = 0; i < snapshot.orders_count; ++i) {
+    auto const &order = snapshot.orders[i];
+    os << (i ? ",{" : "{") << "\"id\":";
+    details::write_json_string(os, order.id);
+    os << ",\"symbol\":";
+    details::write_json_string(os, order.symbol);
+    os << ",\"side\":\"" << to_string(order.side) << "\",\"price\":";
+    details::write_json_number(os, order.price);
+    os << ",\"volume\":";
+    details::write_json_number(os, order.volume);
+    os << ",\"filled\":";
+    details::write_json_number(os, order.filled);
+    os << '}';
+  }
+
+  os << "],\"books\":[";
+  for (size_t i = 0; i < snapshot.books_count; ++i) {
+    auto const &book = snapshot.books[i];
+    os << (i ? ",{" : "{") << "\"symbol\":";
+    details::write_json_string(os, book.symbol);
+    os << ",\"bid_volume\":";
+    details::write_json_number(os, book.bid_volume);
+    os << ",\"bid\":";
+    details::write_json_number(os, book.bid);
+    os << ",\"ask\":";
+    details::write_json_number(os, book.ask);
+    os << ",\"ask_volume\":";
+    details::write_json_number(os, book.ask_volume);
+    os << '}';
+  }
+
+  os << "],\"total_delta\":";
+  details::write_json_number(os, snapshot.total_delta);
+  os << ",\"pnl\":{\"realized\":";
+  details::write_json_number(os, snapshot.realized);
+  os << ",\"unrealized\":";
+  details::write_json_number(os, snapshot.unrealized);
+  os << ",\"fees\":";
+  details::write_json_number(os, snapshot.fees);
+
+  auto const &latency = snapshot.latency;
+  os << "},\"latency\":{\"evaluations\":" << latency.evaluations
+     << ",\"last_ns\":" << latency.last_ns << ",\"max_ns\":" << latency.max_ns
+     << ",\"mean_ns\":"
+     << (latency.evaluations ? latency.total_ns /
+                                   static_cast<int64_t>(latency.evaluations)
+                             : 0)
+     << "}}\n";
+  return os.str();
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "../config.h"
+
+#include <cstdint>
+
+/**
+ * State of a running strategy, copied as a whole for the monitoring.
+ *
+ * Entries are stored inline, beyond the capacities they are left out and
+ * counted as dropped. Missing prices and greeks are NaN
+ */
+struct strategy_snapshot_t {
+  static size_t const max_positions = 16;
+  static size_t const max_orders = 4;
+  static size_t const max_books = 4;
+
+  // Position in an instrument, negative when short
+  struct position_entry_t {
+    symbol_t symbol;
+    double quantity;
+    double delta;
+  };
+
+  // Order working in the market, or parent order being worked
+  struct order_entry_t {
+    order_id_t id;
+    symbol_t symbol;
+    side_t side;
+    double price;
+    double volume;
+    double filled;
+  };
+
+  // Best bid and offer of an instrument in use
+  struct book_entry_t {
+    symbol_t symbol;
+    double bid_volume;
+    double bid;
+    double ask;
+    double ask_volume;
+  };
+
+  // Time taken by the evaluations of the market data
+  struct latency_t {
+    size_t evaluations;
+    int64_t last_ns;
+    int64_t max_ns;
+    int64_t total_ns;
+  };
+
+  // Microseconds since the epoch when it was taken
+  int64_t timestamp;
+
+  size_t positions_count;
+  size_t positions_dropped;
+  position_entry_t positions[max_positions];
+
+  size_t orders_count;
+  order_entry_t orders[max_orders];
+
+  size_t books_count;
+  book_entry_t books[max_books];
+
+  // Delta of the whole portfolio against the underlying
+  double total_delta;
+
+  // Profit and loss in the currency of the instruments
+  double realized;
+  double unrealized;
+  double fees;
+
+  latency_t latency;
+};
+
+/** @returns the snapshot as a JSON object, for the dashboards */
+string to_json(strategy_snapshot_t const &snapshot);
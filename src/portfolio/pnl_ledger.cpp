@@ -0,0 +1,294 @@
+#include "pnl_ledger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+namespace details {
+
+string const pnl_checkpoint_file = "pnl_ledger";
+
+// Checkpoint layout: magic, version, count and then the records as they are
+// in memory
+char const pnl_checkpoint_magic[8] = {'D', 'R', 'B', 'T', 'P', 'N', 'L', 'L'};
+uint32_t const pnl_checkpoint_version = 1;
+
+// Positions smaller than this are closed
+double const closed_position = 1e-9;
+
+}  // namespace details
+
+pnl_ledger::pnl_ledger(instrument_registry const &instruments,
+                       string aux_folder_path, settings_t const &settings)
+    : m_instruments(instruments),
+      m_checkpoint_path(aux_folder_path + details::pnl_checkpoint_file),
+      m_settings(settings),
+      m_entries(),
+      m_unresolved(),
+      m_dirty(false),
+      m_mutex(),
+      m_condition_variable(),
+      m_running(true),
+      m_checkpointer() {
+  static_assert(std::is_trivially_copyable<record_t>::value,
+                "Records of the checkpoint are stored as they are in memory");
+  load_checkpoint();
+  m_checkpointer = std::thread(&pnl_ledger::process, this);
+}
+
+pnl_ledger::~pnl_ledger() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_running = false;
+  }
+  m_condition_variable.notify_all();
+  m_checkpointer.join();
+  store_checkpoint();
+}
+
+pnl_ledger::settings_t pnl_ledger::load_settings(
+    config_file_t const &configuration) {
+  settings_t settings;
+  settings.fee_rate =
+      config_file::get(configuration, "PnlFeeRate", settings.fee_rate);
+  settings.checkpoint_seconds = config_file::get(
+      configuration, "PnlCheckpointSeconds", settings.checkpoint_seconds);
+  if (settings.checkpoint_seconds < 1) {
+    BOOST_THROW_EXCEPTION(
+        std::invalid_argument("PnlCheckpointSeconds must be at least 1"));
+  }
+  return settings;
+}
+
+void pnl_ledger::on_fill(instrument_id_t id, side_t side, volume_t volume,
+                         price_t price) {
+  auto const traded = static_cast<double>(volume);
+  auto const signed_volume = side == side_t::BUY ? traded : -traded;
+  auto const traded_price = static_cast<double>(price);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto &pnl = entry(id);
+  pnl.fees += m_settings.fee_rate *
+              std::abs(value_of(id, traded, traded_price));
+  ++pnl.fills;
+  m_dirty = true;
+
+  // Opening or increasing the position adds to the value paid
+  if (pnl.position * signed_volume >= 0) {
+    pnl.position += signed_volume;
+    pnl.entry_value += value_of(id, signed_volume, traded_price);
+    return;
+  }
+
+  // Closing releases the value paid for the part closed, at its average cost
+  auto const open = std::abs(pnl.position);
+  auto const closed = std::min(traded, open);
+  auto const released = pnl.entry_value * closed / open;
+  auto const closed_volume = pnl.position > 0 ? closed : -closed;
+  pnl.realized += profit_of(id, closed_volume, released, traded_price);
+  pnl.position += signed_volume;
+  pnl.entry_value -= released;
+
+  // What is left opens a position on the other side
+  if (std::abs(pnl.position) < details::closed_position) {
+    pnl.position = 0;
+    pnl.entry_value = 0;
+  } else if (traded > open) {
+    pnl.entry_value = value_of(id, pnl.position, traded_price);
+  }
+}
+
+void pnl_ledger::reconcile(instrument_id_t id, double position,
+                           price_t price) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto &pnl = entry(id);
+  if (std::abs(pnl.position - position) < details::closed_position) {
+    return;
+  }
+  pnl.position = position;
+  pnl.entry_value = value_of(id, position, static_cast<double>(price));
+  m_dirty = true;
+}
+
+void pnl_ledger::mark(instrument_id_t id, BBO_t const &bbo) {
+  if (!bbo.bid || !bbo.ask) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  entry(id).mark =
+      (static_cast<double>(*bbo.bid) + static_cast<double>(*bbo.ask)) * 0.5;
+}
+
+pnl_ledger::pnl_t pnl_ledger::get(instrument_id_t id) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return id < m_entries.size() ? m_entries[id] : pnl_t();
+}
+
+double pnl_ledger::cost_basis(instrument_id_t id) const {
+  auto const pnl = get(id);
+  if (pnl.position == 0 || pnl.entry_value == 0) {
+    return 0;
+  }
+
+  // The value of a unit, inverse for the futures
+  auto const unit = value_of(id, pnl.position, 1);
+  return m_instruments.get(id).has(instrument_t::PUT_CALL)
+             ? pnl.entry_value / unit
+             : unit / pnl.entry_value;
+}
+
+double pnl_ledger::unrealized(instrument_id_t id) const {
+  auto const pnl = get(id);
+  if (pnl.position == 0 || pnl.mark == 0) {
+    return 0;
+  }
+  return profit_of(id, pnl.position, pnl.entry_value, pnl.mark);
+}
+
+pnl_ledger::totals_t pnl_ledger::totals() const {
+  totals_t totals{0, 0, 0};
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (instrument_id_t id = 0; id < m_entries.size(); ++id) {
+    auto const &pnl = m_entries[id];
+    totals.realized += pnl.realized;
+    totals.fees += pnl.fees;
+    if (pnl.position != 0 && pnl.mark != 0) {
+      totals.unrealized +=
+          profit_of(id, pnl.position, pnl.entry_value, pnl.mark);
+    }
+  }
+  return totals;
+}
+
+double pnl_ledger::value_of(instrument_id_t id, double volume,
+                            double price) const {
+  auto const &instrument = m_instruments.get(id);
+  auto const notional = volume * (instrument.contract_multiplier > 0
+                                      ? instrument.contract_multiplier
+                                      : 1);
+  if (instrument.has(instrument_t::PUT_CALL)) {
+    return notional * price;
+  }
+  return price > 0 ? notional / price : 0;
+}
+
+double pnl_ledger::profit_of(instrument_id_t id, double volume,
+                             double entry_value, double price) const {
+  // A long inverse position gains when its value in the currency drops
+  auto const value = value_of(id, volume, price);
+  return m_instruments.get(id).has(instrument_t::PUT_CALL)
+             ? value - entry_value
+             : entry_value - value;
+}
+
+pnl_ledger::pnl_t &pnl_ledger::entry(instrument_id_t id) {
+  if (id >= m_entries.size()) {
+    grow();
+  }
+  return m_entries[id];
+}
+
+void pnl_ledger::grow() {
+  m_entries.resize(m_instruments.size());
+
+  // Records of the checkpoint whose instrument is known now
+  auto const resolved = std::remove_if(
+      m_unresolved.begin(), m_unresolved.end(), [this](record_t const &record) {
+        auto const id = m_instruments.find(record.symbol);
+        if (!id || *id >= m_entries.size()) {
+          return false;
+        }
+        m_entries[*id] = record.pnl;
+        return true;
+      });
+  m_unresolved.erase(resolved, m_unresolved.end());
+}
+
+void pnl_ledger::load_checkpoint() {
+  std::ifstream file(m_checkpoint_path, std::ios::in | std::ios::binary);
+  if (!file) {
+    return;
+  }
+
+  char magic[sizeof(details::pnl_checkpoint_magic)];
+  uint32_t version = 0;
+  uint32_t count = 0;
+  file.read(magic, sizeof(magic));
+  file.read(reinterpret_cast<char *>(&version), sizeof(version));
+  file.read(reinterpret_cast<char *>(&count), sizeof(count));
+  if (!file ||
+      std::memcmp(magic, details::pnl_checkpoint_magic, sizeof(magic)) != 0 ||
+      version != details::pnl_checkpoint_version) {
+    std::cerr << "Ignoring the PnL checkpoint " << m_checkpoint_path
+              << ", it's not valid" << std::endl;
+    return;
+  }
+
+  m_unresolved.resize(count);
+  file.read(reinterpret_cast<char *>(m_unresolved.data()),
+            count * sizeof(record_t));
+  if (!file) {
+    std::cerr << "Ignoring the PnL checkpoint " << m_checkpoint_path
+              << ", it's truncated" << std::endl;
+    m_unresolved.clear();
+    return;
+  }
+  grow();
+}
+
+void pnl_ledger::store_checkpoint() {
+  // Copied to write it without holding the fills
+  vector<record_t> records;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_dirty) {
+      return;
+    }
+    m_dirty = false;
+    records = m_unresolved;
+    for (instrument_id_t id = 0; id < m_entries.size(); ++id) {
+      if (m_entries[id].fills || m_entries[id].position) {
+        records.push_back({m_instruments.get(id).symbol, m_entries[id]});
+      }
+    }
+  }
+
+  // Write in a temporary file and swap it, a crash never leaves half
+  // checkpoint
+  auto const temporary_path = m_checkpoint_path + ".tmp";
+  std::ofstream file(temporary_path,
+                     std::ios::out | std::ios::binary | std::ios::trunc);
+  auto const count = static_cast<uint32_t>(records.size());
+  file.write(details::pnl_checkpoint_magic,
+             sizeof(details::pnl_checkpoint_magic));
+  file.write(reinterpret_cast<char const *>(&details::pnl_checkpoint_version),
+             sizeof(details::pnl_checkpoint_version));
+  file.write(reinterpret_cast<char const *>(&count), sizeof(count));
+  file.write(reinterpret_cast<char const *>(records.data()),
+             records.size() * sizeof(record_t));
+  file.close();
+  if (!file || std::rename(temporary_path.c_str(),
+                           m_checkpoint_path.c_str()) != 0) {
+    std::cerr << "Impossible to store the PnL checkpoint in "
+              << m_checkpoint_path << std::endl;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_dirty = true;
+  }
+}
+
+void pnl_ledger::process() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (m_running) {
+    m_condition_variable.wait_for(
+        lock, std::chrono::seconds(m_settings.checkpoint_seconds));
+    if (!m_running) {
+      break;
+    }
+    lock.unlock();
+    store_checkpoint();
+    lock.lock();
+  }
+}
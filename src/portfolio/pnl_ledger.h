@@ -0,0 +1,145 @@
+#pragma once
+
+#include "../config.h"
+#include "../instruments/instrument_registry.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/**
+ * Realized and unrealized profit and loss of every instrument traded.
+ *
+ * Positions, the value paid for them, realized profits and fees are kept in
+ * a flat array by instrument, updated in constant time by every fill with
+ * the average cost of the position. Futures are inverse, their value is the
+ * notional over the price, options are linear. Values are in the currency of
+ * the instrument.
+ *
+ * A thread of the ledger stores a binary checkpoint when something changed,
+ * every few seconds, so fills never wait for the disk. The checkpoint is
+ * loaded when the ledger is created
+ */
+class pnl_ledger {
+ public:
+  // Fees and checkpoints
+  struct settings_t {
+    // Fees paid, as a fraction of the value traded
+    double fee_rate = 0;
+
+    // Seconds between checkpoints
+    long checkpoint_seconds = 10;
+  };
+
+  // Profit and loss of an instrument
+  struct pnl_t {
+    // Position, negative when short, and value paid for it with the same sign
+    double position = 0;
+    double entry_value = 0;
+
+    // Profit of the positions closed, and fees of every fill
+    double realized = 0;
+    double fees = 0;
+
+    // Last mid price, 0 if unknown
+    double mark = 0;
+
+    size_t fills = 0;
+  };
+
+  // Profit and loss of every instrument
+  struct totals_t {
+    double realized;
+    double unrealized;
+    double fees;
+  };
+
+  /** Constructor. Loads the checkpoint of the auxiliar folder */
+  pnl_ledger(instrument_registry const &instruments, string aux_folder_path,
+             settings_t const &settings);
+
+  /** Destructor. Stores the last checkpoint */
+  ~pnl_ledger();
+
+  pnl_ledger(pnl_ledger const &) = delete;
+  pnl_ledger &operator=(pnl_ledger const &) = delete;
+
+  /** @returns the settings read from the configuration */
+  static settings_t load_settings(config_file_t const &configuration);
+
+  /** Applies a fill of an instrument */
+  void on_fill(instrument_id_t id, side_t side, volume_t volume,
+               price_t price);
+
+  /**
+   * Takes the position of the exchange, valued at the given price, when the
+   * ledger's is different. Realized profits are kept
+   */
+  void reconcile(instrument_id_t id, double position, price_t price);
+
+  /** Marks the position of an instrument at the mid price of its book */
+  void mark(instrument_id_t id, BBO_t const &bbo);
+
+  /** @returns the profit and loss of an instrument */
+  pnl_t get(instrument_id_t id) const;
+
+  /** @returns the average price paid for the position, 0 without position */
+  double cost_basis(instrument_id_t id) const;
+
+  /** @returns the profit of the position at its mark price */
+  double unrealized(instrument_id_t id) const;
+
+  /** @returns the totals of every instrument */
+  totals_t totals() const;
+
+ private:
+  // Profit and loss of an instrument in the checkpoint
+  struct record_t {
+    symbol_t symbol;
+    pnl_t pnl;
+  };
+
+  // @returns the value of a volume of an instrument at a price
+  double value_of(instrument_id_t id, double volume, double price) const;
+
+  // @returns the profit of closing part of a position at a price
+  double profit_of(instrument_id_t id, double volume, double entry_value,
+                   double price) const;
+
+  // @returns the profit and loss of an instrument, growing the array for
+  // instruments added to the registry since the last fill
+  pnl_t &entry(instrument_id_t id);
+  void grow();
+
+  // Loads and stores the checkpoint
+  void load_checkpoint();
+  void store_checkpoint();
+
+  // Stores the checkpoints until the ledger is destroyed
+  void process();
+
+  // Instruments traded
+  instrument_registry const &m_instruments;
+
+  // Path to the checkpoint file
+  string m_checkpoint_path;
+
+  // Fees and checkpoints
+  settings_t m_settings;
+
+  // Profit and loss by instrument, and the ones of the checkpoint whose
+  // instrument is not in the registry yet
+  vector<pnl_t> m_entries;
+  vector<record_t> m_unresolved;
+
+  // Something changed since the last checkpoint
+  bool m_dirty;
+
+  // Protects all of the above
+  mutable std::mutex m_mutex;
+  std::condition_variable m_condition_variable;
+
+  // Thread storing the checkpoints
+  bool m_running;
+  std::thread m_checkpointer;
+};
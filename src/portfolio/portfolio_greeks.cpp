@@ -0,0 +1,290 @@
+#include "portfolio_greeks.h"
+
+#include "../pricing/black_scholes.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace details {
+
+greeks_t const no_greeks = {0, 0, 0, 0, 0, 1};
+
+/**
+ * Adds to the total the difference between two contributions
+ */
+void move_contribution(greeks_t &total, greeks_t const &from,
+                       greeks_t const &to) {
+  total.delta += to.delta - from.delta;
+  total.gamma += to.gamma - from.gamma;
+  total.speed += to.speed - from.speed;
+  total.vega += to.vega - from.vega;
+  total.theta += to.theta - from.theta;
+  total.missing = total.missing + to.missing - from.missing;
+}
+
+}  // namespace details
+
+portfolio_greeks::portfolio_greeks()
+    : m_instrument(),
+      m_underlying(),
+      m_bucket(),
+      m_quantity(),
+      m_multiplier(),
+      m_strike(),
+      m_put_call(),
+      m_maturity_date(),
+      m_volatility(),
+      m_delta(),
+      m_gamma(),
+      m_speed(),
+      m_vega(),
+      m_theta(),
+      m_valid(),
+      m_stale(),
+      m_is_stale(),
+      m_underlyings(),
+      m_underlying_price(),
+      m_priced_price(),
+      m_underlying_positions(),
+      m_underlying_totals(),
+      m_buckets(),
+      m_bucket_totals(),
+      m_positions() {}
+
+void portfolio_greeks::set_position(instrument_id_t id,
+                                    instrument_t const &instrument,
+                                    instrument_id_t underlying,
+                                    double quantity) {
+  auto const existing = m_positions.find(id);
+  if (existing != m_positions.end()) {
+    m_quantity[existing->second] = quantity;
+    invalidate(existing->second);
+    return;
+  }
+
+  // First position on this underlying
+  auto underlying_index = m_underlyings.find(underlying);
+  if (underlying_index == m_underlyings.end()) {
+    underlying_index =
+        m_underlyings.emplace(underlying, m_underlying_price.size()).first;
+    m_underlying_price.push_back(std::numeric_limits<double>::quiet_NaN());
+    m_priced_price.push_back(std::numeric_limits<double>::quiet_NaN());
+    m_underlying_positions.emplace_back();
+    m_underlying_totals.push_back({0, 0, 0, 0, 0, 0});
+  }
+  auto const u = underlying_index->second;
+
+  // Futures without maturity (perpetual) share the same bucket
+  auto const maturity = instrument.has(instrument_t::MATURITY_DATE)
+                            ? instrument.maturity_date
+                            : ptime();
+  auto bucket = m_buckets.find({u, maturity});
+  if (bucket == m_buckets.end()) {
+    bucket = m_buckets.emplace(std::make_pair(u, maturity),
+                               m_bucket_totals.size())
+                 .first;
+    m_bucket_totals.push_back({0, 0, 0, 0, 0, 0});
+  }
+
+  auto const position = m_instrument.size();
+  m_positions[id] = position;
+  m_underlying_positions[u].push_back(position);
+
+  m_instrument.push_back(id);
+  m_underlying.push_back(u);
+  m_bucket.push_back(bucket->second);
+  m_quantity.push_back(quantity);
+  m_multiplier.push_back(instrument.has(instrument_t::CONTRACT_MULTIPLIER)
+                             ? instrument.contract_multiplier
+                             : 1);
+  m_strike.push_back(instrument.strike_price);
+  m_put_call.push_back(instrument.get(instrument_t::PUT_CALL,
+                                      instrument.put_call));
+  m_maturity_date.push_back(maturity);
+  m_volatility.push_back(std::numeric_limits<double>::quiet_NaN());
+
+  // Without greeks until it's priced
+  m_delta.push_back(0);
+  m_gamma.push_back(0);
+  m_speed.push_back(0);
+  m_vega.push_back(0);
+  m_theta.push_back(0);
+  m_valid.push_back(false);
+  m_underlying_totals[u].missing += 1;
+  m_bucket_totals[bucket->second].missing += 1;
+
+  m_is_stale.push_back(false);
+  invalidate(position);
+}
+
+void portfolio_greeks::set_volatility(instrument_id_t id, double volatility) {
+  auto const position = m_positions.find(id);
+  if (position == m_positions.end() ||
+      m_volatility[position->second] == volatility) {
+    return;
+  }
+  m_volatility[position->second] = volatility;
+  invalidate(position->second);
+}
+
+void portfolio_greeks::set_underlying_price(instrument_id_t underlying,
+                                            double price) {
+  auto const underlying_index = m_underlyings.find(underlying);
+  if (underlying_index == m_underlyings.end() ||
+      m_underlying_price[underlying_index->second] == price) {
+    return;
+  }
+  m_underlying_price[underlying_index->second] = price;
+  for (auto const position :
+       m_underlying_positions[underlying_index->second]) {
+    invalidate(position);
+  }
+}
+
+void portfolio_greeks::update(ptime const &now, double interest_rate) {
+  for (auto const position : m_stale) {
+    m_is_stale[position] = false;
+
+    auto const stock_price = m_underlying_price[m_underlying[position]];
+    auto const size = m_quantity[position] * m_multiplier[position];
+    if (!(stock_price > 0)) {
+      apply(position, details::no_greeks);
+      continue;
+    }
+
+    // Futures are quoted in USD, so their delta in currency also moves with
+    // the underlying
+    if (!m_put_call[position]) {
+      auto const delta = size / stock_price;
+      apply(position, {delta, -delta / stock_price,
+                       2 * delta / (stock_price * stock_price), 0, 0, 0});
+      continue;
+    }
+
+    auto const time_to_expiration =
+        years_to_expiration(m_maturity_date[position], now);
+    auto const volatility = m_volatility[position];
+    if (time_to_expiration <= 0 || !(volatility > 0)) {
+      apply(position, details::no_greeks);
+      continue;
+    }
+
+    auto const put_call = *m_put_call[position];
+    auto const strike = m_strike[position];
+    // Put deltas from black-scholes come without their sign
+    auto delta = black_scholes_delta(put_call, stock_price, strike,
+                                     interest_rate, time_to_expiration,
+                                     interest_rate, volatility);
+    delta = put_call == option_type_t::PUT ? -delta : delta;
+
+    greeks_t greeks = {
+        delta * size,
+        black_scholes_gamma(stock_price, strike, interest_rate,
+                            time_to_expiration, interest_rate, volatility) *
+            size,
+        black_scholes_speed(stock_price, strike, interest_rate,
+                            time_to_expiration, interest_rate, volatility) *
+            size,
+        black_scholes_vega(stock_price, strike, interest_rate,
+                           time_to_expiration, interest_rate, volatility) *
+            size,
+        black_scholes_theta(put_call, stock_price, strike, interest_rate,
+                            time_to_expiration, interest_rate, volatility) *
+            size,
+        0};
+
+    // Never let a NaN into the totals
+    auto const valid =
+        std::isfinite(greeks.delta) && std::isfinite(greeks.gamma) &&
+        std::isfinite(greeks.speed) && std::isfinite(greeks.vega) &&
+        std::isfinite(greeks.theta);
+    apply(position, valid ? greeks : details::no_greeks);
+  }
+  m_stale.clear();
+
+  // Every position of an underlying is priced again when its price changes
+  m_priced_price = m_underlying_price;
+}
+
+optional<greeks_t> portfolio_greeks::position(instrument_id_t id) const {
+  auto const position = m_positions.find(id);
+  if (position == m_positions.end() || !m_valid[position->second]) {
+    return boost::none;
+  }
+  auto const index = position->second;
+  return greeks_t{m_delta[index], m_gamma[index], m_speed[index],
+                  m_vega[index], m_theta[index], 0};
+}
+
+greeks_t portfolio_greeks::total(instrument_id_t underlying) const {
+  auto const underlying_index = m_underlyings.find(underlying);
+  if (underlying_index == m_underlyings.end()) {
+    return {0, 0, 0, 0, 0, 0};
+  }
+  return m_underlying_totals[underlying_index->second];
+}
+
+greeks_t portfolio_greeks::estimate(instrument_id_t underlying,
+                                    double price) const {
+  auto const underlying_index = m_underlyings.find(underlying);
+  if (underlying_index == m_underlyings.end()) {
+    return {0, 0, 0, 0, 0, 0};
+  }
+
+  auto greeks = m_underlying_totals[underlying_index->second];
+  auto const move = price - m_priced_price[underlying_index->second];
+  if (!std::isfinite(move)) {
+    greeks.missing = std::max<size_t>(greeks.missing, 1);
+    return greeks;
+  }
+
+  // Second order expansion of delta, first order of gamma
+  greeks.delta += greeks.gamma * move + 0.5 * greeks.speed * move * move;
+  greeks.gamma += greeks.speed * move;
+  return greeks;
+}
+
+bool portfolio_greeks::is_stale() const { return !m_stale.empty(); }
+
+greeks_t portfolio_greeks::total(instrument_id_t underlying,
+                                 ptime const &maturity_date) const {
+  auto const underlying_index = m_underlyings.find(underlying);
+  if (underlying_index == m_underlyings.end()) {
+    return {0, 0, 0, 0, 0, 0};
+  }
+  auto const bucket =
+      m_buckets.find(std::make_pair(underlying_index->second, maturity_date));
+  if (bucket == m_buckets.end()) {
+    return {0, 0, 0, 0, 0, 0};
+  }
+  return m_bucket_totals[bucket->second];
+}
+
+void portfolio_greeks::invalidate(size_t position) {
+  if (!m_is_stale[position]) {
+    m_is_stale[position] = true;
+    m_stale.push_back(position);
+  }
+}
+
+void portfolio_greeks::apply(size_t position, greeks_t const &greeks) {
+  auto const old = m_valid[position]
+                       ? greeks_t{m_delta[position], m_gamma[position],
+                                  m_speed[position], m_vega[position],
+                                  m_theta[position], 0}
+                       : details::no_greeks;
+  auto const &updated = greeks.missing ? details::no_greeks : greeks;
+
+  details::move_contribution(m_underlying_totals[m_underlying[position]], old,
+                             updated);
+  details::move_contribution(m_bucket_totals[m_bucket[position]], old,
+                             updated);
+
+  m_delta[position] = updated.delta;
+  m_gamma[position] = updated.gamma;
+  m_speed[position] = updated.speed;
+  m_vega[position] = updated.vega;
+  m_theta[position] = updated.theta;
+  m_valid[position] = updated.missing == 0;
+}
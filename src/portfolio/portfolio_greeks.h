@@ -0,0 +1,115 @@
+#pragma once
+
+#include "../instruments/instrument_registry.h"
+
+#include <map>
+#include <unordered_map>
+
+/**
+ * Greeks of a set of positions.
+ *
+ * Delta is in units of the underlying currency (what has to be hedged with
+ * the future), gamma per USD of underlying move and speed per USD of gamma's
+ * move, vega per unit of volatility and theta per year, both in USD
+ */
+struct greeks_t {
+  double delta;
+  double gamma;
+  double speed;
+  double vega;
+  double theta;
+
+  // Positions that are part of the total but have no greeks yet
+  size_t missing;
+};
+
+/**
+ * Keeps the greeks of every position of the portfolio.
+ *
+ * Per position values live in contiguous arrays and only the positions whose
+ * instrument or underlying changed are priced again. Totals by underlying and
+ * by underlying and maturity are kept updated with the difference of every
+ * repriced position, so reading them doesn't depend on the number of positions
+ */
+class portfolio_greeks {
+ public:
+  /** Constructor */
+  portfolio_greeks();
+
+  /** Adds a position or changes its quantity (negative when short) */
+  void set_position(instrument_id_t id, instrument_t const &instrument,
+                    instrument_id_t underlying, double quantity);
+
+  /** Sets the volatility of an option, its positions will be repriced */
+  void set_volatility(instrument_id_t id, double volatility);
+
+  /** Sets the price of an underlying, its positions will be repriced */
+  void set_underlying_price(instrument_id_t underlying, double price);
+
+  /** Prices again the positions that changed since the last update */
+  void update(ptime const &now, double interest_rate);
+
+  /** @returns the greeks of a position */
+  optional<greeks_t> position(instrument_id_t id) const;
+
+  /** @returns the greeks of every position with that underlying */
+  greeks_t total(instrument_id_t underlying) const;
+
+  /**
+   * @returns the greeks of every position with that underlying at another
+   * underlying price, expanded from the last update with gamma and speed
+   * instead of pricing again. Only delta and gamma are moved
+   */
+  greeks_t estimate(instrument_id_t underlying, double price) const;
+
+  /** @returns if there are positions to price in the next update */
+  bool is_stale() const;
+
+  /** @returns the greeks of every position with that underlying and maturity */
+  greeks_t total(instrument_id_t underlying, ptime const &maturity_date) const;
+
+ private:
+  // Marks a position to be priced in the next update
+  void invalidate(size_t position);
+
+  // Moves a position's contribution from the old greeks to the new ones
+  void apply(size_t position, greeks_t const &greeks);
+
+  // Position data
+  vector<instrument_id_t> m_instrument;
+  vector<size_t> m_underlying;
+  vector<size_t> m_bucket;
+  vector<double> m_quantity;
+  vector<double> m_multiplier;
+  vector<double> m_strike;
+  vector<optional<option_type_t>> m_put_call;
+  vector<ptime> m_maturity_date;
+  vector<double> m_volatility;
+
+  // Greeks by position
+  vector<double> m_delta;
+  vector<double> m_gamma;
+  vector<double> m_speed;
+  vector<double> m_vega;
+  vector<double> m_theta;
+  vector<bool> m_valid;
+
+  // Positions to price in the next update
+  vector<size_t> m_stale;
+  vector<bool> m_is_stale;
+
+  // Underlyings: prices, price of the last update, positions depending on
+  // them and totals
+  std::unordered_map<instrument_id_t, size_t> m_underlyings;
+  vector<double> m_underlying_price;
+  vector<double> m_priced_price;
+  vector<vector<size_t>> m_underlying_positions;
+  vector<greeks_t> m_underlying_totals;
+
+  // Totals by underlying and maturity
+  std::map<std::pair<size_t, ptime>, size_t> m_buckets;
+  vector<greeks_t> m_bucket_totals;
+
+  // Position of every instrument
+  std::unordered_map<instrument_id_t, size_t> m_positions;
+};
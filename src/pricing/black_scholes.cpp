@@ -1,6 +1,7 @@
 #include "black_scholes.h"
 
 #include <complex>
+#include <limits>
 
 namespace details {
 
@@ -67,8 +68,16 @@ double black_scholes_d2(double time_to_expiration, double volatility,
   return d1 - (volatility * std::sqrt(time_to_expiration));
 }
 
+double normal_density(double x) {
+  return std::exp(-(x * x) / 2.0) / 2.506628274631;
+}
+
 }  // namespace details
 
+double years_to_expiration(ptime const &maturity_date, ptime const &now) {
+  return (maturity_date.date() - now.date()).days() / 360.0;
+}
+
 double generalized_black_scholes_merton(option_type_t call_or_put,
                                         double stock_price, double strike_price,
                                         double risk_free_interest,
@@ -156,6 +165,91 @@ optional<double> black_scholes_implied_volatility(
   return volatility;
 }
 
+void black_scholes_implied_volatilities(
+    vector<option_type_t> const &call_or_put, double stock_price,
+    vector<double> const &strike_prices, double time_to_expiration,
+    double risk_free_interest, double cost_of_carry,
+    vector<double> const &option_market_prices, vector<double> &volatilities) {
+  int const MAX_ITERATIONS = 100;
+  double const epsilon = 0.000008;
+  auto const count = strike_prices.size();
+  volatilities.assign(count, std::numeric_limits<double>::quiet_NaN());
+
+  // Terms of the maturity, shared by every evaluation of every option
+  auto const carried_stock =
+      stock_price *
+      std::exp((cost_of_carry - risk_free_interest) * time_to_expiration);
+  auto const discount = std::exp(-risk_free_interest * time_to_expiration);
+  auto const square_root_time = std::sqrt(time_to_expiration);
+  auto const drift = cost_of_carry * time_to_expiration;
+
+  // State of the solver of every option, the same steps as a single one
+  vector<double> moneyness(count);
+  vector<double> volatility_low(count, 0.05);
+  vector<double> volatility_high(count, 5);
+  vector<double> price_low(count);
+  vector<double> price_high(count);
+  vector<double> volatility(count);
+  vector<double> price(count);
+
+  auto const option_price = [&](size_t index, double sigma) {
+    auto const deviation = sigma * square_root_time;
+    auto const d1 = (moneyness[index] + drift) / deviation + deviation / 2;
+    auto const d2 = d1 - deviation;
+    auto const discounted_strike = strike_prices[index] * discount;
+    if (call_or_put[index] == option_type_t::CALL) {
+      return carried_stock * details::cummulative_normal_distribution_hart(d1) -
+             discounted_strike *
+                 details::cummulative_normal_distribution_hart(d2);
+    }
+    return discounted_strike *
+               details::cummulative_normal_distribution_hart(-d2) -
+           carried_stock * details::cummulative_normal_distribution_hart(-d1);
+  };
+  auto const interpolate = [&](size_t index) {
+    return volatility_low[index] +
+           (option_market_prices[index] - price_low[index]) *
+               ((volatility_high[index] - volatility_low[index]) /
+                (price_high[index] - price_low[index]));
+  };
+
+  vector<size_t> solving(count);
+  for (size_t index = 0; index < count; ++index) {
+    moneyness[index] = std::log(stock_price / strike_prices[index]);
+    price_low[index] = option_price(index, volatility_low[index]);
+    price_high[index] = option_price(index, volatility_high[index]);
+    volatility[index] = interpolate(index);
+    price[index] = option_price(index, volatility[index]);
+    solving[index] = index;
+  }
+
+  // Every option steps once per iteration until it converges or gives up
+  for (int iteration = 1; !solving.empty(); ++iteration) {
+    size_t kept = 0;
+    for (auto const index : solving) {
+      if (!(std::abs(option_market_prices[index] - price[index]) > epsilon)) {
+        volatilities[index] = volatility[index];
+        continue;
+      }
+      if (iteration == MAX_ITERATIONS) {
+        continue;
+      }
+
+      if (price[index] < option_market_prices[index]) {
+        volatility_low[index] = volatility[index];
+        price_low[index] = price[index];
+      } else {
+        volatility_high[index] = volatility[index];
+        price_high[index] = price[index];
+      }
+      volatility[index] = interpolate(index);
+      price[index] = option_price(index, volatility[index]);
+      solving[kept++] = index;
+    }
+    solving.resize(kept);
+  }
+}
+
 double black_scholes_delta(option_type_t call_or_put, double stock_price,
                            double strike_price, double risk_free_interest,
                            double time_to_expiration, double cost_of_carry,
@@ -168,3 +262,61 @@ double black_scholes_delta(option_type_t call_or_put, double stock_price,
   return std::exp((cost_of_carry - risk_free_interest) * time_to_expiration) *
          details::cummulative_normal_distribution_hart(d1);
 }
+
+double black_scholes_gamma(double stock_price, double strike_price,
+                           double risk_free_interest, double time_to_expiration,
+                           double cost_of_carry, double volatility) {
+  double d1 = details::black_scholes_d1(
+      stock_price, strike_price, time_to_expiration, cost_of_carry, volatility);
+  return std::exp((cost_of_carry - risk_free_interest) * time_to_expiration) *
+         details::normal_density(d1) /
+         (stock_price * volatility * std::sqrt(time_to_expiration));
+}
+
+double black_scholes_speed(double stock_price, double strike_price,
+                           double risk_free_interest, double time_to_expiration,
+                           double cost_of_carry, double volatility) {
+  double d1 = details::black_scholes_d1(
+      stock_price, strike_price, time_to_expiration, cost_of_carry, volatility);
+  double gamma = black_scholes_gamma(stock_price, strike_price,
+                                     risk_free_interest, time_to_expiration,
+                                     cost_of_carry, volatility);
+  return -gamma / stock_price *
+         (1 + d1 / (volatility * std::sqrt(time_to_expiration)));
+}
+
+double black_scholes_vega(double stock_price, double strike_price,
+                          double risk_free_interest, double time_to_expiration,
+                          double cost_of_carry, double volatility) {
+  double d1 = details::black_scholes_d1(
+      stock_price, strike_price, time_to_expiration, cost_of_carry, volatility);
+  return stock_price *
+         std::exp((cost_of_carry - risk_free_interest) * time_to_expiration) *
+         details::normal_density(d1) * std::sqrt(time_to_expiration);
+}
+
+double black_scholes_theta(option_type_t call_or_put, double stock_price,
+                           double strike_price, double risk_free_interest,
+                           double time_to_expiration, double cost_of_carry,
+                           double volatility) {
+  // clang-format off
+  double d1 = details::black_scholes_d1(stock_price, strike_price, time_to_expiration, cost_of_carry, volatility);
+  double d2 = details::black_scholes_d2(time_to_expiration, volatility, d1);
+  double carry = std::exp((cost_of_carry - risk_free_interest) * time_to_expiration);
+  double discount = std::exp(-risk_free_interest * time_to_expiration);
+  double decay = -(stock_price * carry * details::normal_density(d1) * volatility) / (2 * std::sqrt(time_to_expiration));
+  // clang-format on
+
+  if (option_type_t::PUT == call_or_put) {
+    return decay +
+           (cost_of_carry - risk_free_interest) * stock_price * carry *
+               details::cummulative_normal_distribution_hart(-d1) +
+           risk_free_interest * strike_price * discount *
+               details::cummulative_normal_distribution_hart(-d2);
+  }
+  return decay -
+         (cost_of_carry - risk_free_interest) * stock_price * carry *
+             details::cummulative_normal_distribution_hart(d1) -
+         risk_free_interest * strike_price * discount *
+             details::cummulative_normal_distribution_hart(d2);
+}
@@ -2,6 +2,11 @@
 
 #include "../definitions/basic_types.h"
 
+/**
+ * Time to expiration in years as used for pricing (days over 360)
+ */
+double years_to_expiration(ptime const &maturity_date, ptime const &now);
+
 /**
  * Calculates price of an option using the black-scholes-merton general formula
  */
@@ -20,6 +25,18 @@ optional<double> black_scholes_implied_volatility(
     double time_to_expiration, double risk_free_interest, double cost_of_carry,
     double option_market_price);
 
+/**
+ * Extracts the implied volatilities of several options with the same
+ * underlying and maturity. They are solved together, the discount, carry and
+ * moneyness are computed once instead of on every iteration. Volatilities that
+ * can't be found are NaN
+ */
+void black_scholes_implied_volatilities(
+    vector<option_type_t> const &call_or_put, double stock_price,
+    vector<double> const &strike_prices, double time_to_expiration,
+    double risk_free_interest, double cost_of_carry,
+    vector<double> const &option_market_prices, vector<double> &volatilities);
+
 /**
  * Extracts the delta of an option via black-scholes
  */
@@ -27,3 +44,33 @@ double black_scholes_delta(option_type_t call_or_put, double stock_price,
                            double strike_price, double risk_free_interest,
                            double time_to_expiration, double cost_of_carry,
                            double volatility);
+
+/**
+ * Extracts the gamma of an option via black-scholes (same for call and put)
+ */
+double black_scholes_gamma(double stock_price, double strike_price,
+                           double risk_free_interest, double time_to_expiration,
+                           double cost_of_carry, double volatility);
+
+/**
+ * Extracts the speed of an option via black-scholes, the change of gamma with
+ * the underlying price (same for call and put)
+ */
+double black_scholes_speed(double stock_price, double strike_price,
+                           double risk_free_interest, double time_to_expiration,
+                           double cost_of_carry, double volatility);
+
+/**
+ * Extracts the vega of an option via black-scholes (same for call and put)
+ */
+double black_scholes_vega(double stock_price, double strike_price,
+                          double risk_free_interest, double time_to_expiration,
+                          double cost_of_carry, double volatility);
+
+/**
+ * Extracts the theta of an option via black-scholes. Per year
+ */
+double black_scholes_theta(option_type_t call_or_put, double stock_price,
+                           double strike_price, double risk_free_interest,
+                           double time_to_expiration, double cost_of_carry,
+                           double volatility);
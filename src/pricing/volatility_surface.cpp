@@ -0,0 +1,214 @@
+#include "volatility_surface.h"
+
+#include "black_scholes.h"
+
+#include <algorithm>
+#include <cmath>
+
+volatility_surface::volatility_surface(option_chain &chain, size_t grid_size)
+    : m_chain(chain),
+      m_smiles(),
+      m_grid_size(std::max<size_t>(grid_size, 2)),
+      m_underlying_price(0),
+      m_now() {
+  reset();
+}
+
+void volatility_surface::reset() {
+  m_smiles.assign(m_chain.expiries().size(), smile_t{0, 0, 0, 0, {}, true});
+}
+
+void volatility_surface::invalidate(instrument_id_t id) {
+  auto const location = m_chain.locate(id);
+  if (location && location->expiry < m_smiles.size()) {
+    m_smiles[location->expiry].dirty = true;
+  }
+}
+
+size_t volatility_surface::refit(double underlying_price, double interest_rate,
+                                 double refit_move, ptime const &now) {
+  m_underlying_price = underlying_price;
+
+  // A new day changes every time to expiration
+  if (m_now.is_special() || m_now.date() != now.date()) {
+    for (auto &smile : m_smiles) {
+      smile.dirty = true;
+    }
+  }
+  m_now = now;
+
+  // The quotes of the options follow the underlying, their volatilities are
+  // stale once it moved
+  for (auto &smile : m_smiles) {
+    if (smile.underlying_price <= 0 ||
+        std::abs(underlying_price / smile.underlying_price - 1) > refit_move) {
+      smile.dirty = true;
+    }
+  }
+
+  size_t fitted = 0;
+  for (size_t expiry = 0; expiry < m_smiles.size(); ++expiry) {
+    if (m_smiles[expiry].dirty) {
+      fit(expiry, interest_rate);
+      ++fitted;
+    }
+  }
+  return fitted;
+}
+
+optional<double> volatility_surface::volatility(size_t expiry,
+                                                double strike) const {
+  if (expiry >= m_smiles.size() || m_underlying_price <= 0 || strike <= 0) {
+    return boost::none;
+  }
+  return volatility(m_smiles[expiry], std::log(strike / m_underlying_price));
+}
+
+optional<double> volatility_surface::volatility(
+    double strike, ptime const &maturity_date) const {
+  auto const &expiries = m_chain.expiries();
+  auto const time_to_expiration = years_to_expiration(maturity_date, m_now);
+  if (m_smiles.empty() || time_to_expiration <= 0) {
+    return boost::none;
+  }
+
+  // First maturity not before the one requested
+  auto const upper = std::lower_bound(
+      expiries.begin(), expiries.end(), maturity_date,
+      [](option_chain::expiry_t const &expiry, ptime const &date) {
+        return expiry.maturity_date < date;
+      });
+  auto const index = static_cast<size_t>(upper - expiries.begin());
+
+  // Flat outside the maturities of the chain
+  if (index == expiries.size()) {
+    return volatility(index - 1, strike);
+  }
+  if (index == 0 || upper->maturity_date == maturity_date) {
+    return volatility(index, strike);
+  }
+
+  auto const near = volatility(index - 1, strike);
+  auto const far = volatility(index, strike);
+  if (!near || !far) {
+    return near ? near : far;
+  }
+
+  // Linear interpolation of the total variance
+  auto const near_time = m_smiles[index - 1].time_to_expiration;
+  auto const far_time = m_smiles[index].time_to_expiration;
+  if (far_time <= near_time) {
+    return near;
+  }
+  auto const near_variance = *near * *near * near_time;
+  auto const far_variance = *far * *far * far_time;
+  auto const variance =
+      near_variance + (far_variance - near_variance) *
+                          (time_to_expiration - near_time) /
+                          (far_time - near_time);
+  return std::sqrt(variance / time_to_expiration);
+}
+
+void volatility_surface::fit(size_t expiry_index, double interest_rate) {
+  auto &expiry = m_chain.expiries()[expiry_index];
+  auto &smile = m_smiles[expiry_index];
+  auto const stock_price = m_underlying_price;
+
+  smile.dirty = false;
+  smile.underlying_price = stock_price;
+  smile.volatilities.clear();
+  smile.time_to_expiration = years_to_expiration(expiry.maturity_date, m_now);
+  if (smile.time_to_expiration <= 0 || stock_price <= 0) {
+    return;
+  }
+
+  // Out of the money leg of every strike with both sides quoted
+  vector<option_type_t> types;
+  vector<double> strikes;
+  vector<double> prices;
+  vector<size_t> slots;
+  for (size_t index = 0; index < expiry.strikes.size(); ++index) {
+    auto const strike = expiry.strikes[index];
+    auto const type =
+        strike < stock_price ? option_type_t::PUT : option_type_t::CALL;
+    auto const &leg = type == option_type_t::PUT ? expiry.puts : expiry.calls;
+    if (std::isnan(leg.bid[index]) || std::isnan(leg.ask[index])) {
+      continue;
+    }
+
+    types.push_back(type);
+    strikes.push_back(strike);
+    // Quotes are in currency, the solver works in USD
+    prices.push_back((leg.bid[index] + leg.ask[index]) * 0.5 * stock_price);
+    slots.push_back(index);
+  }
+
+  vector<double> volatilities;
+  black_scholes_implied_volatilities(types, stock_price, strikes,
+                                     smile.time_to_expiration, interest_rate,
+                                     interest_rate, prices, volatilities);
+
+  // Storing the volatilities in the chain and keeping the valid points
+  vector<double> moneyness;
+  vector<double> points;
+  for (size_t point = 0; point < slots.size(); ++point) {
+    auto &leg = types[point] == option_type_t::PUT ? expiry.puts : expiry.calls;
+    leg.implied_volatility[slots[point]] = volatilities[point];
+    if (std::isfinite(volatilities[point]) && volatilities[point] > 0) {
+      moneyness.push_back(std::log(strikes[point] / stock_price));
+      points.push_back(volatilities[point]);
+    }
+  }
+
+  if (points.empty()) {
+    return;
+  }
+  if (points.size() == 1) {
+    smile.first_moneyness = moneyness.front();
+    smile.inverse_step = 0;
+    smile.volatilities.assign(1, points.front());
+    return;
+  }
+
+  // Resampling the piecewise linear smile on the uniform grid
+  auto const step = (moneyness.back() - moneyness.front()) / (m_grid_size - 1);
+  smile.first_moneyness = moneyness.front();
+  smile.inverse_step = 1.0 / step;
+  smile.volatilities.resize(m_grid_size);
+
+  size_t segment = 0;
+  for (size_t node = 0; node < m_grid_size; ++node) {
+    auto const x = smile.first_moneyness + node * step;
+    while (segment + 2 < moneyness.size() && moneyness[segment + 1] < x) {
+      ++segment;
+    }
+    auto const x0 = moneyness[segment];
+    auto const x1 = moneyness[segment + 1];
+    auto const weight = x1 > x0 ? std::min(1.0, std::max(0.0, (x - x0) /
+                                                                   (x1 - x0)))
+                                : 0.0;
+    smile.volatilities[node] =
+        points[segment] + (points[segment + 1] - points[segment]) * weight;
+  }
+}
+
+optional<double> volatility_surface::volatility(smile_t const &smile,
+                                                double moneyness) const {
+  auto const &volatilities = smile.volatilities;
+  if (volatilities.empty()) {
+    return boost::none;
+  }
+  if (volatilities.size() == 1) {
+    return volatilities.front();
+  }
+
+  // Flat outside the quoted strikes
+  auto const position = std::min(
+      static_cast<double>(volatilities.size() - 1),
+      std::max(0.0, (moneyness - smile.first_moneyness) * smile.inverse_step));
+  auto const node = std::min(static_cast<size_t>(position),
+                             volatilities.size() - 2);
+  auto const weight = position - node;
+  return volatilities[node] +
+         (volatilities[node + 1] - volatilities[node]) * weight;
+}
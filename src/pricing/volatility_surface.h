@@ -0,0 +1,67 @@
+#pragma once
+
+#include "../instruments/option_chain.h"
+
+/**
+ * Implied volatility surface built from the quotes cached in an option chain.
+ *
+ * Every maturity keeps its own smile in log-moneyness, solved from the out of
+ * the money mid prices and resampled on a uniform grid, so reading a volatility
+ * inside a smile costs O(1). Only the smiles whose quotes changed, or whose
+ * underlying moved too much, since the last fit are solved again. Between
+ * maturities the total variance is interpolated linearly in time.
+ */
+class volatility_surface {
+  // Smile of a single maturity
+  struct smile_t {
+    double time_to_expiration;
+    double underlying_price;
+    double first_moneyness;
+    double inverse_step;
+    vector<double> volatilities;
+    bool dirty;
+  };
+
+ public:
+  /** Constructor */
+  volatility_surface(option_chain &chain, size_t grid_size = 64);
+
+  /** Rebuilds the smiles after the chain was rebuilt */
+  void reset();
+
+  /** Marks the smile of an option as stale after its quote changed */
+  void invalidate(instrument_id_t id);
+
+  /**
+   * Fits again the stale smiles, and those fitted with an underlying price
+   * more than refit_move away, relatively. @returns how many were fitted
+   */
+  size_t refit(double underlying_price, double interest_rate,
+               double refit_move, ptime const &now);
+
+  /** @returns the volatility for a strike in one of the chain's maturities */
+  optional<double> volatility(size_t expiry, double strike) const;
+
+  /** @returns the volatility for any strike and maturity */
+  optional<double> volatility(double strike, ptime const &maturity_date) const;
+
+ private:
+  // Solves the implied volatilities of a maturity and fits its smile
+  void fit(size_t expiry, double interest_rate);
+
+  // Volatility of a smile at a log-moneyness
+  optional<double> volatility(smile_t const &smile, double moneyness) const;
+
+  // Chain providing the quotes and storing the implied volatilities
+  option_chain &m_chain;
+
+  // Smiles by maturity, same order as the chain
+  vector<smile_t> m_smiles;
+
+  // Points of every smile
+  size_t m_grid_size;
+
+  // Market used in the last fit
+  double m_underlying_price;
+  ptime m_now;
+};
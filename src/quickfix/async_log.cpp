@@ -0,0 +1,463 @@
+#include "async_log.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace FIX {
+
+namespace details {
+
+// Entries written at once, three buffers each
+size_t const log_batch_size = 256;
+
+// Time the writer sleeps when there's nothing to write
+auto const log_writer_idle = std::chrono::milliseconds(1);
+
+// Bytes of the time before every entry, "YYYYMMDD-HH:MM:SS.fffffffff : "
+size_t const log_time_size = 30;
+
+/**
+ * @returns the smallest power of two not lower than the value
+ */
+size_t next_power_of_two(size_t value) {
+  size_t power = 1;
+  while (power < value) {
+    power <<= 1;
+  }
+  return power;
+}
+
+/**
+ * Formats a time as the FileLog does
+ */
+void format_log_time(timespec const &time, char *buffer) {
+  std::tm calendar;
+  gmtime_r(&time.tv_sec, &calendar);
+  std::snprintf(buffer, log_time_size + 1,
+                "%04d%02d%02d-%02d:%02d:%02d.%09ld : ",
+                calendar.tm_year + 1900, calendar.tm_mon + 1,
+                calendar.tm_mday, calendar.tm_hour, calendar.tm_min,
+                calendar.tm_sec, time.tv_nsec);
+}
+
+/**
+ * Writes every buffer, whatever the system takes at each call
+ */
+void write_buffers(int descriptor, iovec *buffers, size_t count) {
+  while (count > 0) {
+    auto written = writev(descriptor, buffers, static_cast<int>(count));
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      std::cerr << "Impossible to write the log: " << std::strerror(errno)
+                << std::endl;
+      return;
+    }
+
+    // Skips what was written
+    while (count > 0 && static_cast<size_t>(written) >= buffers->iov_len) {
+      written -= buffers->iov_len;
+      ++buffers;
+      --count;
+    }
+    if (count > 0) {
+      buffers->iov_base = static_cast<char *>(buffers->iov_base) + written;
+      buffers->iov_len -= written;
+    }
+  }
+}
+
+/**
+ * Compresses a file with zlib, removing it once compressed
+ */
+void compress_file(string const &file_name) {
+  auto *const input = std::fopen(file_name.c_str(), "rb");
+  auto const output = gzopen((file_name + ".gz").c_str(), "wb");
+  if (input == nullptr || output == nullptr) {
+    std::cerr << "Impossible to compress " << file_name << std::endl;
+    if (input != nullptr) {
+      std::fclose(input);
+    }
+    if (output != nullptr) {
+      gzclose(output);
+    }
+    return;
+  }
+
+  char buffer[1 << 16];
+  size_t read = 0;
+  bool compressed = true;
+  while ((read = std::fread(buffer, 1, sizeof(buffer), input)) > 0) {
+    if (gzwrite(output, buffer, static_cast<unsigned>(read)) == 0) {
+      compressed = false;
+      break;
+    }
+  }
+  std::fclose(input);
+  compressed &= gzclose(output) == Z_OK;
+
+  // The original is kept when something went wrong
+  if (compressed) {
+    std::remove(file_name.c_str());
+  } else {
+    std::cerr << "Impossible to compress " << file_name << std::endl;
+  }
+}
+
+}  // namespace details
+
+async_log::async_log(string const &prefix, settings_t const &settings,
+                     std::function<void(string const &)> rotated)
+    : m_settings(settings),
+      m_rotated(std::move(rotated)),
+      m_ring(),
+      m_enqueue(0),
+      m_dequeue(0),
+      m_messages{prefix + ".messages", -1, 0, 0},
+      m_events{prefix + ".event", -1, 0, 0} {
+  m_settings.ring_size = details::next_power_of_two(settings.ring_size);
+  m_ring.reset(new entry_t[m_settings.ring_size]);
+  for (size_t position = 0; position < m_settings.ring_size; ++position) {
+    m_ring[position].sequence.store(position, std::memory_order_relaxed);
+  }
+
+  open(m_messages);
+  open(m_events);
+}
+
+async_log::~async_log() {
+  while (write()) {
+  }
+  ::close(m_messages.descriptor);
+  ::close(m_events.descriptor);
+}
+
+void async_log::clear() { push(kind_t::CLEAR, std::string()); }
+
+void async_log::backup() { push(kind_t::BACKUP, std::string()); }
+
+void async_log::onIncoming(std::string const &message) {
+  push(kind_t::MESSAGE, message);
+}
+
+void async_log::onOutgoing(std::string const &message) {
+  push(kind_t::MESSAGE, message);
+}
+
+void async_log::onEvent(std::string const &event) {
+  push(kind_t::EVENT, event);
+}
+
+bool async_log::write() {
+  // Entries completely copied, in order
+  size_t ready = 0;
+  while (ready < details::log_batch_size) {
+    auto const position = m_dequeue + ready;
+    auto const &entry = m_ring[position & (m_settings.ring_size - 1)];
+    if (entry.sequence.load(std::memory_order_acquire) != position + 1) {
+      break;
+    }
+    ++ready;
+  }
+  if (ready == 0) {
+    return false;
+  }
+
+  // Consecutive entries of the same file go in a single write
+  auto begin = m_dequeue;
+  auto const end = m_dequeue + ready;
+  while (begin < end) {
+    auto const kind = m_ring[begin & (m_settings.ring_size - 1)].kind;
+    auto last = begin + 1;
+    while (last < end &&
+           m_ring[last & (m_settings.ring_size - 1)].kind == kind) {
+      ++last;
+    }
+
+    switch (kind) {
+      case kind_t::MESSAGE:
+        write_entries(m_messages, begin, last);
+        break;
+      case kind_t::EVENT:
+        write_entries(m_events, begin, last);
+        break;
+      case kind_t::CLEAR:
+        ftruncate(m_messages.descriptor, 0);
+        ftruncate(m_events.descriptor, 0);
+        m_messages.size = 0;
+        m_events.size = 0;
+        break;
+      case kind_t::BACKUP:
+        rotate(m_messages);
+        rotate(m_events);
+        break;
+    }
+    begin = last;
+  }
+
+  // Slots available again for the next lap of the ring
+  for (auto position = m_dequeue; position < end; ++position) {
+    m_ring[position & (m_settings.ring_size - 1)].sequence.store(
+        position + m_settings.ring_size, std::memory_order_release);
+  }
+  m_dequeue = end;
+
+  rotate_if_needed(m_messages);
+  rotate_if_needed(m_events);
+  return true;
+}
+
+void async_log::push(kind_t kind, std::string const &text) {
+  auto position = m_enqueue.load(std::memory_order_relaxed);
+  while (true) {
+    auto &entry = m_ring[position & (m_settings.ring_size - 1)];
+    auto const sequence = entry.sequence.load(std::memory_order_acquire);
+    if (sequence == position) {
+      if (m_enqueue.compare_exchange_weak(position, position + 1,
+                                          std::memory_order_relaxed)) {
+        entry.kind = kind;
+        clock_gettime(CLOCK_REALTIME, &entry.time);
+        entry.text.assign(text);
+        entry.sequence.store(position + 1, std::memory_order_release);
+        return;
+      }
+    } else if (sequence < position) {
+      // Full, the writer is a lap behind
+      std::this_thread::yield();
+      position = m_enqueue.load(std::memory_order_relaxed);
+    } else {
+      position = m_enqueue.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+void async_log::write_entries(file_t &file, size_t begin, size_t end) {
+  if (file.descriptor < 0) {
+    return;
+  }
+
+  char times[details::log_batch_size][details::log_time_size + 1];
+  iovec buffers[details::log_batch_size * 3];
+  char newline = '\n';
+
+  size_t count = 0;
+  for (auto position = begin; position < end; ++position) {
+    auto &entry = m_ring[position & (m_settings.ring_size - 1)];
+    auto *const time = times[position - begin];
+    details::format_log_time(entry.time, time);
+    buffers[count++] = {time, details::log_time_size};
+    buffers[count++] = {&entry.text[0], entry.text.size()};
+    buffers[count++] = {&newline, 1};
+    file.size += details::log_time_size + entry.text.size() + 1;
+  }
+  details::write_buffers(file.descriptor, buffers, count);
+}
+
+void async_log::open(file_t &file) {
+  auto const file_name = file.prefix + ".current.log";
+  file.descriptor =
+      ::open(file_name.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if (file.descriptor < 0) {
+    BOOST_THROW_EXCEPTION(ConfigError("Could not open " + file_name + ": " +
+                                      std::strerror(errno)));
+  }
+
+  struct stat status;
+  fstat(file.descriptor, &status);
+  file.size = static_cast<size_t>(status.st_size);
+  file.opened = std::time(nullptr);
+}
+
+void async_log::rotate(file_t &file) {
+  ::close(file.descriptor);
+
+  // Named after the time of the rotation, never replacing an older one
+  char time[32];
+  auto const now = std::time(nullptr);
+  std::tm calendar;
+  gmtime_r(&now, &calendar);
+  std::strftime(time, sizeof(time), "%Y%m%d-%H%M%S", &calendar);
+  auto rotated = file.prefix + "." + time + ".log";
+  for (int copy = 1; access(rotated.c_str(), F_OK) == 0; ++copy) {
+    rotated = file.prefix + "." + time + "-" + std::to_string(copy) + ".log";
+  }
+  std::rename((file.prefix + ".current.log").c_str(), rotated.c_str());
+
+  try {
+    open(file);
+  } catch (ConfigError const &error) {
+    // Logs are lost until the next rotation, the session goes on
+    std::cerr << error.what() << std::endl;
+    file.descriptor = -1;
+  }
+  m_rotated(rotated);
+}
+
+void async_log::rotate_if_needed(file_t &file) {
+  auto const too_big =
+      m_settings.rotate_bytes > 0 && file.size >= m_settings.rotate_bytes;
+  auto const too_old = m_settings.rotate_seconds > 0 &&
+                       std::time(nullptr) - file.opened >=
+                           m_settings.rotate_seconds;
+  if (too_big || too_old) {
+    rotate(file);
+  }
+}
+
+async_log_factory::async_log_factory(SessionSettings const &session_settings,
+                                     async_log::settings_t const &settings)
+    : m_session_settings(session_settings),
+      m_settings(settings),
+      m_logs(),
+      m_mutex(),
+      m_running(true),
+      m_writer(),
+      m_compressions(),
+      m_compressions_mutex(),
+      m_compressions_condition(),
+      m_compressor() {
+  m_writer = std::thread(&async_log_factory::process_writes, this);
+  if (m_settings.compress) {
+    m_compressor =
+        std::thread(&async_log_factory::process_compressions, this);
+  }
+}
+
+async_log_factory::~async_log_factory() {
+  // Under the lock the compressor checks it with, it can't miss the change
+  {
+    std::lock_guard<std::mutex> lock(m_compressions_mutex);
+    m_running = false;
+  }
+  m_writer.join();
+
+  if (m_compressor.joinable()) {
+    m_compressions_condition.notify_all();
+    m_compressor.join();
+
+    // Rotated by the last writes, once the compressor stopped
+    for (auto const &file : m_compressions) {
+      details::compress_file(file);
+    }
+  }
+}
+
+async_log::settings_t async_log_factory::load_settings(
+    config_file_t const &configuration) {
+  async_log::settings_t settings;
+  settings.ring_size =
+      config_file::get(configuration, "LogRingSize", settings.ring_size);
+  settings.rotate_bytes =
+      config_file::get(configuration, "LogRotateBytes", settings.rotate_bytes);
+  settings.rotate_seconds = config_file::get(
+      configuration, "LogRotateSeconds", settings.rotate_seconds);
+  settings.compress =
+      config_file::get<string>(configuration, "LogCompress", "N") == "Y";
+  settings.thread = threads::load_thread_settings(configuration, "Logging");
+  return settings;
+}
+
+Log *async_log_factory::create() {
+  auto const path = m_session_settings.get().getString(FILE_LOG_PATH);
+  return create_log(path + "/GLOBAL");
+}
+
+Log *async_log_factory::create(SessionID const &session_id) {
+  auto const path =
+      m_session_settings.get(session_id).getString(FILE_LOG_PATH);
+  auto prefix = session_id.getBeginString().getValue() + "-" +
+                session_id.getSenderCompID().getValue() + "-" +
+                session_id.getTargetCompID().getValue();
+  if (!session_id.getSessionQualifier().empty()) {
+    prefix += "-" + session_id.getSessionQualifier();
+  }
+  return create_log(path + "/" + prefix);
+}
+
+void async_log_factory::destroy(Log *log) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_logs.erase(static_cast<async_log *>(log));
+  }
+
+  // Writes what is left
+  delete log;
+}
+
+Log *async_log_factory::create_log(string const &prefix) {
+  auto const slash = prefix.find_last_of('/');
+  if (slash != string::npos) {
+    mkdir(prefix.substr(0, slash).c_str(), 0755);
+  }
+
+  auto *log = new async_log(prefix, m_settings, [this](string const &file) {
+    if (!m_settings.compress) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(m_compressions_mutex);
+    m_compressions.push_back(file);
+    m_compressions_condition.notify_one();
+  });
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_logs.insert(log);
+  return log;
+}
+
+void async_log_factory::process_writes() {
+  threads::apply_thread_settings(m_settings.thread);
+
+  while (true) {
+    auto const running = m_running.load();
+
+    bool written = false;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      for (auto *log : m_logs) {
+        written |= log->write();
+      }
+    }
+
+    // Everything logged before stopping is written
+    if (!running && !written) {
+      return;
+    }
+    if (!written) {
+      std::this_thread::sleep_for(details::log_writer_idle);
+    }
+  }
+}
+
+void async_log_factory::process_compressions() {
+  threads::apply_thread_settings(m_settings.thread);
+
+  std::unique_lock<std::mutex> lock(m_compressions_mutex);
+  while (true) {
+    m_compressions_condition.wait(lock, [this]() {
+      return !m_running || !m_compressions.empty();
+    });
+    if (m_compressions.empty()) {
+      return;
+    }
+
+    auto const file = m_compressions.front();
+    m_compressions.pop_front();
+    lock.unlock();
+    details::compress_file(file);
+    lock.lock();
+  }
+}
+
+}  // namespace FIX
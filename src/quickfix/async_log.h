@@ -0,0 +1,181 @@
+#pragma once
+
+#include "../config.h"
+#include "../threads/thread_settings.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+#include <quickfix/FileLog.h>
+#include <quickfix/SessionSettings.h>
+
+namespace FIX {
+
+/**
+ * Log writing from a thread of its own.
+ *
+ * Logging a message only copies its bytes and the time into a ring, without
+ * locks nor system calls. The writer thread of the factory formats the times
+ * and writes whatever is in the ring at once with writev, in the format of the
+ * FileLog, so the logs can still be replayed. Files are rotated by size or
+ * age, and compressed after being rotated when asked.
+ *
+ * When the ring is full the thread logging waits for the writer: no message is
+ * lost from the logs
+ */
+class async_log : public Log {
+ public:
+  // Size, rotation and compression of the logs
+  struct settings_t {
+    // Messages waiting to be written, a power of two
+    size_t ring_size = 1 << 16;
+
+    // Bytes and seconds before rotating a file, 0 to never do it
+    size_t rotate_bytes = 0;
+    long rotate_seconds = 0;
+
+    // Compresses the rotated files
+    bool compress = false;
+
+    // Writer and compressor threads of the factory, read with the "Logging"
+    // role
+    thread_settings_t thread;
+  };
+
+  /**
+   * Constructor. The files start with the prefix, rotated files are given to
+   * the callback
+   */
+  async_log(string const &prefix, settings_t const &settings,
+            std::function<void(string const &)> rotated);
+
+  /** Destructor. Writes what is left */
+  ~async_log();
+
+  async_log(async_log const &) = delete;
+  async_log &operator=(async_log const &) = delete;
+
+  /** Implementing Log interface */
+  void clear() override;
+  void backup() override;
+  void onIncoming(std::string const &message) override;
+  void onOutgoing(std::string const &message) override;
+  void onEvent(std::string const &event) override;
+
+  /**
+   * Writes what was logged since the last call. Only called from the writer
+   * @returns true if something was written
+   */
+  bool write();
+
+ private:
+  // What was logged
+  enum class kind_t { MESSAGE, EVENT, CLEAR, BACKUP };
+
+  // Slot of the ring, reused so its text keeps the memory
+  struct entry_t {
+    std::atomic<size_t> sequence;
+    kind_t kind;
+    timespec time;
+    std::string text;
+  };
+
+  // File being written and when it started
+  struct file_t {
+    string prefix;
+    int descriptor;
+    size_t size;
+    std::time_t opened;
+  };
+
+  // Copies an entry into the ring, waiting if it's full
+  void push(kind_t kind, std::string const &text);
+
+  // Writes the entries of the ring between two positions to a file
+  void write_entries(file_t &file, size_t begin, size_t end);
+
+  // Opens the current file of a prefix, appending
+  void open(file_t &file);
+
+  // Closes the current file and renames it with the time
+  void rotate(file_t &file);
+
+  // Rotates a file that grew or aged too much
+  void rotate_if_needed(file_t &file);
+
+  // Size, rotation and compression of the logs
+  settings_t m_settings;
+
+  // Receives the files rotated
+  std::function<void(string const &)> m_rotated;
+
+  // Messages waiting to be written. Any thread writes at the position to
+  // enqueue, only the writer reads
+  std::unique_ptr<entry_t[]> m_ring;
+  std::atomic<size_t> m_enqueue;
+  size_t m_dequeue;
+
+  // Files of the messages and of the events
+  file_t m_messages;
+  file_t m_events;
+};
+
+/**
+ * Creates asynchronous logs for the sessions, in their FileLogPath, and runs
+ * the threads writing and compressing them
+ */
+class async_log_factory : public LogFactory {
+ public:
+  /** Constructor. Starts the writer */
+  async_log_factory(SessionSettings const &session_settings,
+                    async_log::settings_t const &settings);
+
+  /** Destructor. Writes what is left and stops the threads */
+  ~async_log_factory();
+
+  /** @returns the settings read from the configuration */
+  static async_log::settings_t load_settings(
+      config_file_t const &configuration);
+
+  /** Implementing LogFactory interface */
+  Log *create() override;
+  Log *create(SessionID const &session_id) override;
+  void destroy(Log *log) override;
+
+ private:
+  // Creates a log and hands it to the writer
+  Log *create_log(string const &prefix);
+
+  // Writes the logs until stopped
+  void process_writes();
+
+  // Compresses the rotated files until stopped
+  void process_compressions();
+
+  // Settings of the sessions, where their logs go
+  SessionSettings m_session_settings;
+
+  // Size, rotation and compression of the logs
+  async_log::settings_t m_settings;
+
+  // Logs created, written by the writer
+  std::unordered_set<async_log *> m_logs;
+  std::mutex m_mutex;
+  std::atomic<bool> m_running;
+  std::thread m_writer;
+
+  // Rotated files waiting to be compressed
+  std::deque<string> m_compressions;
+  std::mutex m_compressions_mutex;
+  std::condition_variable m_compressions_condition;
+  std::thread m_compressor;
+};
+
+}  // namespace FIX
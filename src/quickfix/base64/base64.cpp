@@ -1,100 +1,327 @@
 #include "base64.h"
 
+#include <cstdint>
+#include <cstring>
+
+// Vectorized versions are built for x86 with GCC or Clang, and chosen at run
+// time depending on the processor
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BASE64_SIMD 1
+#include <immintrin.h>
+#endif
+
 namespace Deribit {
 
-static const std::string base64_chars =
+static char const base64_chars[] =
     "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
     "abcdefghijklmnopqrstuvwxyz"
     "0123456789+/";
 
-static inline bool is_base64(unsigned char c) {
-  return (isalnum(c) || (c == '+') || (c == '/'));
+// Value of every character, -1 when not in base64
+struct base64_values {
+  base64_values() {
+    std::memset(values, -1, sizeof(values));
+    for (int i = 0; i < 64; i++)
+      values[static_cast<unsigned char>(base64_chars[i])] =
+          static_cast<signed char>(i);
+  }
+  signed char values[256];
+};
+
+static base64_values const base64_table;
+
+size_t base64_encode_scalar(unsigned char const* bytes_to_encode,
+                            size_t in_len, char* output) {
+  char* out = output;
+
+  // Every 3 bytes are 4 characters
+  for (; in_len >= 3; in_len -= 3, bytes_to_encode += 3) {
+    unsigned int const triple = (bytes_to_encode[0] << 16) |
+                                (bytes_to_encode[1] << 8) | bytes_to_encode[2];
+    *out++ = base64_chars[(triple >> 18) & 0x3f];
+    *out++ = base64_chars[(triple >> 12) & 0x3f];
+    *out++ = base64_chars[(triple >> 6) & 0x3f];
+    *out++ = base64_chars[triple & 0x3f];
+  }
+
+  // The rest is padded
+  if (in_len) {
+    unsigned int triple = bytes_to_encode[0] << 16;
+    if (in_len == 2) triple |= bytes_to_encode[1] << 8;
+    *out++ = base64_chars[(triple >> 18) & 0x3f];
+    *out++ = base64_chars[(triple >> 12) & 0x3f];
+    *out++ = in_len == 2 ? base64_chars[(triple >> 6) & 0x3f] : '=';
+    *out++ = '=';
+  }
+
+  return static_cast<size_t>(out - output);
 }
 
-std::string base64_encode(unsigned char const* bytes_to_encode,
-                          unsigned int in_len) {
-  std::string ret;
+size_t base64_decode_scalar(char const* encoded, size_t in_len,
+                            unsigned char* output) {
+  unsigned char* out = output;
+  unsigned int quad = 0;
   int i = 0;
-  int j = 0;
-  unsigned char char_array_3[3];
-  unsigned char char_array_4[4];
-
-  while (in_len--) {
-    char_array_3[i++] = *(bytes_to_encode++);
-    if (i == 3) {
-      char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-      char_array_4[1] =
-          ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-      char_array_4[2] =
-          ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-      char_array_4[3] = char_array_3[2] & 0x3f;
-
-      for (i = 0; (i < 4); i++) ret += base64_chars[char_array_4[i]];
+
+  for (; in_len; in_len--, encoded++) {
+    auto const value =
+        base64_table.values[static_cast<unsigned char>(*encoded)];
+    if (value < 0) break;
+
+    quad = (quad << 6) | static_cast<unsigned int>(value);
+    if (++i == 4) {
+      *out++ = static_cast<unsigned char>(quad >> 16);
+      *out++ = static_cast<unsigned char>(quad >> 8);
+      *out++ = static_cast<unsigned char>(quad);
+      quad = 0;
       i = 0;
     }
   }
 
-  if (i) {
-    for (j = i; j < 3; j++) char_array_3[j] = '\0';
+  // A group cut short gives a byte less than its characters
+  if (i > 1) {
+    quad <<= 6 * (4 - i);
+    *out++ = static_cast<unsigned char>(quad >> 16);
+    if (i == 3) *out++ = static_cast<unsigned char>(quad >> 8);
+  }
+
+  return static_cast<size_t>(out - output);
+}
+
+#ifdef BASE64_SIMD
+
+// Encoding and decoding of 16 characters at once, or 32 with AVX2. Based on
+// the algorithms of Wojciech Mula and Daniel Lemire
+// (http://0x80.pl/notesen/2016-01-12-sse-base64-encoding.html and
+// http://0x80.pl/notesen/2016-01-17-sse-base64-decoding.html)
+
+__attribute__((target("sse4.1"))) static __m128i encode_block(__m128i in) {
+  // Every 3 bytes spread in 4 bytes of 6 bits
+  in = _mm_shuffle_epi8(
+      in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+  __m128i const t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+  __m128i const t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+  __m128i const t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+  __m128i const t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+  __m128i const indices = _mm_or_si128(t1, t3);
+
+  // Offset from the index to its character, by range of indices
+  __m128i const offsets = _mm_setr_epi8(
+      'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+      '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+  __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+  __m128i const upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+  range = _mm_or_si128(range, _mm_and_si128(upper, _mm_set1_epi8(13)));
+  return _mm_add_epi8(_mm_shuffle_epi8(offsets, range), indices);
+}
+
+__attribute__((target("sse4.1"))) static bool decode_block(__m128i in,
+                                                          __m128i* out) {
+  __m128i const higher = _mm_and_si128(_mm_srli_epi32(in, 4),
+                                       _mm_set1_epi8(0x0f));
+  __m128i const lower = _mm_and_si128(in, _mm_set1_epi8(0x0f));
 
-    char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-    char_array_4[1] =
-        ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-    char_array_4[2] =
-        ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-    char_array_4[3] = char_array_3[2] & 0x3f;
+  // Characters valid for every nibble, as bits of the higher nibble
+  __m128i const valid = _mm_setr_epi8(
+      char(0xa8), char(0xf8), char(0xf8), char(0xf8), char(0xf8), char(0xf8),
+      char(0xf8), char(0xf8), char(0xf8), char(0xf8), char(0xf0), char(0x54),
+      char(0x50), char(0x50), char(0x50), char(0x54));
+  __m128i const bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, char(0x80), 0, 0,
+                                     0, 0, 0, 0, 0, 0);
+  __m128i const matches = _mm_and_si128(_mm_shuffle_epi8(valid, lower),
+                                        _mm_shuffle_epi8(bits, higher));
+  if (_mm_movemask_epi8(_mm_cmpeq_epi8(matches, _mm_setzero_si128())))
+    return false;
 
-    for (j = 0; (j < i + 1); j++) ret += base64_chars[char_array_4[j]];
+  // Offset from the character to its value, by higher nibble. '/' apart
+  __m128i const offsets =
+      _mm_setr_epi8(0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  __m128i const slash = _mm_cmpeq_epi8(in, _mm_set1_epi8(0x2f));
+  __m128i const offset = _mm_blendv_epi8(_mm_shuffle_epi8(offsets, higher),
+                                         _mm_set1_epi8(16), slash);
+  __m128i const values = _mm_add_epi8(in, offset);
 
-    while ((i++ < 3)) ret += '=';
+  // Every 4 values of 6 bits packed in 3 bytes
+  __m128i const pairs =
+      _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+  __m128i const quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+  *out = _mm_shuffle_epi8(quads, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8,
+                                               14, 13, 12, -1, -1, -1, -1));
+  return true;
+}
+
+__attribute__((target("sse4.1"))) static size_t encode_sse(
+    unsigned char const* bytes_to_encode, size_t in_len, char* output) {
+  char* out = output;
+
+  // 12 bytes are encoded out of the 16 read
+  for (; in_len >= 16; in_len -= 12, bytes_to_encode += 12, out += 16) {
+    __m128i const in = _mm_loadu_si128(
+        reinterpret_cast<__m128i const*>(bytes_to_encode));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), encode_block(in));
   }
 
-  return ret;
+  return static_cast<size_t>(out - output) +
+         base64_encode_scalar(bytes_to_encode, in_len, out);
 }
 
-std::string base64_decode(std::string const& encoded_string) {
-  size_t in_len = encoded_string.size();
-  size_t i = 0;
-  size_t j = 0;
-  int in_ = 0;
-  unsigned char char_array_4[4], char_array_3[3];
-  std::string ret;
-
-  while (in_len-- && (encoded_string[in_] != '=') &&
-         is_base64(encoded_string[in_])) {
-    char_array_4[i++] = encoded_string[in_];
-    in_++;
-    if (i == 4) {
-      for (i = 0; i < 4; i++)
-        char_array_4[i] =
-            static_cast<unsigned char>(base64_chars.find(char_array_4[i]));
-
-      char_array_3[0] =
-          (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-      char_array_3[1] =
-          ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-      char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
-
-      for (i = 0; (i < 3); i++) ret += char_array_3[i];
-      i = 0;
-    }
+__attribute__((target("sse4.1"))) static size_t decode_sse(
+    char const* encoded, size_t in_len, unsigned char* output) {
+  unsigned char* out = output;
+
+  // 12 bytes are decoded out of the 16 stored, the rest of the input keeps
+  // the store in the buffer
+  for (; in_len >= 24; in_len -= 16, encoded += 16, out += 12) {
+    __m128i decoded;
+    if (!decode_block(
+            _mm_loadu_si128(reinterpret_cast<__m128i const*>(encoded)),
+            &decoded))
+      break;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), decoded);
   }
 
-  if (i) {
-    for (j = i; j < 4; j++) char_array_4[j] = 0;
+  return static_cast<size_t>(out - output) +
+         base64_decode_scalar(encoded, in_len, out);
+}
+
+__attribute__((target("avx2"))) static size_t encode_avx2(
+    unsigned char const* bytes_to_encode, size_t in_len, char* output) {
+  char* out = output;
 
-    for (j = 0; j < 4; j++)
-      char_array_4[j] =
-          static_cast<unsigned char>(base64_chars.find(char_array_4[j]));
+  // 24 bytes are encoded out of the 28 read, 12 for each lane
+  for (; in_len >= 32; in_len -= 24, bytes_to_encode += 24, out += 32) {
+    __m128i const low = _mm_loadu_si128(
+        reinterpret_cast<__m128i const*>(bytes_to_encode));
+    __m128i const high = _mm_loadu_si128(
+        reinterpret_cast<__m128i const*>(bytes_to_encode + 12));
+    __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
 
-    char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-    char_array_3[1] =
-        ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-    char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
+    in = _mm256_shuffle_epi8(
+        in, _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+                            10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    __m256i const t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+    __m256i const t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+    __m256i const t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+    __m256i const t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+    __m256i const indices = _mm256_or_si256(t1, t3);
 
-    for (j = 0; (j < i - 1); j++) ret += char_array_3[j];
+    __m256i const offsets = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0,
+        0));
+    __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+    __m256i const upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+    range = _mm256_or_si256(range,
+                            _mm256_and_si256(upper, _mm256_set1_epi8(13)));
+    __m256i const encoded =
+        _mm256_add_epi8(_mm256_shuffle_epi8(offsets, range), indices);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), encoded);
   }
 
+  // The rest is encoded by SSE code, slowed down by dirty upper halves
+  _mm256_zeroupper();
+  return static_cast<size_t>(out - output) +
+         encode_sse(bytes_to_encode, in_len, out);
+}
+
+__attribute__((target("avx2"))) static size_t decode_avx2(
+    char const* encoded, size_t in_len, unsigned char* output) {
+  unsigned char* out = output;
+
+  // 24 bytes are decoded out of the 32 stored
+  for (; in_len >= 48; in_len -= 32, encoded += 32, out += 24) {
+    __m256i const in =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(encoded));
+    __m256i const higher = _mm256_and_si256(_mm256_srli_epi32(in, 4),
+                                            _mm256_set1_epi8(0x0f));
+    __m256i const lower = _mm256_and_si256(in, _mm256_set1_epi8(0x0f));
+
+    __m256i const valid = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+        char(0xa8), char(0xf8), char(0xf8), char(0xf8), char(0xf8),
+        char(0xf8), char(0xf8), char(0xf8), char(0xf8), char(0xf8),
+        char(0xf0), char(0x54), char(0x50), char(0x50), char(0x50),
+        char(0x54)));
+    __m256i const bits = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+        1, 2, 4, 8, 16, 32, 64, char(0x80), 0, 0, 0, 0, 0, 0, 0, 0));
+    __m256i const matches =
+        _mm256_and_si256(_mm256_shuffle_epi8(valid, lower),
+                         _mm256_shuffle_epi8(bits, higher));
+    if (_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(matches, _mm256_setzero_si256())))
+      break;
+
+    __m256i const offsets = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+        0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0));
+    __m256i const slash = _mm256_cmpeq_epi8(in, _mm256_set1_epi8(0x2f));
+    __m256i const offset = _mm256_blendv_epi8(
+        _mm256_shuffle_epi8(offsets, higher), _mm256_set1_epi8(16), slash);
+    __m256i const values = _mm256_add_epi8(in, offset);
+
+    __m256i const pairs =
+        _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+    __m256i const quads =
+        _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+    __m256i const packed = _mm256_shuffle_epi8(
+        quads, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1,
+                                -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+                                -1, -1, -1, -1));
+
+    // The 12 bytes of every lane together
+    __m256i const decoded = _mm256_permutevar8x32_epi32(
+        packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), decoded);
+  }
+
+  // The rest is decoded by SSE code, slowed down by dirty upper halves
+  _mm256_zeroupper();
+  return static_cast<size_t>(out - output) + decode_sse(encoded, in_len, out);
+}
+
+#endif
+
+using encoder_t = size_t (*)(unsigned char const*, size_t, char*);
+using decoder_t = size_t (*)(char const*, size_t, unsigned char*);
+
+// Fastest versions supported by the processor
+static encoder_t select_encoder() {
+#ifdef BASE64_SIMD
+  if (__builtin_cpu_supports("avx2")) return encode_avx2;
+  if (__builtin_cpu_supports("sse4.1")) return encode_sse;
+#endif
+  return base64_encode_scalar;
+}
+
+static decoder_t select_decoder() {
+#ifdef BASE64_SIMD
+  if (__builtin_cpu_supports("avx2")) return decode_avx2;
+  if (__builtin_cpu_supports("sse4.1")) return decode_sse;
+#endif
+  return base64_decode_scalar;
+}
+
+size_t base64_encode(unsigned char const* bytes_to_encode, size_t in_len,
+                     char* output) {
+  static encoder_t const encoder = select_encoder();
+  return encoder(bytes_to_encode, in_len, output);
+}
+
+size_t base64_decode(char const* encoded, size_t in_len,
+                     unsigned char* output) {
+  static decoder_t const decoder = select_decoder();
+  return decoder(encoded, in_len, output);
+}
+
+std::string base64_encode(unsigned char const* bytes_to_encode,
+                          unsigned int in_len) {
+  std::string ret(base64_encoded_size(in_len), '\0');
+  base64_encode(bytes_to_encode, in_len, &ret[0]);
+  return ret;
+}
+
+std::string base64_decode(std::string const& encoded_string) {
+  std::string ret(base64_decoded_size(encoded_string.size()), '\0');
+  ret.resize(base64_decode(encoded_string.data(), encoded_string.size(),
+                           reinterpret_cast<unsigned char*>(&ret[0])));
   return ret;
 }
 
@@ -1,9 +1,27 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 
 namespace Deribit {
 
+// Characters encoding the given bytes, padding included
+constexpr size_t base64_encoded_size(size_t len) { return (len + 2) / 3 * 4; }
+
+// Bytes decoded from the given characters at most
+constexpr size_t base64_decoded_size(size_t len) { return (len + 3) / 4 * 3; }
+
+// Encodes into a buffer of base64_encoded_size(len) characters, returning them
+size_t base64_encode(unsigned char const*, size_t len, char* output);
+
+// Decodes into a buffer of base64_decoded_size(len) bytes, returning them.
+// Decoding stops at the padding or at the first character not in base64
+size_t base64_decode(char const*, size_t len, unsigned char* output);
+
+// Portable versions, the vectorized ones must give the same results
+size_t base64_encode_scalar(unsigned char const*, size_t len, char* output);
+size_t base64_decode_scalar(char const*, size_t len, unsigned char* output);
+
 std::string base64_encode(unsigned char const*, unsigned int len);
 std::string base64_decode(std::string const& s);
 
@@ -0,0 +1,409 @@
+#include "busy_poll_initiator.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace FIX {
+
+namespace details {
+
+// Seconds between reconnections when missing in the session settings
+int const default_reconnect_interval = 30;
+
+// Seconds between heartbeats when missing in the session settings
+int const default_heartbeat_interval = 30;
+
+// Bytes read from a socket at once
+size_t const read_buffer_size = 1 << 16;
+
+/**
+ * Sets an integer option of a socket, reporting it when not allowed
+ */
+void set_socket_option(int socket, int level, int option, int value,
+                       char const *name) {
+  if (setsockopt(socket, level, option, &value, sizeof(value)) != 0) {
+    std::cerr << "Impossible to set " << name << ": " << std::strerror(errno)
+              << std::endl;
+  }
+}
+
+/**
+ * Logs an event of a session, if it has a log
+ */
+void log_session_event(Session *session, std::string const &event) {
+  if (session != nullptr && session->getLog() != nullptr) {
+    session->getLog()->onEvent(event);
+  }
+}
+
+}  // namespace details
+
+busy_poll_initiator::connection_t::connection_t(int socket,
+                                                SessionID const &session_id,
+                                                int heartbeat_interval)
+    : socket(socket),
+      session_id(session_id),
+      session(nullptr),
+      connected(false),
+      parser(),
+      message(),
+      heartbeat_interval(heartbeat_interval),
+      last_session_message(),
+      m_mutex(),
+      m_pending(),
+      m_closing(false) {}
+
+busy_poll_initiator::connection_t::~connection_t() { ::close(socket); }
+
+bool busy_poll_initiator::connection_t::send(std::string const &message) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_closing) {
+    return false;
+  }
+  m_pending.append(message);
+  return write();
+}
+
+void busy_poll_initiator::connection_t::disconnect() {
+  // Closed from the thread of the initiator, it may be reading now
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_closing = true;
+}
+
+void busy_poll_initiator::connection_t::flush() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!m_closing && !m_pending.empty()) {
+    write();
+  }
+}
+
+bool busy_poll_initiator::connection_t::closing() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_closing;
+}
+
+bool busy_poll_initiator::connection_t::write() {
+  size_t written = 0;
+  while (written < m_pending.size()) {
+    auto const result = ::send(socket, m_pending.data() + written,
+                               m_pending.size() - written, MSG_NOSIGNAL);
+    if (result > 0) {
+      written += static_cast<size_t>(result);
+      continue;
+    }
+    if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      // The rest goes when the socket takes it
+      break;
+    }
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    m_closing = true;
+    return false;
+  }
+  m_pending.erase(0, written);
+  return true;
+}
+
+busy_poll_initiator::busy_poll_initiator(
+    Application &application, MessageStoreFactory &store_factory,
+    SessionSettings const &session_settings, LogFactory &log_factory,
+    settings_t const &settings)
+    : Initiator(application, store_factory, session_settings, log_factory),
+      m_settings(settings),
+      m_reconnect_interval(details::default_reconnect_interval),
+      m_fast_paths(),
+      m_last_timer(0),
+      m_last_connect(0),
+      m_connections() {}
+
+busy_poll_initiator::~busy_poll_initiator() { m_connections.clear(); }
+
+busy_poll_initiator::settings_t busy_poll_initiator::load_settings(
+    config_file_t const &configuration) {
+  settings_t settings;
+  settings.spin =
+      config_file::get<string>(configuration, "BusyPollSpin", "Y") == "Y";
+  settings.socket_busy_poll = config_file::get(
+      configuration, "BusyPollSocketMicroseconds", settings.socket_busy_poll);
+  settings.quick_ack =
+      config_file::get<string>(configuration, "BusyPollQuickAck", "Y") == "Y";
+  settings.poll_timeout = config_file::get(
+      configuration, "BusyPollTimeoutMilliseconds", settings.poll_timeout);
+  settings.fast_decoder =
+      config_file::get<string>(configuration, "BusyPollFastDecoder", "N") ==
+      "Y";
+  return settings;
+}
+
+void busy_poll_initiator::set_fast_path(string const &type,
+                                        fast_path_t fast_path) {
+  if (m_settings.fast_decoder) {
+    m_fast_paths[type] = std::move(fast_path);
+  }
+}
+
+void busy_poll_initiator::onConfigure(
+    SessionSettings const &session_settings) throw(ConfigError) {
+  auto const &defaults = session_settings.get();
+  if (defaults.has(RECONNECT_INTERVAL)) {
+    m_reconnect_interval = defaults.getInt(RECONNECT_INTERVAL);
+  }
+}
+
+void busy_poll_initiator::onStart() {
+  while (!isStopped()) {
+    auto const received = poll_connections();
+    on_timer();
+
+    // Without spinning the thread sleeps until a socket is ready
+    if (!received && !m_settings.spin && !m_connections.empty()) {
+      std::vector<pollfd> sockets;
+      for (auto const &connection : m_connections) {
+        auto const events = connection->connected ? POLLIN : POLLOUT;
+        sockets.push_back({connection->socket, static_cast<short>(events), 0});
+      }
+      ::poll(sockets.data(), sockets.size(), m_settings.poll_timeout);
+    }
+  }
+
+  for (auto &connection : m_connections) {
+    close(*connection);
+  }
+  m_connections.clear();
+}
+
+bool busy_poll_initiator::onPoll(double /*timeout*/) {
+  if (isStopped()) {
+    return false;
+  }
+  poll_connections();
+  on_timer();
+  return true;
+}
+
+void busy_poll_initiator::onStop() {
+  // The thread of the initiator closes the connections on its way out
+}
+
+void busy_poll_initiator::doConnect(SessionID const &session_id,
+                                    Dictionary const &dictionary) {
+  auto *session = Session::lookupSession(session_id);
+  auto const host = dictionary.getString(SOCKET_CONNECT_HOST);
+  auto const port = std::to_string(dictionary.getInt(SOCKET_CONNECT_PORT));
+  details::log_session_event(session,
+                             "Connecting to " + host + " on port " + port);
+
+  addrinfo hints{};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo *address = nullptr;
+  auto const error =
+      getaddrinfo(host.c_str(), port.c_str(), &hints, &address);
+  if (error != 0) {
+    details::log_session_event(session, "Impossible to resolve " + host +
+                                            ": " + gai_strerror(error));
+    return;
+  }
+
+  auto const socket = ::socket(address->ai_family,
+                               address->ai_socktype | SOCK_NONBLOCK, 0);
+  if (socket < 0) {
+    freeaddrinfo(address);
+    details::log_session_event(session, "Impossible to create a socket");
+    return;
+  }
+  configure_socket(socket);
+
+  auto const result = ::connect(socket, address->ai_addr, address->ai_addrlen);
+  auto const connect_error = errno;
+  freeaddrinfo(address);
+  if (result != 0 && connect_error != EINPROGRESS) {
+    ::close(socket);
+    details::log_session_event(
+        session, string("Connection failed: ") + std::strerror(connect_error));
+    return;
+  }
+
+  auto const heartbeat_interval = dictionary.has(HEARTBTINT)
+                                      ? dictionary.getInt(HEARTBTINT)
+                                      : details::default_heartbeat_interval;
+  setPending(session_id);
+  m_connections.push_back(
+      std::make_unique<connection_t>(socket, session_id, heartbeat_interval));
+}
+
+bool busy_poll_initiator::poll_connections() {
+  bool received = false;
+  for (auto connection = m_connections.begin();
+       connection != m_connections.end();) {
+    if (!(*connection)->connected) {
+      complete_connection(**connection);
+    } else {
+      received |= read(**connection);
+      (*connection)->flush();
+    }
+
+    if ((*connection)->closing()) {
+      close(**connection);
+      connection = m_connections.erase(connection);
+    } else {
+      ++connection;
+    }
+  }
+  return received;
+}
+
+void busy_poll_initiator::complete_connection(connection_t &connection) {
+  pollfd socket{connection.socket, POLLOUT, 0};
+  if (::poll(&socket, 1, 0) <= 0) {
+    return;
+  }
+
+  auto *session = Session::lookupSession(connection.session_id);
+  int error = 0;
+  socklen_t size = sizeof(error);
+  getsockopt(connection.socket, SOL_SOCKET, SO_ERROR, &error, &size);
+  if (error != 0) {
+    details::log_session_event(
+        session, string("Connection failed: ") + std::strerror(error));
+    connection.disconnect();
+    return;
+  }
+
+  connection.session = getSession(connection.session_id, connection);
+  if (connection.session == nullptr) {
+    connection.disconnect();
+    return;
+  }
+
+  details::log_session_event(session, "Connection succeeded");
+  connection.connected = true;
+  setConnected(connection.session_id);
+  if (m_settings.quick_ack) {
+    details::set_socket_option(connection.socket, IPPROTO_TCP, TCP_QUICKACK,
+                               1, "TCP_QUICKACK");
+  }
+
+  // Sends the logon
+  connection.session->next();
+}
+
+bool busy_poll_initiator::read(connection_t &connection) {
+  char buffer[details::read_buffer_size];
+  auto const result = ::recv(connection.socket, buffer, sizeof(buffer), 0);
+  if (result < 0) {
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+      connection.disconnect();
+    }
+    return false;
+  }
+  if (result == 0) {
+    details::log_session_event(connection.session,
+                               "Connection closed by the other side");
+    connection.disconnect();
+    return false;
+  }
+
+  connection.parser.addToStream(buffer, static_cast<size_t>(result));
+  std::string message;
+  try {
+    while (!connection.closing() && connection.parser.readFixMessage(message)) {
+      auto const now = clock::now();
+      if (!fast_path(connection, message, now)) {
+        connection.last_session_message = now;
+        connection.session->next(message, UtcTimeStamp());
+      }
+    }
+  } catch (FIX::Exception const &exception) {
+    details::log_session_event(connection.session, exception.what());
+    connection.disconnect();
+  }
+  return true;
+}
+
+bool busy_poll_initiator::fast_path(connection_t &connection,
+                                    std::string const &message,
+                                    clock::time_point now) {
+  // The session tests the connection when it doesn't see messages for a
+  // heartbeat interval, it sees one at least every half of it
+  auto *const session = connection.session;
+  if (m_fast_paths.empty() || !session->isLoggedOn() ||
+      now - connection.last_session_message >=
+          std::chrono::seconds(connection.heartbeat_interval) / 2 ||
+      !connection.message.parse(message)) {
+    return false;
+  }
+
+  auto const &received = connection.message;
+  auto const handler = m_fast_paths.find(received.type());
+  if (handler == m_fast_paths.end() || received.possible_duplicate() ||
+      received.sequence() != session->getExpectedTargetNum()) {
+    return false;
+  }
+
+  // Checked by the session for every message it handles
+  auto const *const sender = received.find(FIELD::SenderCompID);
+  auto const *const target = received.find(FIELD::TargetCompID);
+  if (sender == nullptr || target == nullptr ||
+      *sender != connection.session_id.getTargetCompID().getString() ||
+      *target != connection.session_id.getSenderCompID().getString() ||
+      !handler->second(received, connection.session_id)) {
+    return false;
+  }
+
+  session->getLog()->onIncoming(message);
+  session->setNextTargetMsgSeqNum(received.sequence() + 1);
+  return true;
+}
+
+void busy_poll_initiator::on_timer() {
+  auto const now = std::time(nullptr);
+  if (now != m_last_timer) {
+    m_last_timer = now;
+    for (auto const &connection : m_connections) {
+      if (connection->connected && connection->session != nullptr) {
+        connection->session->next();
+
+        // Cheaper than setting it again after every read
+        if (m_settings.quick_ack) {
+          details::set_socket_option(connection->socket, IPPROTO_TCP,
+                                     TCP_QUICKACK, 1, "TCP_QUICKACK");
+        }
+      }
+    }
+  }
+
+  if (now - m_last_connect >= m_reconnect_interval) {
+    m_last_connect = now;
+    connect();
+  }
+}
+
+void busy_poll_initiator::close(connection_t &connection) {
+  // The session lets the application know it's logged out
+  if (connection.session != nullptr) {
+    connection.session->disconnect();
+  }
+  setDisconnected(connection.session_id);
+}
+
+void busy_poll_initiator::configure_socket(int socket) const {
+  details::set_socket_option(socket, IPPROTO_TCP, TCP_NODELAY, 1,
+                             "TCP_NODELAY");
+  if (m_settings.socket_busy_poll > 0) {
+    details::set_socket_option(socket, SOL_SOCKET, SO_BUSY_POLL,
+                               m_settings.socket_busy_poll, "SO_BUSY_POLL");
+  }
+}
+
+}  // namespace FIX
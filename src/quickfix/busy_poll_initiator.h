@@ -0,0 +1,185 @@
+#pragma once
+
+#include "../config.h"
+#include "raw_message.h"
+
+#include <chrono>
+#include <ctime>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include <quickfix/Session.h>
+#include <quickfix/SessionSettings.h>
+#include <quickfix/SocketInitiator.h>
+
+namespace FIX {
+
+/**
+ * Initiator polling non blocking sockets instead of blocking on a select.
+ *
+ * The thread of the initiator reads the sockets without waiting for the
+ * system to wake it up: spinning on them, or sleeping in a poll for a short
+ * timeout when spinning is disabled. Everything read goes straight to the
+ * sessions, so logons, heartbeats, resends and the rest of the session level
+ * rules are still the ones of quickfix.
+ *
+ * The types of messages with a fast path skip the session when nothing
+ * about them needs it: logged on, in sequence, not sent again, and the
+ * session saw a message recently enough to not test the connection. The
+ * fast path reads the fields as received (see raw_message), the session only
+ * records the message and its sequence number. Any other message, or one the
+ * fast path gives back, goes through the session.
+ *
+ * Only plain TCP connections are supported, with the same settings as the
+ * SocketInitiator (SocketConnectHost, SocketConnectPort and
+ * ReconnectInterval)
+ */
+class busy_poll_initiator : public Initiator {
+ public:
+  // Tuning of the sockets and of the polling
+  struct settings_t {
+    // Spins on the sockets instead of waiting for them
+    bool spin = true;
+
+    // Microseconds the kernel busy polls the device on a read (SO_BUSY_POLL),
+    // 0 to not ask for it
+    int socket_busy_poll = 0;
+
+    // Acknowledges the reads right away (TCP_QUICKACK). The kernel turns it
+    // off on its own, it's set again every second
+    bool quick_ack = true;
+
+    // Milliseconds waiting for the sockets when not spinning
+    int poll_timeout = 1;
+
+    // Passes the messages with a fast path to it instead of to the session
+    bool fast_decoder = false;
+  };
+
+  /**
+   * Handles a message without the session.
+   * @returns false to give it back to the session, without any effect
+   */
+  using fast_path_t =
+      std::function<bool(raw_message const &, SessionID const &)>;
+
+  /** Constructor */
+  busy_poll_initiator(Application &application,
+                      MessageStoreFactory &store_factory,
+                      SessionSettings const &session_settings,
+                      LogFactory &log_factory, settings_t const &settings);
+
+  /** Destructor */
+  ~busy_poll_initiator();
+
+  /** @returns the settings read from the configuration */
+  static settings_t load_settings(config_file_t const &configuration);
+
+  /**
+   * Sets the fast path of a type of message, ignored when the settings don't
+   * enable the fast decoder. Only before starting the initiator
+   */
+  void set_fast_path(string const &type, fast_path_t fast_path);
+
+ private:
+  using clock = std::chrono::steady_clock;
+
+  // Connection of a session. It's the way the session sends its messages
+  struct connection_t : public Responder {
+    connection_t(int socket, SessionID const &session_id,
+                 int heartbeat_interval);
+    ~connection_t();
+
+    /** Implementing Responder interface */
+    bool send(std::string const &message) override;
+    void disconnect() override;
+
+    /** Sends what didn't fit in the socket before */
+    void flush();
+
+    /** @returns true once the session or the other side closed it */
+    bool closing() const;
+
+    // Socket and session using it
+    int socket;
+    SessionID session_id;
+    Session *session;
+
+    // Still connecting until the socket is writable
+    bool connected;
+
+    // Messages received and not complete yet
+    Parser parser;
+
+    // Last message received, split for the fast paths
+    raw_message message;
+
+    // Seconds between heartbeats of the session, and last time a message
+    // went through it
+    int heartbeat_interval;
+    clock::time_point last_session_message;
+
+   private:
+    // Writes as much as the socket takes. Called with the mutex held
+    bool write();
+
+    // Messages sent that didn't fit in the socket, and the close request.
+    // Sessions send from any thread
+    mutable std::mutex m_mutex;
+    std::string m_pending;
+    bool m_closing;
+  };
+
+  /** Implementing Initiator interface */
+  void onConfigure(SessionSettings const &session_settings) throw(
+      ConfigError) override;
+  void onStart() override;
+  bool onPoll(double timeout) override;
+  void onStop() override;
+  void doConnect(SessionID const &session_id,
+                 Dictionary const &dictionary) override;
+
+  // Reads and writes every socket once. Returns false when nothing was read
+  bool poll_connections();
+
+  // Completes the connection of a socket once it's writable
+  void complete_connection(connection_t &connection);
+
+  // Reads what the socket has, passing the complete messages to the session
+  bool read(connection_t &connection);
+
+  // Passes a message to its fast path. Returns false when the session has to
+  // handle it
+  bool fast_path(connection_t &connection, std::string const &message,
+                 clock::time_point now);
+
+  // Heartbeats, timeouts and reconnections
+  void on_timer();
+
+  // Closes a connection and lets its session know
+  void close(connection_t &connection);
+
+  // Sockets options set to every connection
+  void configure_socket(int socket) const;
+
+  // Tuning of the sockets and of the polling
+  settings_t m_settings;
+
+  // Seconds between reconnections
+  int m_reconnect_interval;
+
+  // Fast paths by type of message
+  std::map<string, fast_path_t> m_fast_paths;
+
+  // Last time the timers ran and the sessions tried to connect
+  std::time_t m_last_timer;
+  std::time_t m_last_connect;
+
+  // Connections of the sessions, only used by the thread of the initiator
+  std::list<std::unique_ptr<connection_t>> m_connections;
+};
+
+}  // namespace FIX
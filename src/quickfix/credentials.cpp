@@ -0,0 +1,105 @@
+#include "credentials.h"
+
+#include "base64/base64.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <openssl/crypto.h>
+#include <openssl/rand.h>
+
+#include <cstring>
+#include <iostream>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace FIX {
+
+credentials::credentials(string const &access_key,
+                         string &access_secret)
+    : m_access_key(access_key),
+      m_secret(nullptr),
+      m_secret_size(access_secret.size()),
+      m_secret_capacity(0),
+      m_digest(EVP_MD_CTX_new()),
+      m_nonces() {
+  if (m_digest == nullptr) {
+    BOOST_THROW_EXCEPTION(std::runtime_error("Impossible to create a digest"));
+  }
+
+  // Pages of its own, so they can be locked and left out of the core dumps
+  auto const page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  m_secret_capacity = (m_secret_size / page + 1) * page;
+  auto *const memory = mmap(nullptr, m_secret_capacity, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    EVP_MD_CTX_free(m_digest);
+    BOOST_THROW_EXCEPTION(
+        std::runtime_error("Impossible to allocate the secret"));
+  }
+  m_secret = static_cast<char *>(memory);
+  if (mlock(m_secret, m_secret_capacity) != 0) {
+    std::cerr << "Impossible to lock the secret in memory: "
+              << std::strerror(errno) << std::endl;
+  }
+  madvise(m_secret, m_secret_capacity, MADV_DONTDUMP);
+  std::memcpy(m_secret, access_secret.data(), m_secret_size);
+  OPENSSL_cleanse(&access_secret[0], access_secret.size());
+  access_secret.clear();
+
+  generate_nonces();
+}
+
+credentials::~credentials() {
+  OPENSSL_cleanse(m_secret, m_secret_capacity);
+  munlock(m_secret, m_secret_capacity);
+  munmap(m_secret, m_secret_capacity);
+  EVP_MD_CTX_free(m_digest);
+}
+
+credentials::logon_t credentials::sign(unsigned long long timestamp) {
+  if (m_nonces.empty()) {
+    generate_nonces();
+  }
+
+  // Creating raw data with format timestamp.nonce64
+  logon_t logon;
+  logon.raw_data = std::to_string(timestamp);
+  logon.raw_data += '.';
+  logon.raw_data += m_nonces.back();
+  m_nonces.pop_back();
+
+  // Creating password: base64(sha(raw_data+SECRET_KEY))
+  unsigned char hash[EVP_MAX_MD_SIZE];
+  unsigned int hash_size = 0;
+  if (!EVP_DigestInit_ex(m_digest, EVP_sha256(), nullptr) ||
+      !EVP_DigestUpdate(m_digest, logon.raw_data.data(),
+                        logon.raw_data.size()) ||
+      !EVP_DigestUpdate(m_digest, m_secret, m_secret_size) ||
+      !EVP_DigestFinal_ex(m_digest, hash, &hash_size)) {
+    BOOST_THROW_EXCEPTION(std::runtime_error("Impossible to sign the logon"));
+  }
+
+  logon.password.resize(::Deribit::base64_encoded_size(hash_size));
+  ::Deribit::base64_encode(hash, hash_size, &logon.password[0]);
+  OPENSSL_cleanse(hash, sizeof(hash));
+  return logon;
+}
+
+void credentials::generate_nonces() {
+  // A single call to the generator for the whole batch
+  unsigned char random[nonce_size * nonce_batch];
+  if (!RAND_bytes(random, sizeof(random))) {
+    BOOST_THROW_EXCEPTION(
+        std::runtime_error("Impossible to create random data to login"));
+  }
+
+  for (size_t nonce = 0; nonce < nonce_batch; ++nonce) {
+    string encoded(::Deribit::base64_encoded_size(nonce_size), '\0');
+    ::Deribit::base64_encode(random + nonce * nonce_size, nonce_size,
+                             &encoded[0]);
+    m_nonces.push_back(std::move(encoded));
+  }
+}
+
+}  // namespace FIX
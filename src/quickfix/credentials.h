@@ -0,0 +1,71 @@
+#pragma once
+
+#include "../config.h"
+
+#include <openssl/evp.h>
+
+namespace FIX {
+
+/**
+ * Credentials of a Deribit session, signing its logons.
+ *
+ * The secret is kept in memory locked out of the swap and of the core dumps,
+ * and wiped when destroyed. The hashing context and the random nonces are
+ * prepared in advance, so a logon only hashes and encodes into buffers of its
+ * own. Used from the thread sending the logons
+ */
+class credentials {
+ public:
+  // Fields of a logon signed
+  struct logon_t {
+    string raw_data;
+    string password;
+  };
+
+  /**
+   * Constructor. Prepares the nonces of the first logons. The secret is
+   * taken: the string given is wiped and left empty
+   */
+  credentials(string const &access_key, string &access_secret);
+
+  /** Destructor. Wipes the secret */
+  ~credentials();
+
+  credentials(credentials const &) = delete;
+  credentials &operator=(credentials const &) = delete;
+
+  /** @returns the key identifying the user */
+  string const &access_key() const { return m_access_key; }
+
+  /**
+   * Signs a logon: RawData is "timestamp.nonce" and the Password
+   * base64(sha256(RawData + secret))
+   */
+  logon_t sign(unsigned long long timestamp);
+
+ private:
+  // Random bytes of a nonce, encoded in base64
+  static size_t const nonce_size = 32;
+
+  // Nonces prepared at once
+  static size_t const nonce_batch = 16;
+
+  // Prepares a batch of nonces
+  void generate_nonces();
+
+  // Key identifying the user
+  string m_access_key;
+
+  // Secret, in locked memory
+  char *m_secret;
+  size_t m_secret_size;
+  size_t m_secret_capacity;
+
+  // Hashing context, reused by every logon
+  EVP_MD_CTX *m_digest;
+
+  // Nonces prepared, already encoded
+  vector<string> m_nonces;
+};
+
+}  // namespace FIX
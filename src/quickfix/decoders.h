@@ -0,0 +1,44 @@
+#pragma once
+#include "message_parser_helpers.h"
+
+#include <cstdint>
+
+namespace FIX {
+namespace generated {
+
+// Slot of a tag inside a decoder, the bit telling whether it has been seen
+struct tag_slot_t {
+  int tag;
+  int slot;
+};
+
+// Repeating group of a message
+struct message_group_t {
+  char const *message_type;
+  int tag;
+};
+
+/**
+ * Throws FieldNotFound for the first required field that wasn't seen
+ */
+template <size_t N>
+inline void check_required(uint64_t const seen, uint64_t const required,
+                           tag_slot_t const (&slots)[N]) {
+  auto const missing = required & ~seen;
+  if (missing == 0) {
+    return;
+  }
+  for (auto const &slot : slots) {
+    if (missing & (uint64_t(1) << slot.slot)) {
+      throw FieldNotFound(slot.tag);
+    }
+  }
+}
+
+}  // namespace generated
+}  // namespace FIX
+
+// Decoders generated from FIX44.xml by messages/generate_decoders.py: a single
+// pass over the fields of a message dispatching each tag with a switch, instead
+// of one lookup per field read
+#include <fix44_decoders.h>
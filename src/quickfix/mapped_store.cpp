@@ -0,0 +1,414 @@
+#include "mapped_store.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <quickfix/FieldConvertors.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace FIX {
+
+namespace details {
+
+// Identifies the files of the store
+uint64_t const store_magic = 0x45524f5453584946;
+
+// The ring starts after the page of the header
+size_t const store_ring_offset = 4096;
+
+/**
+ * @returns the bytes a message takes in the ring, its record included
+ */
+uint64_t record_size(size_t message_size) {
+  auto const size = 8 + message_size;
+  return (size + 7) & ~uint64_t(7);
+}
+
+/**
+ * Writes back to the disk the pages holding part of a mapping
+ */
+void sync_pages(char *mapping, char const *begin, size_t size) {
+  auto const page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  auto const first = (static_cast<size_t>(begin - mapping) / page) * page;
+  auto const last = static_cast<size_t>(begin - mapping) + size;
+  msync(mapping + first, last - first, MS_SYNC);
+}
+
+/**
+ * @returns the name of the file of a session's store
+ */
+string store_file_name(SessionID const &session_id) {
+  auto name = session_id.toString();
+  std::replace_if(name.begin(), name.end(),
+                  [](char const character) {
+                    return !std::isalnum(character) && character != '.' &&
+                           character != '_';
+                  },
+                  '-');
+  return name + ".ring";
+}
+
+}  // namespace details
+
+mapped_store::mapped_store(string const &file_name, size_t ring_size,
+                           durability_t durability)
+    : m_file(-1),
+      m_memory(nullptr),
+      m_memory_size(0),
+      m_header(nullptr),
+      m_ring(nullptr),
+      m_durability(durability),
+      m_index(),
+      m_dirty_begin(0),
+      m_dirty_end(0),
+      m_mutex() {
+  static_assert(sizeof(record_t) == 8, "Records are 8 bytes long");
+
+  m_file = open(file_name.c_str(), O_RDWR | O_CREAT, 0644);
+  if (m_file < 0) {
+    BOOST_THROW_EXCEPTION(IOException("Impossible to open the store " +
+                                      file_name + ": " +
+                                      std::strerror(errno)));
+  }
+
+  // A file created before keeps its size
+  struct stat status;
+  fstat(m_file, &status);
+  auto const created = status.st_size == 0;
+  m_memory_size = created ? details::store_ring_offset + (ring_size & ~7ul)
+                          : static_cast<size_t>(status.st_size);
+  if (created && posix_fallocate(m_file, 0, m_memory_size) != 0) {
+    close(m_file);
+    BOOST_THROW_EXCEPTION(
+        IOException("Impossible to allocate the store " + file_name));
+  }
+
+  // Pages are loaded now, not while sending
+  auto *const memory = mmap(nullptr, m_memory_size, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, m_file, 0);
+  if (memory == MAP_FAILED) {
+    close(m_file);
+    BOOST_THROW_EXCEPTION(IOException("Impossible to map the store " +
+                                      file_name + ": " +
+                                      std::strerror(errno)));
+  }
+  m_memory = static_cast<char *>(memory);
+  m_header = reinterpret_cast<header_t *>(m_memory);
+  m_ring = m_memory + details::store_ring_offset;
+
+  if (created) {
+    initialize();
+  } else if (m_header->magic != details::store_magic ||
+             m_header->ring_size + details::store_ring_offset !=
+                 m_memory_size) {
+    munmap(m_memory, m_memory_size);
+    close(m_file);
+    BOOST_THROW_EXCEPTION(IOException("Invalid store " + file_name));
+  } else {
+    recover();
+  }
+}
+
+mapped_store::~mapped_store() {
+  msync(m_memory, m_memory_size, MS_SYNC);
+  munmap(m_memory, m_memory_size);
+  close(m_file);
+}
+
+bool mapped_store::set(int sequence,
+                       std::string const &message) throw(IOException) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto const ring_size = m_header->ring_size;
+  auto const size = details::record_size(message.size());
+  if (size + sizeof(record_t) > ring_size) {
+    return false;
+  }
+
+  // Messages are never split, the ring starts again instead
+  auto offset = m_header->tail;
+  if (offset + size > ring_size) {
+    evict(offset, ring_size - offset);
+    if (offset < ring_size) {
+      auto *const end = reinterpret_cast<record_t *>(m_ring + offset);
+      *end = record_t{0, 0};
+      changed(m_ring + offset, sizeof(record_t));
+    }
+    offset = 0;
+  }
+  // A record is always left between the newest message and the oldest, an
+  // empty ring is the only one with the same head and tail
+  evict(offset, size + sizeof(record_t));
+
+  auto *const record = reinterpret_cast<record_t *>(m_ring + offset);
+  *record = record_t{static_cast<uint32_t>(message.size()), sequence};
+  std::memcpy(m_ring + offset + sizeof(record_t), message.data(),
+              message.size());
+  changed(m_ring + offset, size);
+
+  // A sequence going back replaces the messages after it
+  while (!m_index.empty() && m_index.back().sequence >= sequence) {
+    m_index.pop_back();
+  }
+  m_index.push_back({sequence, offset, message.size()});
+
+  m_header->tail = offset + size;
+  m_header->head = m_index.front().offset;
+  changed(m_memory, sizeof(header_t));
+  return true;
+}
+
+void mapped_store::get(int begin, int end,
+                       std::vector<std::string> &messages) const
+    throw(IOException) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  messages.clear();
+  auto entry = std::lower_bound(
+      m_index.begin(), m_index.end(), begin,
+      [](entry_t const &candidate, int sequence) {
+        return candidate.sequence < sequence;
+      });
+  for (; entry != m_index.end() && entry->sequence <= end; ++entry) {
+    messages.emplace_back(m_ring + entry->offset + sizeof(record_t),
+                          entry->size);
+  }
+}
+
+int mapped_store::getNextSenderMsgSeqNum() const throw(IOException) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_header->next_sender;
+}
+
+int mapped_store::getNextTargetMsgSeqNum() const throw(IOException) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_header->next_target;
+}
+
+void mapped_store::setNextSenderMsgSeqNum(int sequence) throw(IOException) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_header->next_sender = sequence;
+  changed(m_memory, sizeof(header_t));
+}
+
+void mapped_store::setNextTargetMsgSeqNum(int sequence) throw(IOException) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_header->next_target = sequence;
+  changed(m_memory, sizeof(header_t));
+}
+
+void mapped_store::incrNextSenderMsgSeqNum() throw(IOException) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_header->next_sender;
+  changed(m_memory, sizeof(header_t));
+}
+
+void mapped_store::incrNextTargetMsgSeqNum() throw(IOException) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ++m_header->next_target;
+  changed(m_memory, sizeof(header_t));
+}
+
+UtcTimeStamp mapped_store::getCreationTime() const throw(IOException) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return UtcTimeStampConvertor::convert(string(m_header->creation_time));
+}
+
+void mapped_store::reset() throw(IOException) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  initialize();
+}
+
+void mapped_store::refresh() throw(IOException) {
+  // The mapping is the file, there's nothing to read again
+}
+
+void mapped_store::flush() {
+  size_t begin = 0;
+  size_t end = 0;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::swap(begin, m_dirty_begin);
+    std::swap(end, m_dirty_end);
+  }
+
+  // Only the pages written are sent to the disk
+  if (begin != end) {
+    details::sync_pages(m_memory, m_memory + begin, end - begin);
+  }
+}
+
+void mapped_store::initialize() {
+  std::memset(m_header, 0, sizeof(header_t));
+  m_header->magic = details::store_magic;
+  m_header->ring_size = m_memory_size - details::store_ring_offset;
+  m_header->head = 0;
+  m_header->tail = 0;
+  m_header->next_sender = 1;
+  m_header->next_target = 1;
+  auto const creation_time = UtcTimeStampConvertor::convert(UtcTimeStamp());
+  std::strncpy(m_header->creation_time, creation_time.c_str(),
+               sizeof(m_header->creation_time) - 1);
+  m_index.clear();
+  changed(m_memory, sizeof(header_t));
+}
+
+void mapped_store::recover() {
+  m_index.clear();
+  auto const ring_size = m_header->ring_size;
+  auto const tail = m_header->tail;
+  auto offset = m_header->head;
+  if (offset > ring_size || tail > ring_size) {
+    BOOST_THROW_EXCEPTION(IOException("Corrupted store"));
+  }
+
+  // The messages never take more than the ring, a walk going further is
+  // looping over records that don't lead to the tail
+  uint64_t walked = 0;
+  while (offset != tail) {
+    // End of the ring or marked as such, never before the tail
+    if (offset + sizeof(record_t) > ring_size ||
+        reinterpret_cast<record_t *>(m_ring + offset)->sequence == 0) {
+      if (offset < tail) {
+        BOOST_THROW_EXCEPTION(IOException("Corrupted store"));
+      }
+      walked += ring_size - offset;
+      offset = 0;
+    } else {
+      auto const &record = *reinterpret_cast<record_t *>(m_ring + offset);
+      auto const size = details::record_size(record.size);
+      if (offset + size > ring_size ||
+          (offset < tail && offset + size > tail)) {
+        BOOST_THROW_EXCEPTION(IOException("Corrupted store"));
+      }
+      while (!m_index.empty() && m_index.back().sequence >= record.sequence) {
+        m_index.pop_back();
+      }
+      m_index.push_back({record.sequence, offset, record.size});
+      walked += size;
+      offset += size;
+    }
+
+    if (walked > ring_size) {
+      BOOST_THROW_EXCEPTION(IOException("Corrupted store"));
+    }
+  }
+}
+
+void mapped_store::evict(uint64_t offset, uint64_t size) {
+  // The oldest message is always the next one to be overwritten
+  while (!m_index.empty() && m_index.front().offset < offset + size &&
+         offset < m_index.front().offset +
+                      details::record_size(m_index.front().size)) {
+    m_index.pop_front();
+  }
+}
+
+void mapped_store::changed(char const *begin, size_t size) {
+  if (m_durability == durability_t::SYNC) {
+    details::sync_pages(m_memory, begin, size);
+    return;
+  }
+
+  auto const first = static_cast<size_t>(begin - m_memory);
+  if (m_dirty_begin == m_dirty_end) {
+    m_dirty_begin = first;
+    m_dirty_end = first + size;
+  } else {
+    m_dirty_begin = std::min(m_dirty_begin, first);
+    m_dirty_end = std::max(m_dirty_end, first + size);
+  }
+}
+
+mapped_store_factory::mapped_store_factory(
+    SessionSettings const &session_settings, settings_t const &settings)
+    : m_session_settings(session_settings),
+      m_settings(settings),
+      m_stores(),
+      m_mutex(),
+      m_condition_variable(),
+      m_running(settings.durability == durability_t::ASYNC),
+      m_flusher() {
+  if (m_running) {
+    m_flusher = std::thread(&mapped_store_factory::process, this);
+  }
+}
+
+mapped_store_factory::~mapped_store_factory() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_running = false;
+  }
+  m_condition_variable.notify_all();
+  if (m_flusher.joinable()) {
+    m_flusher.join();
+  }
+}
+
+mapped_store_factory::settings_t mapped_store_factory::load_settings(
+    config_file_t const &configuration) {
+  settings_t settings;
+  settings.ring_size =
+      config_file::get(configuration, "StoreRingBytes", settings.ring_size);
+  settings.flush_interval = config_file::get(
+      configuration, "StoreFlushMilliseconds", settings.flush_interval);
+  settings.thread = threads::load_thread_settings(configuration, "Persistence");
+
+  auto const durability =
+      config_file::get<string>(configuration, "StoreDurability", "async");
+  if (durability == "none") {
+    settings.durability = durability_t::NONE;
+  } else if (durability == "sync") {
+    settings.durability = durability_t::SYNC;
+  } else if (durability == "async") {
+    settings.durability = durability_t::ASYNC;
+  } else {
+    BOOST_THROW_EXCEPTION(
+        std::runtime_error("Unknown StoreDurability: " + durability));
+  }
+  return settings;
+}
+
+MessageStore *mapped_store_factory::create(SessionID const &session_id) {
+  auto const path =
+      m_session_settings.get(session_id).getString(FILE_STORE_PATH);
+  mkdir(path.c_str(), 0755);
+
+  auto *store =
+      new mapped_store(path + "/" + details::store_file_name(session_id),
+                       m_settings.ring_size, m_settings.durability);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_stores.insert(store);
+  return store;
+}
+
+void mapped_store_factory::destroy(MessageStore *store) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stores.erase(static_cast<mapped_store *>(store));
+  }
+  delete store;
+}
+
+void mapped_store_factory::process() {
+  threads::apply_thread_settings(m_settings.thread);
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (m_running) {
+    m_condition_variable.wait_for(
+        lock, std::chrono::milliseconds(m_settings.flush_interval));
+    for (auto *store : m_stores) {
+      store->flush();
+    }
+  }
+}
+
+}  // namespace FIX
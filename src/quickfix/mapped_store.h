@@ -0,0 +1,182 @@
+#pragma once
+
+#include "../config.h"
+#include "../threads/thread_settings.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+#include <quickfix/FileStore.h>
+#include <quickfix/SessionSettings.h>
+
+namespace FIX {
+
+// When what is stored reaches the disk
+enum class durability_t {
+  // Whenever the system writes the pages back
+  NONE,
+
+  // Every flush interval, from the flusher thread
+  ASYNC,
+
+  // Before returning from every change
+  SYNC
+};
+
+/**
+ * Message store over a memory mapped file.
+ *
+ * The file is allocated and mapped once, with room for the sequence numbers
+ * and a ring of the messages sent. Storing a message only copies it into the
+ * ring: the disk is reached later, by the flusher thread of the factory, or
+ * right away when the durability is SYNC. When the ring is full the oldest
+ * messages are dropped, and resend requests asking for them are answered with
+ * a gap fill, as quickfix does for any message missing in a store
+ */
+class mapped_store : public MessageStore {
+ public:
+  /** Constructor. Maps the file, recovering what it had */
+  mapped_store(string const &file_name, size_t ring_size,
+               durability_t durability);
+
+  /** Destructor. Writes everything back and unmaps the file */
+  ~mapped_store();
+
+  mapped_store(mapped_store const &) = delete;
+  mapped_store &operator=(mapped_store const &) = delete;
+
+  /** Implementing MessageStore interface */
+  bool set(int sequence, std::string const &message) throw(
+      IOException) override;
+  void get(int begin, int end, std::vector<std::string> &messages) const
+      throw(IOException) override;
+  int getNextSenderMsgSeqNum() const throw(IOException) override;
+  int getNextTargetMsgSeqNum() const throw(IOException) override;
+  void setNextSenderMsgSeqNum(int sequence) throw(IOException) override;
+  void setNextTargetMsgSeqNum(int sequence) throw(IOException) override;
+  void incrNextSenderMsgSeqNum() throw(IOException) override;
+  void incrNextTargetMsgSeqNum() throw(IOException) override;
+  UtcTimeStamp getCreationTime() const throw(IOException) override;
+  void reset() throw(IOException) override;
+  void refresh() throw(IOException) override;
+
+  /** Writes back to the disk what changed since the last flush */
+  void flush();
+
+ private:
+  // Beginning of the file
+  struct header_t {
+    uint64_t magic;
+    uint64_t ring_size;
+
+    // Oldest message kept and where the next one goes, inside the ring
+    uint64_t head;
+    uint64_t tail;
+
+    int32_t next_sender;
+    int32_t next_target;
+    char creation_time[32];
+  };
+
+  // Beginning of every message in the ring. A zero sequence sends to the
+  // start of the ring
+  struct record_t {
+    uint32_t size;
+    int32_t sequence;
+  };
+
+  // Where a message is in the ring
+  struct entry_t {
+    int sequence;
+    uint64_t offset;
+    uint64_t size;
+  };
+
+  // Starts an empty file
+  void initialize();
+
+  // Rebuilds the index of the messages from the ring
+  void recover();
+
+  // Drops the oldest messages overlapping a part of the ring
+  void evict(uint64_t offset, uint64_t size);
+
+  // Records a change of part of the file, written back as the durability says
+  void changed(char const *begin, size_t size);
+
+  // Mapped file
+  int m_file;
+  char *m_memory;
+  size_t m_memory_size;
+  header_t *m_header;
+  char *m_ring;
+
+  // When changes reach the disk
+  durability_t m_durability;
+
+  // Messages in the ring, oldest first
+  std::deque<entry_t> m_index;
+
+  // Part of the mapping changed since the last flush, empty when clean
+  size_t m_dirty_begin;
+  size_t m_dirty_end;
+
+  // Sessions change it while the flusher writes it back
+  mutable std::mutex m_mutex;
+};
+
+/**
+ * Creates mapped stores for the sessions, in their FileStorePath, and runs
+ * the thread flushing them
+ */
+class mapped_store_factory : public MessageStoreFactory {
+ public:
+  // Size and durability of the stores
+  struct settings_t {
+    size_t ring_size = 64 << 20;
+    durability_t durability = durability_t::ASYNC;
+    int flush_interval = 10;
+
+    // Thread of the flusher, read with the "Persistence" role
+    thread_settings_t thread;
+  };
+
+  /** Constructor. Starts the flusher when the durability is ASYNC */
+  mapped_store_factory(SessionSettings const &session_settings,
+                       settings_t const &settings);
+
+  /** Destructor. Stops the flusher */
+  ~mapped_store_factory();
+
+  /** @returns the settings read from the configuration */
+  static settings_t load_settings(config_file_t const &configuration);
+
+  /** Implementing MessageStoreFactory interface */
+  MessageStore *create(SessionID const &session_id) override;
+  void destroy(MessageStore *store) override;
+
+ private:
+  // Writes back the stores every flush interval until stopped
+  void process();
+
+  // Settings of the sessions, where their stores go
+  SessionSettings m_session_settings;
+
+  // Size and durability of the stores
+  settings_t m_settings;
+
+  // Stores created
+  std::unordered_set<mapped_store *> m_stores;
+
+  // Flusher thread
+  std::mutex m_mutex;
+  std::condition_variable m_condition_variable;
+  bool m_running;
+  std::thread m_flusher;
+};
+
+}  // namespace FIX
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "../config.h"
+#include "market_data_subscriptions.h"
+
+namespace FIX {
+
+/**
+ * Where a strategy gets its instruments and market data from: its own session
+ * or a host sharing a single market data session between several strategies.
+ * Answers come through the quickfix_user callbacks
+ */
+class market_data_source {
+ public:
+  virtual ~market_data_source() {}
+
+  /** Requests the list of instruments */
+  virtual void request_instrument_list() = 0;
+
+  /** Subscribes to the market data of the symbols */
+  virtual void request_market_data(vector<string> const &symbols) = 0;
+
+  /** @returns the state of the subscription of a symbol */
+  virtual optional<market_data_subscriptions::state_t> market_data_state(
+      symbol_t const &symbol) const = 0;
+};
+
+}  // namespace FIX
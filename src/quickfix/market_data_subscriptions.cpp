@@ -0,0 +1,201 @@
+#include "market_data_subscriptions.h"
+
+#include <algorithm>
+
+namespace FIX {
+
+market_data_subscriptions::market_data_subscriptions(
+    size_t batch_size, time_duration stale_interval)
+    : m_batch_size(std::max<size_t>(batch_size, 1)),
+      m_stale_interval(stale_interval),
+      m_last_stale_check(),
+      m_request_identifier(0),
+      m_requests(),
+      m_subscriptions(),
+      m_dropped_incrementals(0),
+      m_mutex() {}
+
+vector<market_data_subscriptions::request_t>
+market_data_subscriptions::subscribe(vector<symbol_t> const &symbols) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  // Rejected symbols are requested again, the rest only once
+  vector<symbol_t> missing;
+  for (auto const &symbol : symbols) {
+    auto const subscription = m_subscriptions.find(symbol);
+    if (subscription != m_subscriptions.end() &&
+        subscription->second.state != state_t::REJECTED) {
+      continue;
+    }
+    if (std::find(missing.begin(), missing.end(), symbol) == missing.end()) {
+      missing.push_back(symbol);
+    }
+  }
+
+  vector<request_t> requests;
+  add_requests(missing.begin(), missing.end(), m_batch_size, false, requests);
+  return requests;
+}
+
+void market_data_subscriptions::activate(symbol_t const &symbol,
+                                         ptime const &now) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto const subscription = m_subscriptions.find(symbol);
+  if (subscription == m_subscriptions.end()) {
+    return;
+  }
+  subscription->second.state = state_t::ACTIVE;
+  subscription->second.last_update = now;
+
+  // The request is answered when none of its symbols waits for it anymore,
+  // either snapshotted or requested again since
+  auto const request = m_requests.find(subscription->second.request_id);
+  if (request == m_requests.end()) {
+    return;
+  }
+  auto const answered = std::all_of(
+      request->second.symbols.begin(), request->second.symbols.end(),
+      [this, &request](symbol_t const &requested) {
+        auto const &other = m_subscriptions[requested];
+        return other.state == state_t::ACTIVE ||
+               other.request_id != request->first;
+      });
+  if (answered) {
+    m_requests.erase(request);
+  }
+}
+
+bool market_data_subscriptions::accept_incremental(symbol_t const &symbol,
+                                                   ptime const &now) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto const subscription = m_subscriptions.find(symbol);
+  if (subscription == m_subscriptions.end() ||
+      subscription->second.state != state_t::ACTIVE) {
+    ++m_dropped_incrementals;
+    return false;
+  }
+  subscription->second.last_update = now;
+  return true;
+}
+
+market_data_subscriptions::reject_t market_data_subscriptions::reject(
+    string const &request_id) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  reject_t outcome;
+
+  auto const request = m_requests.find(request_id);
+  if (request == m_requests.end()) {
+    return outcome;
+  }
+  auto const snapshot_only = request->second.snapshot_only;
+  auto symbols = std::move(request->second.symbols);
+  m_requests.erase(request);
+
+  // Symbols whose snapshot already came are not part of the reject
+  symbols.erase(std::remove_if(symbols.begin(), symbols.end(),
+                               [this](symbol_t const &symbol) {
+                                 return m_subscriptions[symbol].state ==
+                                        state_t::ACTIVE;
+                               }),
+                symbols.end());
+
+  if (symbols.size() == 1) {
+    m_subscriptions[symbols.front()].state = state_t::REJECTED;
+    outcome.rejected = symbols.front();
+  } else if (symbols.size() > 1) {
+    // Splitting the batch in halves until the rejected symbol is alone
+    auto const half = (symbols.size() + 1) / 2;
+    add_requests(symbols.begin(), symbols.end(), half, snapshot_only,
+                 outcome.retries);
+  }
+  return outcome;
+}
+
+vector<market_data_subscriptions::request_t>
+market_data_subscriptions::recover_all() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return recover([](subscription_t const &) { return true; });
+}
+
+vector<market_data_subscriptions::request_t>
+market_data_subscriptions::recover_stale(ptime const &now) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  // Looking at most once per interval, books can't get stale faster
+  if (m_stale_interval.is_zero() ||
+      (!m_last_stale_check.is_not_a_date_time() &&
+       now - m_last_stale_check < m_stale_interval)) {
+    return {};
+  }
+  m_last_stale_check = now;
+
+  auto const limit = now - m_stale_interval;
+  return recover([&limit](subscription_t const &subscription) {
+    return subscription.last_update < limit;
+  });
+}
+
+optional<market_data_subscriptions::state_t> market_data_subscriptions::state(
+    symbol_t const &symbol) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto const subscription = m_subscriptions.find(symbol);
+  if (subscription == m_subscriptions.end()) {
+    return boost::none;
+  }
+  return subscription->second.state;
+}
+
+size_t market_data_subscriptions::dropped_incrementals() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_dropped_incrementals;
+}
+
+void market_data_subscriptions::reset() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_requests.clear();
+  m_subscriptions.clear();
+  m_last_stale_check = ptime();
+}
+
+template <typename Iterator>
+void market_data_subscriptions::add_requests(Iterator begin, Iterator end,
+                                             size_t batch_size,
+                                             bool snapshot_only,
+                                             vector<request_t> &requests) {
+  while (begin != end) {
+    auto const batch_end =
+        begin + std::min<size_t>(batch_size, std::distance(begin, end));
+
+    request_t request{"MD" + std::to_string(m_request_identifier++),
+                      vector<symbol_t>(begin, batch_end), snapshot_only};
+    for (auto const &symbol : request.symbols) {
+      auto &subscription = m_subscriptions[symbol];
+      subscription.state =
+          snapshot_only ? state_t::RECOVERING : state_t::PENDING;
+      subscription.request_id = request.request_id;
+    }
+    m_requests[request.request_id] = request;
+    requests.push_back(std::move(request));
+
+    begin = batch_end;
+  }
+}
+
+template <typename Condition>
+vector<market_data_subscriptions::request_t>
+market_data_subscriptions::recover(Condition condition) {
+  // Only books that were up to date, the rest are waiting a snapshot already
+  vector<symbol_t> symbols;
+  for (auto const &subscription : m_subscriptions) {
+    if (subscription.second.state == state_t::ACTIVE &&
+        condition(subscription.second)) {
+      symbols.push_back(subscription.first);
+    }
+  }
+
+  vector<request_t> requests;
+  add_requests(symbols.begin(), symbols.end(), m_batch_size, true, requests);
+  return requests;
+}
+
+}  // namespace FIX
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "../config.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace FIX {
+
+/**
+ * Market data subscriptions of a session.
+ *
+ * Symbols are batched into requests of several symbols each and the state of
+ * every request is kept by its MDReqID. A rejected batch is split in halves
+ * and requested again, so a single bad symbol is isolated and reported alone
+ * without losing the rest of the batch.
+ *
+ * Incrementals are only applied on top of a snapshot. Until the snapshot of a
+ * symbol arrives its incrementals are dropped: the session delivers messages
+ * in order, so the snapshot that follows already includes them. When the book
+ * of a subscription may have diverged (messages skipped by a gap fill or no
+ * update for too long) a new snapshot is requested and the subscription waits
+ * for it again
+ */
+class market_data_subscriptions {
+ public:
+  // State of the subscription of a symbol
+  enum class state_t { PENDING, ACTIVE, RECOVERING, REJECTED };
+
+  // Request to send
+  struct request_t {
+    string request_id;
+    vector<symbol_t> symbols;
+
+    // Only a snapshot, the subscription to its updates already exists
+    bool snapshot_only;
+  };
+
+  // What to do after a reject
+  struct reject_t {
+    // Requests splitting the rejected batch
+    vector<request_t> retries;
+
+    // Symbol rejected on its own, there's nothing left to retry
+    optional<symbol_t> rejected;
+  };
+
+  /** Constructor. A zero stale interval never considers a book stale */
+  market_data_subscriptions(size_t batch_size, time_duration stale_interval);
+
+  /**
+   * Registers the symbols not subscribed yet
+   * @returns the requests to send for them
+   */
+  vector<request_t> subscribe(vector<symbol_t> const &symbols);
+
+  /**
+   * Marks a symbol as up to date once its snapshot arrives. Its request is
+   * forgotten once every symbol of it has its snapshot
+   */
+  void activate(symbol_t const &symbol, ptime const &now);
+
+  /** @returns true if an incremental of the symbol has to be applied */
+  bool accept_incremental(symbol_t const &symbol, ptime const &now);
+
+  /** @returns what to do after a request was rejected */
+  reject_t reject(string const &request_id);
+
+  /**
+   * Messages may have been lost, every book has to be snapshotted again
+   * @returns the requests to send
+   */
+  vector<request_t> recover_all();
+
+  /**
+   * Looks for books without updates for longer than the stale interval
+   * @returns the requests to snapshot them again
+   */
+  vector<request_t> recover_stale(ptime const &now);
+
+  /** @returns the state of a symbol or none if it was never requested */
+  optional<state_t> state(symbol_t const &symbol) const;
+
+  /** @returns the incrementals dropped while waiting for a snapshot */
+  size_t dropped_incrementals() const;
+
+  /** Forgets every subscription, they end with the session */
+  void reset();
+
+ private:
+  struct subscription_t {
+    state_t state;
+    ptime last_update;
+
+    // Request waiting for its snapshot
+    string request_id;
+  };
+
+  // Creates the requests for the symbols, in batches
+  template <typename Iterator>
+  void add_requests(Iterator begin, Iterator end, size_t batch_size,
+                    bool snapshot_only, vector<request_t> &requests);
+
+  // Requests a new snapshot of the symbols matching the condition
+  template <typename Condition>
+  vector<request_t> recover(Condition condition);
+
+  // Symbols in a batch
+  size_t m_batch_size;
+
+  // Time without updates after which a book is considered stale
+  time_duration m_stale_interval;
+
+  // Last time stale books were looked for
+  ptime m_last_stale_check;
+
+  // Next request identifier
+  long m_request_identifier;
+
+  // Requests waiting for an answer by MDReqID
+  std::unordered_map<string, request_t> m_requests;
+
+  // Subscription by symbol
+  std::unordered_map<symbol_t, subscription_t> m_subscriptions;
+
+  // Incrementals dropped while waiting for a snapshot
+  size_t m_dropped_incrementals;
+
+  // Subscriptions are requested from the strategy and answered from quickfix
+  mutable std::mutex m_mutex;
+};
+
+}  // namespace FIX
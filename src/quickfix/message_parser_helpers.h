@@ -7,6 +7,64 @@
 
 namespace FIX {
 
+/**
+ * Conversion of the raw value of a field into our definitions. Used by the
+ * field readers below and by the generated decoders (see decoders.h)
+ */
+inline void parse_value(string const& raw, int& value) {
+  value = std::atoi(raw.c_str());
+}
+
+inline void parse_value(string const& raw, double& value) {
+  value = std::atof(raw.c_str());
+}
+
+inline void parse_value(string const& raw, price_t& value) {
+  value = static_cast<price_t>(std::atof(raw.c_str()));
+}
+
+inline void parse_value(string const& raw, volume_t& value) {
+  value = static_cast<volume_t>(std::atof(raw.c_str()));
+}
+
+inline void parse_value(string const& raw, string& value) { value = raw; }
+
+template <size_t N>
+inline void parse_value(string const& raw, fixed_string<N>& value) {
+  value = fixed_string<N>(raw);
+}
+
+// Keeps the allocator of the string, so it stays in its arena
+inline void parse_value(string const& raw, arena_string& value) {
+  value.assign(raw.data(), raw.size());
+}
+
+inline void parse_value(string const& raw, currency& value) {
+  value = static_cast<currency>(raw);
+}
+
+inline void parse_value(string const& raw, ptime& value) {
+  using time_facet = boost::posix_time::time_input_facet;
+  time_facet* facet = new time_facet("%Y%m%d-%H:%M:%s *");
+  std::stringstream ss;
+  ss.imbue(std::locale(std::locale(), facet));
+  ss << raw;
+  ss >> value;
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_enum<T>::value>::type parse_value(
+    string const& raw, T& value) {
+  value = static_cast<T>(std::atoi(raw.c_str()));
+}
+
+template <typename T>
+inline void parse_value(string const& raw, optional<T>& value) {
+  T parsed;
+  parse_value(raw, parsed);
+  value = parsed;
+}
+
 template <typename ReturnType, typename = void>
 struct field {
   template <typename MessateType>
@@ -67,6 +125,16 @@ struct field<string> {
   }
 };
 
+// fixed strings
+template <size_t N>
+struct field<fixed_string<N>> {
+  template <typename MessateType>
+  inline static fixed_string<N> get(MessateType const& message,
+                                    int const field_id) {
+    return fixed_string<N>(message.getField(field_id));
+  }
+};
+
 // currency
 template <>
 struct field<currency> {
@@ -81,16 +149,8 @@ template <>
 struct field<ptime> {
   template <typename MessateType>
   inline static ptime get(MessateType const& message, int const field_id) {
-    using time_facet = boost::posix_time::time_input_facet;
-    string raw_date = field<string>::get(message, field_id);
-    time_facet* facet = new time_facet("%Y%m%d-%H:%M:%s *");
-    std::stringstream ss;
-    ss.imbue(std::locale(std::locale(), facet));
-    ss << raw_date;
-
     ptime pt;
-    ss >> pt;
-
+    parse_value(message.getField(field_id), pt);
     return pt;
   }
 };
@@ -0,0 +1,344 @@
+#!/usr/bin/env python3
+"""
+Generates the FIX decoders of the messages the strategy consumes.
+
+For every message (or repeating group entry) listed in DECODERS it emits a
+constexpr table binding each tag to a slot and a decoder that walks the fields
+of the message once, dispatching every tag with a switch into our definitions.
+Fields are checked against the dictionary: they must exist, be part of the
+message or group and have a type compatible with how they are parsed.
+
+It also lists the repeating groups and data fields of the dictionary, used to
+parse messages of trusted sessions without validating them.
+
+Usage: generate_decoders.py <FIX44.xml> <output header>
+"""
+
+import sys
+import xml.etree.ElementTree as ElementTree
+
+# How a field is parsed and the dictionary types it accepts
+KINDS = {
+    'int': {'INT', 'NUMINGROUP', 'SEQNUM', 'LENGTH'},
+    'decimal': {'FLOAT', 'PRICE', 'QTY', 'AMT', 'PRICEOFFSET', 'PERCENTAGE'},
+    'text': {'STRING', 'CURRENCY', 'EXCHANGE', 'MULTIPLEVALUESTRING'},
+    'time': {'UTCTIMESTAMP', 'LOCALMKTDATE'},
+    'enum': {'INT', 'CHAR'},
+}
+
+# Presence of a field
+REQUIRED = 'required'
+
+# Decoders to generate. Each field is:
+#   (dictionary name, kind, destination, presence)
+# where presence is REQUIRED, None (optional or not needed) or the statement
+# marking it as present in the destination's bitmask
+DECODERS = [
+    {
+        'name': 'execution_report',
+        'message': 'ExecutionReport',
+        'arguments': 'execution_report_t &report',
+        'fields': [
+            ('ClOrdID', 'text', 'report.order_id',
+             'report.set(execution_report_t::ORDER_ID)'),
+            ('OrigClOrdID', 'text', 'report.original_order_id',
+             'report.set(execution_report_t::ORIGINAL_ORDER_ID)'),
+            ('OrdStatus', 'enum', 'report.order_status',
+             'report.set(execution_report_t::ORDER_STATUS)'),
+            ('Side', 'enum', 'report.side',
+             'report.set(execution_report_t::SIDE)'),
+            ('TransactTime', 'time', 'report.transaction_time',
+             'report.set(execution_report_t::TRANSACTION_TIME)'),
+            ('LeavesQty', 'decimal', 'report.open_volume',
+             'report.set(execution_report_t::OPEN_VOLUME)'),
+            ('CumQty', 'decimal', 'report.executed_volume',
+             'report.set(execution_report_t::EXECUTED_VOLUME)'),
+            ('OrderQty', 'decimal', 'report.order_volume',
+             'report.set(execution_report_t::ORDER_VOLUME)'),
+            ('OrdType', 'enum', 'report.order_type',
+             'report.set(execution_report_t::ORDER_TYPE)'),
+            ('OrdRejReason', 'int', 'report.reject_reason',
+             'report.set(execution_report_t::REJECT_REASON)'),
+            ('Symbol', 'text', 'report.symbol',
+             'report.set(execution_report_t::SYMBOL)'),
+            ('Price', 'decimal', 'report.order_price',
+             'report.set(execution_report_t::ORDER_PRICE)'),
+            ('QtyType', 'enum', 'report.volume_type',
+             'report.set(execution_report_t::VOLUME_TYPE)'),
+            ('ContractMultiplier', 'decimal', 'report.contract_multiplier',
+             'report.set(execution_report_t::CONTRACT_MULTIPLIER)'),
+            ('AvgPx', 'decimal', 'report.average_execution_price',
+             'report.set(execution_report_t::AVERAGE_EXECUTION_PRICE)'),
+            ('LastPx', 'decimal', 'report.last_execution_price',
+             'report.set(execution_report_t::LAST_EXECUTION_PRICE)'),
+            ('MaxShow', 'decimal', 'report.maximun_show_volume',
+             'report.set(execution_report_t::MAXIMUN_SHOW_VOLUME)'),
+            ('Volatility', 'decimal', 'report.implied_volatility',
+             'report.set(execution_report_t::IMPLIED_VOLATILITY)'),
+            ('PeggedPrice', 'decimal', 'report.pegged_price',
+             'report.set(execution_report_t::PEGGED_PRICE)'),
+            ('MassStatusReqType', 'int', 'report.mass_status_request_type',
+             'report.set(execution_report_t::MASS_STATUS_REQUEST_TYPE)'),
+            ('TotNumReports', 'int', 'report.mass_status_report_number',
+             'report.set(execution_report_t::MASS_STATUS_REPORT_NUMBER)'),
+        ],
+    },
+    {
+        'name': 'security_list_entry',
+        'message': 'SecurityList',
+        'group': 'NoRelatedSym',
+        'arguments': 'instrument_t &instrument',
+        'fields': [
+            ('Symbol', 'text', 'instrument.symbol', REQUIRED),
+            ('SecurityDesc', 'text', 'instrument.description', REQUIRED),
+            ('SecurityType', 'text', 'instrument.type', REQUIRED),
+            ('Currency', 'text', 'instrument.main_currency', REQUIRED),
+            ('ContractMultiplier', 'decimal', 'instrument.contract_multiplier',
+             'instrument.set(instrument_t::CONTRACT_MULTIPLIER)'),
+            ('PutOrCall', 'enum', 'instrument.put_call',
+             'instrument.set(instrument_t::PUT_CALL)'),
+            ('StrikePrice', 'decimal', 'instrument.strike_price',
+             'instrument.set(instrument_t::STRIKE_PRICE)'),
+            ('StrikeCurrency', 'text', 'instrument.strike_currency',
+             'instrument.set(instrument_t::STRIKE_CURRENCY)'),
+            ('MaturityDate', 'time', 'instrument.maturity_date',
+             'instrument.set(instrument_t::MATURITY_DATE)'),
+            ('MinTradeVol', 'decimal', 'instrument.min_trade_volume',
+             'instrument.set(instrument_t::MIN_TRADE_VOLUME)'),
+            ('MinPriceIncrement', 'decimal', 'instrument.tick_size',
+             'instrument.set(instrument_t::TICK_SIZE)'),
+        ],
+    },
+    {
+        'name': 'position_report_entry',
+        'message': 'PositionReport',
+        'group': 'NoPositions',
+        'arguments': ('position_t &position, volume_t &long_quantity, '
+                      'volume_t &short_quantity'),
+        'fields': [
+            ('Symbol', 'text', 'position.symbol', REQUIRED),
+            ('LongQty', 'decimal', 'long_quantity', REQUIRED),
+            ('ShortQty', 'decimal', 'short_quantity', REQUIRED),
+            ('Side', 'enum', 'position.side', REQUIRED),
+            ('SettlPrice', 'decimal', 'position.settlement_price', REQUIRED),
+            ('UnderlyingEndPrice', 'decimal', 'position.underlying_end_price',
+             REQUIRED),
+        ],
+    },
+    {
+        'name': 'market_data_snapshot',
+        'message': 'MarketDataSnapshotFullRefresh',
+        'arguments': 'market_update_t &update',
+        'fields': [
+            ('Symbol', 'text', 'update.symbol', REQUIRED),
+            ('ContractMultiplier', 'decimal', 'update.contract_multiplier',
+             None),
+            ('UnderlyingSymbol', 'text', 'update.underlying_symbol', None),
+            ('UnderlyingPx', 'decimal', 'update.underlying_mid_price', None),
+        ],
+    },
+    {
+        'name': 'market_data_snapshot_entry',
+        'message': 'MarketDataSnapshotFullRefresh',
+        'group': 'NoMDEntries',
+        'arguments': 'market_update_level_t &level',
+        'fields': [
+            ('MDEntryType', 'enum', 'level.side', REQUIRED),
+            ('MDEntryPx', 'decimal', 'level.level_price', REQUIRED),
+            ('MDEntrySize', 'decimal', 'level.level_volume', REQUIRED),
+        ],
+    },
+    {
+        'name': 'market_data_incremental',
+        'message': 'MarketDataIncrementalRefresh',
+        'arguments': 'market_update_t &update',
+        'fields': [
+            ('Symbol', 'text', 'update.symbol', REQUIRED),
+        ],
+    },
+    {
+        'name': 'market_data_incremental_entry',
+        'message': 'MarketDataIncrementalRefresh',
+        'group': 'NoMDEntries',
+        'arguments': 'market_update_level_t &level',
+        'fields': [
+            ('MDEntryType', 'enum', 'level.side', REQUIRED),
+            ('MDUpdateAction', 'enum', 'level.update_type', REQUIRED),
+            ('MDEntryPx', 'decimal', 'level.level_price', REQUIRED),
+            ('MDEntrySize', 'decimal', 'level.level_volume', REQUIRED),
+        ],
+    },
+]
+
+
+class dictionary:
+    """Fields, components and messages of a QuickFIX data dictionary"""
+
+    def __init__(self, path):
+        root = ElementTree.parse(path).getroot()
+        self.fields = {
+            field.get('name'): (int(field.get('number')), field.get('type'))
+            for field in root.find('fields')
+        }
+        self.components = {
+            component.get('name'): component
+            for component in root.find('components')
+        }
+        self.messages = {
+            message.get('name'): message for message in root.find('messages')
+        }
+
+    def members(self, element):
+        """@returns the fields and groups of an element, components expanded"""
+        fields = set()
+        groups = {}
+        for child in element:
+            if child.tag == 'field':
+                fields.add(child.get('name'))
+            elif child.tag == 'group':
+                fields.add(child.get('name'))
+                groups[child.get('name')] = child
+            elif child.tag == 'component':
+                component_fields, component_groups = self.members(
+                    self.components[child.get('name')])
+                fields |= component_fields
+                groups.update(component_groups)
+        return fields, groups
+
+    def find_group(self, element, name):
+        """@returns the definition of a group anywhere inside an element"""
+        fields, groups = self.members(element)
+        if name in groups:
+            return groups[name]
+        for group in groups.values():
+            found = self.find_group(group, name)
+            if found is not None:
+                return found
+        return None
+
+
+def fail(message):
+    sys.stderr.write('generate_decoders.py: ' + message + '\n')
+    sys.exit(1)
+
+
+def generate_decoder(fix, decoder):
+    """@returns the table and decoder of a message or group entry"""
+    message = fix.messages.get(decoder['message'])
+    if message is None:
+        fail('unknown message ' + decoder['message'])
+
+    scope = message
+    description = '%s (35=%s)' % (decoder['message'], message.get('msgtype'))
+    if 'group' in decoder:
+        scope = fix.find_group(message, decoder['group'])
+        if scope is None:
+            fail('%s has no group %s' % (decoder['message'], decoder['group']))
+        description += ', entries of ' + decoder['group']
+    members, _ = fix.members(scope)
+
+    # Checking every field before emitting anything
+    slots = []
+    for name, kind, destination, presence in decoder['fields']:
+        if name not in fix.fields:
+            fail('%s is not in the dictionary' % name)
+        if name not in members:
+            fail('%s is not part of %s' % (name, description))
+        tag, fix_type = fix.fields[name]
+        if fix_type not in KINDS[kind]:
+            fail('%s is %s, it cannot be parsed as %s' % (name, fix_type, kind))
+        slots.append((tag, name, destination, presence))
+    if len(slots) > 64:
+        fail('%s has more than 64 fields' % decoder['name'])
+
+    name = decoder['name']
+    required = [slot for slot, field in enumerate(slots)
+                if field[3] == REQUIRED]
+    required_mask = sum(1 << slot for slot in required)
+
+    lines = ['// ' + description]
+    lines.append('constexpr tag_slot_t %s_slots[] = {' % name)
+    for slot, (tag, field_name, _, _) in enumerate(slots):
+        lines.append('    {%d, %d},  // %s' % (tag, slot, field_name))
+    lines.append('};')
+    lines.append('constexpr uint64_t %s_required = 0x%xull;' %
+                 (name, required_mask))
+    lines.append('')
+    lines.append('template <typename FieldMapType>')
+    lines.append('inline void decode_%s(FieldMapType const &message,' % name)
+    lines.append('    %s) {' % decoder['arguments'])
+    lines.append('  uint64_t seen = 0;')
+    lines.append('  for (auto field = message.begin(); field != message.end();'
+                 ' ++field) {')
+    lines.append('    switch (field->first) {')
+    for slot, (tag, field_name, destination, presence) in enumerate(slots):
+        lines.append('      case %d:  // %s' % (tag, field_name))
+        lines.append('        parse_value(field->second.getString(), %s);' %
+                     destination)
+        if presence and presence != REQUIRED:
+            lines.append('        %s;' % presence)
+        lines.append('        seen |= uint64_t(1) << %d;' % slot)
+        lines.append('        break;')
+    lines.append('      default:')
+    lines.append('        break;')
+    lines.append('    }')
+    lines.append('  }')
+    lines.append('  check_required(seen, %s_required, %s_slots);' %
+                 (name, name))
+    lines.append('}')
+    return '\n'.join(lines)
+
+
+def generate_structure(fix):
+    """
+    @returns the groups of every message and the data fields, which is what
+    QuickFIX needs to parse a message without validating it
+    """
+    lines = ['// Repeating groups of every message']
+    lines.append('constexpr message_group_t dictionary_groups[] = {')
+    for name, message in sorted(fix.messages.items()):
+        _, groups = fix.members(message)
+        for group in sorted(groups):
+            lines.append('    {"%s", %d},  // %s.%s' %
+                         (message.get('msgtype'), fix.fields[group][0], name,
+                          group))
+    lines.append('};')
+    lines.append('')
+    lines.append('// Fields whose value may contain any byte, SOH included')
+    lines.append('constexpr int dictionary_data_fields[] = {')
+    for name, (tag, fix_type) in sorted(fix.fields.items(),
+                                        key=lambda field: field[1][0]):
+        if fix_type == 'DATA':
+            lines.append('    %d,  // %s' % (tag, name))
+    lines.append('};')
+    return '\n'.join(lines)
+
+
+def main():
+    if len(sys.argv) != 3:
+        fail('usage: generate_decoders.py <FIX44.xml> <output header>')
+
+    fix = dictionary(sys.argv[1])
+    decoders = [generate_decoder(fix, decoder) for decoder in DECODERS]
+    decoders.append(generate_structure(fix))
+
+    output = [
+        '// Generated by generate_decoders.py from FIX44.xml. Do not edit.',
+        '// Include through quickfix/decoders.h',
+        '#pragma once',
+        '',
+        'namespace FIX {',
+        'namespace generated {',
+        '',
+        '\n\n'.join(decoders),
+        '',
+        '}  // namespace generated',
+        '}  // namespace FIX',
+        '',
+    ]
+    with open(sys.argv[2], 'w') as header:
+        header.write('\n'.join(output))
+
+
+if __name__ == '__main__':
+    main()
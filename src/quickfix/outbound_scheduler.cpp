@@ -0,0 +1,261 @@
+#include "outbound_scheduler.h"
+
+#include <algorithm>
+
+namespace details {
+
+/**
+ * @returns a field of a message, empty if it's missing
+ */
+string field_of(FIX::FieldMap const &fields, int field) {
+  return fields.isSetField(field) ? fields.getField(field) : string();
+}
+
+/**
+ * @returns the priority of a message of the given type
+ */
+FIX::outbound_scheduler::priority_t priority_of(string const &type) {
+  if (type == FIX::MsgType_OrderCancelRequest ||
+      type == FIX::MsgType_OrderMassCancelRequest) {
+    return FIX::outbound_scheduler::CANCEL;
+  }
+  if (type == FIX::MsgType_NewOrderSingle ||
+      type == FIX::MsgType_OrderCancelReplaceRequest) {
+    return FIX::outbound_scheduler::ORDER;
+  }
+  return FIX::outbound_scheduler::REQUEST;
+}
+
+}  // namespace details
+
+namespace FIX {
+
+outbound_scheduler::outbound_scheduler(sender_t sender,
+                                       settings_t const &settings)
+    : m_sender(std::move(sender)),
+      m_settings(settings),
+      m_credits(settings.max_credits),
+      m_refilled(std::chrono::steady_clock::now()),
+      m_queues(),
+      m_metrics(),
+      m_mutex(),
+      m_condition_variable(),
+      m_running(true),
+      m_sending(false),
+      m_thread() {
+  m_thread = std::thread(&outbound_scheduler::drain, this);
+}
+
+outbound_scheduler::~outbound_scheduler() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_running = false;
+  }
+  m_condition_variable.notify_all();
+  m_thread.join();
+}
+
+outbound_scheduler::settings_t outbound_scheduler::load_settings(
+    config_file_t const &configuration) {
+  settings_t settings;
+  settings.max_credits = config_file::get(configuration, "OutboundMaxCredits",
+                                          settings.max_credits);
+  settings.credits_per_second = config_file::get(
+      configuration, "OutboundCreditsPerSecond", settings.credits_per_second);
+  settings.order_cost = config_file::get(configuration, "OutboundOrderCost",
+                                         settings.order_cost);
+  settings.request_cost = config_file::get(
+      configuration, "OutboundRequestCost", settings.request_cost);
+
+  if (settings.credits_per_second <= 0 || settings.order_cost < 0 ||
+      settings.request_cost < 0 ||
+      settings.max_credits <
+          std::max(settings.order_cost, settings.request_cost)) {
+    BOOST_THROW_EXCEPTION(std::invalid_argument(
+        "OutboundCreditsPerSecond must be positive and OutboundMaxCredits "
+        "enough for any message"));
+  }
+  return settings;
+}
+
+void outbound_scheduler::submit(Message const &message) {
+  pending_t pending{message,
+                    message.getHeader().getField(FIELD::MsgType), string(),
+                    string()};
+  pending.order_id = details::field_of(message, FIELD::ClOrdID);
+  pending.original_order_id = details::field_of(message, FIELD::OrigClOrdID);
+  auto const priority = details::priority_of(pending.type);
+  auto const cost = priority == REQUEST ? m_settings.request_cost
+                                        : m_settings.order_cost;
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  // The orders waiting would go out after the mass cancel
+  if (pending.type == MsgType_OrderMassCancelRequest) {
+    purge_orders();
+  }
+
+  // Nothing waiting to go before, straight to the session
+  refill(std::chrono::steady_clock::now());
+  if (next_queue() == PRIORITIES && !m_sending && m_credits >= cost) {
+    m_credits -= cost;
+    ++m_metrics.sent;
+    lock.unlock();
+    m_sender(pending.message);
+    return;
+  }
+
+  if (coalesce(pending)) {
+    return;
+  }
+
+  enqueue(priority, std::move(pending));
+  lock.unlock();
+  m_condition_variable.notify_one();
+}
+
+void outbound_scheduler::clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (size_t priority = 0; priority < PRIORITIES; ++priority) {
+    m_queues[priority].clear();
+    m_metrics.depth[priority] = 0;
+  }
+}
+
+outbound_scheduler::metrics_t outbound_scheduler::metrics() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_metrics;
+}
+
+void outbound_scheduler::refill(std::chrono::steady_clock::time_point now) {
+  std::chrono::duration<double> const elapsed = now - m_refilled;
+  m_refilled = now;
+  m_credits =
+      std::min(m_settings.max_credits,
+               m_credits + elapsed.count() * m_settings.credits_per_second);
+}
+
+bool outbound_scheduler::coalesce(pending_t &pending) {
+  if (pending.original_order_id.empty()) {
+    return false;
+  }
+
+  auto &orders = m_queues[ORDER];
+  auto const is_cancel = pending.type == MsgType_OrderCancelRequest;
+  auto const is_replace = pending.type == MsgType_OrderCancelReplaceRequest;
+  if (!is_cancel && !is_replace) {
+    return false;
+  }
+
+  // Replaces waiting for the same order, or for the replace waiting. Only the
+  // last one goes out, replacing the order live in the exchange
+  for (auto replace = orders.begin(); replace != orders.end(); ++replace) {
+    if (replace->type != MsgType_OrderCancelReplaceRequest ||
+        (replace->original_order_id != pending.original_order_id &&
+         replace->order_id != pending.original_order_id)) {
+      continue;
+    }
+
+    pending.original_order_id = replace->original_order_id;
+    pending.message.setField(FIELD::OrigClOrdID, pending.original_order_id);
+    ++m_metrics.coalesced;
+    if (is_replace) {
+      *replace = std::move(pending);
+      return true;
+    }
+
+    // A cancel takes the place of the replaces in its own queue
+    orders.erase(replace);
+    --m_metrics.depth[ORDER];
+    return coalesce(pending);
+  }
+
+  // The cancel of an order not sent yet goes right after it, never before
+  if (is_cancel) {
+    auto const order = std::find_if(
+        orders.begin(), orders.end(), [&pending](pending_t const &waiting) {
+          return waiting.type == MsgType_NewOrderSingle &&
+                 waiting.order_id == pending.original_order_id;
+        });
+    if (order != orders.end()) {
+      orders.insert(order + 1, std::move(pending));
+      ++m_metrics.delayed;
+      ++m_metrics.depth[ORDER];
+      return true;
+    }
+  }
+  return false;
+}
+
+void outbound_scheduler::purge_orders() {
+  auto const purge = [this](size_t priority, string const &type) {
+    auto &queue = m_queues[priority];
+    auto const first = std::remove_if(
+        queue.begin(), queue.end(),
+        [&type](pending_t const &waiting) { return waiting.type == type; });
+    auto const purged = static_cast<size_t>(queue.end() - first);
+    queue.erase(first, queue.end());
+    m_metrics.depth[priority] -= purged;
+    m_metrics.coalesced += purged;
+  };
+  purge(ORDER, MsgType_NewOrderSingle);
+  purge(ORDER, MsgType_OrderCancelReplaceRequest);
+  purge(ORDER, MsgType_OrderCancelRequest);
+  purge(CANCEL, MsgType_OrderCancelRequest);
+}
+
+void outbound_scheduler::enqueue(size_t priority, pending_t pending) {
+  m_queues[priority].push_back(std::move(pending));
+  ++m_metrics.delayed;
+  ++m_metrics.depth[priority];
+  size_t depth = 0;
+  for (auto const &queue : m_queues) {
+    depth += queue.size();
+  }
+  m_metrics.max_depth = std::max(m_metrics.max_depth, depth);
+}
+
+size_t outbound_scheduler::next_queue() const {
+  size_t priority = 0;
+  while (priority < PRIORITIES && m_queues[priority].empty()) {
+    ++priority;
+  }
+  return priority;
+}
+
+void outbound_scheduler::drain() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (m_running) {
+    auto const priority = next_queue();
+    if (priority == PRIORITIES) {
+      m_condition_variable.wait(lock);
+      continue;
+    }
+
+    // Waiting for the credits of the first message, or a more urgent one
+    refill(std::chrono::steady_clock::now());
+    auto const cost = priority == REQUEST ? m_settings.request_cost
+                                          : m_settings.order_cost;
+    if (m_credits < cost) {
+      std::chrono::duration<double> const missing(
+          (cost - m_credits) / m_settings.credits_per_second);
+      m_condition_variable.wait_for(lock, missing);
+      continue;
+    }
+
+    m_credits -= cost;
+    auto &queue = m_queues[priority];
+    auto pending = std::move(queue.front());
+    queue.pop_front();
+    --m_metrics.depth[priority];
+    ++m_metrics.sent;
+
+    m_sending = true;
+    lock.unlock();
+    m_sender(pending.message);
+    lock.lock();
+    m_sending = false;
+  }
+}
+
+}  // namespace FIX
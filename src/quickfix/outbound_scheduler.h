@@ -0,0 +1,139 @@
+#pragma once
+
+#include "../config.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include <quickfix/Message.h>
+
+namespace FIX {
+
+/**
+ * Sends the messages of a session within the credits of the exchange.
+ *
+ * Deribit gives every account a bucket of credits refilled at a constant
+ * rate, and every request takes some of them. Messages are sent right away
+ * while there are credits and nothing is waiting. Otherwise they wait in
+ * queues by priority, cancels first, and a thread of the scheduler sends them
+ * as the credits come back.
+ *
+ * While waiting, a replace supersedes the replaces of the same order, and a
+ * cancel the replaces of the order it cancels: only the latest one goes out,
+ * to the order live in the exchange. A cancel never goes ahead of the new
+ * order it cancels, it waits behind it, and a mass cancel drops the orders,
+ * replaces and cancels waiting.
+ *
+ * Messages are handed to the session without holding the lock of the
+ * scheduler: the session calls the application, whose lock may be held by a
+ * thread submitting
+ */
+class outbound_scheduler {
+ public:
+  // Credits of the account and what every message takes
+  struct settings_t {
+    // Credits in the bucket when full, and refilled every second
+    double max_credits = 50000;
+    double credits_per_second = 10000;
+
+    // Credits of a cancel or an order, and of any other request
+    double order_cost = 500;
+    double request_cost = 500;
+  };
+
+  // Priority of a message, as the index of its queue
+  enum priority_t : size_t { CANCEL, ORDER, REQUEST, PRIORITIES };
+
+  // Depth of the queues and what happened to the messages
+  struct metrics_t {
+    size_t depth[PRIORITIES] = {};
+    size_t max_depth = 0;
+    size_t sent = 0;
+    size_t delayed = 0;
+    size_t coalesced = 0;
+  };
+
+  using sender_t = std::function<void(Message &)>;
+
+  /** Constructor. Messages are sent through the sender */
+  outbound_scheduler(sender_t sender, settings_t const &settings);
+
+  /** Destructor. Messages still waiting are dropped */
+  ~outbound_scheduler();
+
+  outbound_scheduler(outbound_scheduler const &) = delete;
+  outbound_scheduler &operator=(outbound_scheduler const &) = delete;
+
+  /** @returns the settings read from the configuration */
+  static settings_t load_settings(config_file_t const &configuration);
+
+  /** Sends a message, now if there are credits or once there are */
+  void submit(Message const &message);
+
+  /** Drops the messages waiting, when the session is lost */
+  void clear();
+
+  /** @returns the depth of the queues and the counters */
+  metrics_t metrics() const;
+
+ private:
+  // Message waiting, with the identifiers of the order it's about
+  struct pending_t {
+    Message message;
+    string type;
+    string order_id;
+    string original_order_id;
+  };
+
+  // Adds the credits since the last time
+  void refill(std::chrono::steady_clock::time_point now);
+
+  // Merges a message into the ones waiting. Returns true if it superseded
+  // one of them or waits behind the new order it cancels, and doesn't need
+  // queueing
+  bool coalesce(pending_t &pending);
+
+  // Drops the orders, replaces and cancels waiting, for a mass cancel
+  void purge_orders();
+
+  // Queues a message behind the ones of its priority
+  void enqueue(size_t priority, pending_t pending);
+
+  // @returns the highest priority queue with messages, or PRIORITIES
+  size_t next_queue() const;
+
+  // Sends the messages waiting as the credits come back
+  void drain();
+
+  // Sends the messages to the session
+  sender_t m_sender;
+
+  // Credits of the account
+  settings_t m_settings;
+
+  // Credits available and last time they were refilled
+  double m_credits;
+  std::chrono::steady_clock::time_point m_refilled;
+
+  // Messages waiting, by priority
+  std::deque<pending_t> m_queues[PRIORITIES];
+
+  // Depth of the queues and counters
+  metrics_t m_metrics;
+
+  // Protects all of the above
+  mutable std::mutex m_mutex;
+  std::condition_variable m_condition_variable;
+
+  // Thread sending what waits, and whether it's sending a message taken from
+  // the queues. Messages submitted meanwhile wait for it, to keep the order
+  bool m_running;
+  bool m_sending;
+  std::thread m_thread;
+};
+
+}  // namespace FIX
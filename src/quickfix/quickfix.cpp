@@ -1,8 +1,12 @@
 #include "quickfix.h"
 
+#include "async_log.h"
+#include "busy_poll_initiator.h"
+#include "mapped_store.h"
 #include "quickfix_log_replayer.h"
+#include "trusted_dictionary.h"
 
-#include "base64/base64.h"
+#include "decoders.h"
 #include "message_parser_helpers.h"
 
 #include <boost/date_time/posix_time/posix_time.hpp>
@@ -18,17 +22,27 @@
 #include <quickfix/fix44/PositionReport.h>
 #include <quickfix/fix44/SecurityList.h>
 
-#include <openssl/rand.h>
-#include <openssl/sha.h>
 #include <chrono>
 #include <ctime>
 #include <iostream>
+#include <stdexcept>
 
 namespace FIX {
 
-using encoding_t = unsigned char const *;
+namespace details {
+
+// Symbols in a market data request when missing in the configuration
+size_t const default_market_data_batch_size = 20;
+
+// Seconds without updates before snapshotting a book again, 0 to never do it
+long const default_market_data_stale_seconds = 0;
+
+}  // namespace details
 
 quickfix::~quickfix() {
+  // Nothing else is sent once the sessions stop
+  m_scheduler.reset();
+
   if (m_initiator != nullptr) {
     m_initiator->stop();
     delete m_initiator;
@@ -46,31 +60,95 @@ quickfix::quickfix(config_file_t &configuration, quickfix_user &user)
       m_request_identifier(0),
       m_order_identifier(0),
       m_configuration(configuration),
+      m_user_config(config_file::load_user_config(configuration)),
+      m_credentials(m_user_config.access_key,
+                    config_file::access_secret(configuration)),
       m_initiator(nullptr),
       m_quickfix_settings(),
       m_quickfix_synch(),
       m_quickfix_store_factory(),
       m_quickfix_log_factory(),
-      m_log_replay() {
+      m_full_dictionary(),
+      m_received_messages(0),
+      m_market_update(),
+      m_raw_entries(),
+      m_subscriptions(
+          config_file::get(configuration, "MarketDataBatchSize",
+                           details::default_market_data_batch_size),
+          seconds(config_file::get(
+              configuration, "MarketDataStaleSeconds",
+              details::default_market_data_stale_seconds))),
+      m_scheduler(),
+      m_network_thread_settings(
+          threads::load_thread_settings(configuration, "Network")),
+      m_network_thread() {
+  // The credentials wiped the secret, no copy is left in the configuration
+  configuration.erase("AccessSecret");
+
   // Initializing quickfix engine
   m_quickfix_settings = std::make_unique<FIX::SessionSettings>(
-      m_configuration["FIXConfigurationFile"]);
+      m_user_config.fix_configuration_file);
   m_quickfix_synch = std::make_unique<FIX::SynchronizedApplication>(*this);
-  m_quickfix_store_factory =
-      std::make_unique<FIX::FileStoreFactory>(*m_quickfix_settings);
-  m_quickfix_log_factory =
-      std::make_unique<FIX::FileLogFactory>(*m_quickfix_settings);
+  // The mapped store keeps the disk out of the sending thread
+  if (m_user_config.mapped_store) {
+    m_quickfix_store_factory = std::make_unique<mapped_store_factory>(
+        *m_quickfix_settings,
+        mapped_store_factory::load_settings(m_configuration));
+  } else {
+    m_quickfix_store_factory =
+        std::make_unique<FIX::FileStoreFactory>(*m_quickfix_settings);
+  }
 
-  // Indicate if it will be used for log replay or for real
-  m_log_replay = m_configuration.find("LogToReplay") != m_configuration.end();
+  // The asynchronous log keeps the formatting and the writes out of the
+  // session threads
+  if (m_user_config.async_log) {
+    m_quickfix_log_factory = std::make_unique<async_log_factory>(
+        *m_quickfix_settings,
+        async_log_factory::load_settings(m_configuration));
+  } else {
+    m_quickfix_log_factory =
+        std::make_unique<FIX::FileLogFactory>(*m_quickfix_settings);
+  }
+
+  // Bursts of orders wait for the credits instead of getting throttled
+  if (m_user_config.outbound_scheduler) {
+    m_scheduler = std::make_unique<outbound_scheduler>(
+        [this](Message &message) {
+          try {
+            FIX::Session::sendToTarget(message, m_session_id);
+          } catch (SessionNotFound const &exception) {
+            std::cerr << "Message not sent: " << exception.what()
+                      << std::endl;
+          }
+        },
+        outbound_scheduler::load_settings(m_configuration));
+  }
 }
 
 bool quickfix::run() {
-  if (!m_log_replay) {
+  if (!m_user_config.log_to_replay) {
     try {
-      m_initiator = new FIX::SocketInitiator(
-          *m_quickfix_synch, *m_quickfix_store_factory, *m_quickfix_settings,
-          *m_quickfix_log_factory);
+      // Polling the socket saves the wake up of the select on every message
+      if (m_user_config.busy_poll_initiator) {
+        auto *initiator = new busy_poll_initiator(
+            *m_quickfix_synch, *m_quickfix_store_factory, *m_quickfix_settings,
+            *m_quickfix_log_factory,
+            busy_poll_initiator::load_settings(m_configuration));
+        initiator->set_fast_path(
+            MsgType_MarketDataIncrementalRefresh,
+            [this](raw_message const &message, SessionID const &) {
+              return on_market_data_incremental(message);
+            });
+        m_initiator = initiator;
+      } else {
+        m_initiator = new FIX::SocketInitiator(
+            *m_quickfix_synch, *m_quickfix_store_factory, *m_quickfix_settings,
+            *m_quickfix_log_factory);
+      }
+
+      if (m_user_config.trusted_session) {
+        trust_sessions();
+      }
 
       m_initiator->start();
 
@@ -80,10 +158,6 @@ bool quickfix::run() {
       return false;
     }
   } else {
-    if (m_configuration.find("LogToReplay") == m_configuration.end()) {
-      return false;
-    }
-
     auto const configuration = m_quickfix_settings->get();
 
     std::set<SessionID> sessions = m_quickfix_settings->getSessions();
@@ -97,9 +171,9 @@ bool quickfix::run() {
     auto const receiver =
         m_quickfix_settings->get(session).getString(FIX::TARGETCOMPID);
 
-    quickfix_log_replayer replayer(*this, m_configuration["LogToReplay"],
-                                   DataDictionary(dictionary_path), session,
-                                   receiver);
+    quickfix_log_replayer replayer(
+        *this, *m_user_config.log_to_replay, DataDictionary(dictionary_path),
+        session, receiver, m_user_config.validate_replay);
     replayer.start();
     return false;
   }
@@ -119,6 +193,11 @@ void quickfix::onCreate(SessionID const &session_id) {
 void quickfix::onLogon(SessionID const & /*session_id*/) { m_user.on_logon(); }
 
 void quickfix::onLogout(SessionID const & /*session_id*/) {
+  // Orders waiting would go out late in the next session
+  if (m_scheduler) {
+    m_scheduler->clear();
+  }
+  m_subscriptions.reset();
   m_user.on_logout();
 }
 
@@ -135,16 +214,84 @@ void quickfix::toApp(Message & /*message*/,
                      SessionID const & /*session_id*/) throw(DoNotSend) {}
 
 void quickfix::fromAdmin(
-    Message const & /*message*/,
+    Message const &message,
     SessionID const & /*session_id*/) throw(FieldNotFound, IncorrectDataFormat,
-                                            IncorrectTagValue, RejectLogon) {}
+                                            IncorrectTagValue, RejectLogon) {
+  configure_network_thread();
+
+  auto const &msg_type = message.getHeader().getField(FIX::FIELD::MsgType);
+
+  // Messages skipped by a gap fill may include market data, books could have
+  // diverged
+  if (msg_type == FIX::MsgType_SequenceReset &&
+      message.isSetField(FIX::FIELD::GapFillFlag) &&
+      message.getField(FIX::FIELD::GapFillFlag) == "Y") {
+    for (auto const &request : m_subscriptions.recover_all()) {
+      send_market_data_request(request);
+    }
+  }
+}
 
 void quickfix::fromApp(
     Message const &message,
     SessionID const &session_id) throw(FieldNotFound, IncorrectDataFormat,
                                        IncorrectTagValue,
                                        UnsupportedMessageType) {
-  crack(message, session_id);
+  configure_network_thread();
+
+  // Trusted sessions skip the validation, a sample is still fully validated
+  if (m_full_dictionary && m_user_config.validation_sample_rate &&
+      ++m_received_messages % m_user_config.validation_sample_rate == 0) {
+    validate_sample(message);
+  }
+
+  // Symbols and identifiers are decoded inline with a fixed capacity. A longer
+  // one rejects the message instead of escaping to the session
+  try {
+    crack(message, session_id);
+  } catch (std::length_error const &exception) {
+    std::cerr << "Rejecting a message with a field too long: "
+              << exception.what() << std::endl;
+    throw IncorrectDataFormat(0, exception.what());
+  }
+}
+
+void quickfix::trust_sessions() {
+  for (auto const &session_id : m_quickfix_settings->getSessions()) {
+    auto *session = Session::lookupSession(session_id);
+    if (session == nullptr) {
+      continue;
+    }
+
+    auto const dictionary_path =
+        m_quickfix_settings->get(session_id).getString(FIX::DATA_DICTIONARY);
+    m_full_dictionary = std::make_shared<DataDictionary>(dictionary_path);
+
+    DataDictionaryProvider provider;
+    provider.addTransportDataDictionary(
+        session_id.getBeginString(),
+        make_trusted_dictionary(*m_full_dictionary));
+    session->setDataDictionaryProvider(provider);
+  }
+}
+
+void quickfix::validate_sample(Message const &message) const {
+  try {
+    m_full_dictionary->validate(message);
+  } catch (FIX::Exception const &exception) {
+    // Reported without rejecting, the message is processed as usual
+    std::cout << "Sampled validation failed: " << exception.what() << " "
+              << message.toString() << std::endl;
+  }
+}
+
+void quickfix::configure_network_thread() {
+  auto const thread = std::this_thread::get_id();
+  if (thread == m_network_thread) {
+    return;
+  }
+  m_network_thread = thread;
+  threads::apply_thread_settings(m_network_thread_settings);
 }
 
 void quickfix::test_request() {
@@ -204,16 +351,28 @@ void quickfix::request_mass_status() {
 }
 
 void quickfix::request_market_data(string const &symbol) {
+  request_market_data(vector<string>{symbol});
+}
+
+void quickfix::request_market_data(vector<string> const &symbols) {
+  vector<symbol_t> requested(symbols.begin(), symbols.end());
+  for (auto const &request : m_subscriptions.subscribe(requested)) {
+    send_market_data_request(request);
+  }
+}
+
+void quickfix::send_market_data_request(
+    market_data_subscriptions::request_t const &request) {
   Message message;
-  auto const request_id = std::to_string(m_request_identifier++);
 
   auto &header = message.getHeader();
   header.setField(FIX::MsgType(FIX::MsgType_MarketDataRequest));
 
-  message.setField(FIX::Symbol(symbol));
-  message.setField(FIX::MDReqID(request_id));
+  message.setField(FIX::MDReqID(request.request_id));
   message.setField(FIX::SubscriptionRequestType(
-      FIX::SubscriptionRequestType_SNAPSHOT_PLUS_UPDATES));
+      request.snapshot_only
+          ? FIX::SubscriptionRequestType_SNAPSHOT
+          : FIX::SubscriptionRequestType_SNAPSHOT_PLUS_UPDATES));
 
   message.setField(FIX::MarketDepth(1));
   message.setField(FIX::MDUpdateType(0));
@@ -226,6 +385,14 @@ void quickfix::request_market_data(string const &symbol) {
   entry_types.set(FIX::MDEntryType_OFFER);
   message.addGroup(entry_types);
 
+  /** Groups for the symbols of the batch */
+  message.setField(FIX::NoRelatedSym(request.symbols.size()));
+  FIX44::MarketDataRequest::NoRelatedSym related_symbol;
+  for (auto const &symbol : request.symbols) {
+    related_symbol.set(FIX::Symbol(symbol.str()));
+    message.addGroup(related_symbol);
+  }
+
   send_message(message, m_session_id);
 }
 
@@ -277,6 +444,32 @@ string quickfix::send_gtc_order(string const &symbol, side_t order_side,
   return order_id;
 }
 
+string quickfix::send_replace_order(string const &order_to_replace,
+                                    string const &symbol, side_t order_side,
+                                    price_t order_price,
+                                    volume_t order_volume) {
+  auto const side = order_side == side_t::BUY ? FIX::Side_BUY : FIX::Side_SELL;
+
+  Message message;
+  auto const order_id = std::to_string(m_order_identifier++);
+
+  auto &header = message.getHeader();
+
+  header.setField(FIX::MsgType(FIX::MsgType_OrderCancelReplaceRequest));
+
+  message.setField(FIX::ClOrdID(order_id));
+  message.setField(FIX::OrigClOrdID(order_to_replace));
+  message.setField(FIX::Side(side));
+  message.setField(FIX::OrderQty(order_volume));
+  message.setField(FIX::Price(order_price));
+  message.setField(FIX::Symbol(symbol));
+  message.setField(FIX::OrdType(FIX::OrdType_LIMIT));
+
+  send_message(message, m_session_id);
+
+  return order_id;
+}
+
 void quickfix::send_cancel_order(std::string const &order_to_cancel) {
   Message message;
   auto const order_id = std::to_string(m_order_identifier++);
@@ -346,7 +539,7 @@ void quickfix::user_request() {
   message.setField(FIX::UserRequestID(order_id));
   message.setField(FIX::UserRequestType(
       FIX::UserRequestType_REQUEST_INDIVIDUAL_USER_STATUS));
-  message.setField(FIX::Username(m_configuration["AccessKey"]));
+  message.setField(FIX::Username(m_credentials.access_key()));
   send_message(message, m_session_id);
 }
 
@@ -357,68 +550,47 @@ void quickfix::create_logon_message(Message &message) {
           std::chrono::system_clock::now().time_since_epoch())
           .count();
 
-  // Creating the random nonce (32 random bytes encoded in base64)
-  constexpr int nonce_to_encode_size = 32;
-  unsigned char nonce_to_encode[nonce_to_encode_size];
-  if (!RAND_bytes(nonce_to_encode, nonce_to_encode_size)) {
-    throw(std::runtime_error("Impossible to create random data to login"));
-  }
-
-  encoding_t nonce = reinterpret_cast<encoding_t>(nonce_to_encode);
-  string nonce64 = ::Deribit::base64_encode(nonce, nonce_to_encode_size);
-
-  // Creating raw data with format timestamp.nonce64
-  std::stringstream raw_data_stream;
-  raw_data_stream << timestamp << "." << nonce64;
-  string raw_data = raw_data_stream.str();
-
-  // Creating password: base64(sha(raw_data+SECRET_KEY))
-  string raw_and_secret = raw_data + m_configuration["AccessSecret"];
-  unsigned char hash[SHA256_DIGEST_LENGTH];
-  SHA256_CTX sha256;
-  SHA256_Init(&sha256);
-  SHA256_Update(&sha256, raw_and_secret.c_str(), raw_and_secret.size());
-  SHA256_Final(hash, &sha256);
-  string password = ::Deribit::base64_encode(hash, SHA256_DIGEST_LENGTH);
+  auto const logon = m_credentials.sign(timestamp);
 
   // Setting message fields
-  message.setField(FIX::FIELD::Username, m_configuration["AccessKey"]);
-  message.setField(FIX::FIELD::Password, password);
-  message.setField(FIX::FIELD::RawData, raw_data);
+  message.setField(FIX::FIELD::Username, m_credentials.access_key());
+  message.setField(FIX::FIELD::Password, logon.password);
+  message.setField(FIX::FIELD::RawData, logon.raw_data);
   message.setField(FIX::FIELD::ResetSeqNumFlag, "N");
 }
 
 void quickfix::onMessage(FIX44::PositionReport const &message,
                          SessionID const &session_id) {
+  // Everything decoded lives in the thread's arena until the user is done
+  arena_scope scope(thread_arena());
+  arena_allocator<position_t> allocator(&scope.memory());
+
   // Total positions reported and vector's initialization
   auto const position_size = field<size_t>::get(message, FIELD::NoPositions);
 
   // Getting all elements inside the group
   optional<positions_list_t> positions =
-      position_size ? positions_list_t{}
+      position_size ? positions_list_t(allocator)
                     : optional<positions_list_t>(boost::none);
-  FIX44::PositionReport::NoPositions position_group;
+  if (positions) {
+    positions->reserve(position_size);
+  }
   for (size_t i = 1; i <= position_size; ++i) {
-    message.getGroup(i, position_group);
-
-    auto quantity_long = field<volume_t>::get(position_group, FIELD::LongQty);
-    auto quantity_short = field<volume_t>::get(position_group, FIELD::ShortQty);
-    auto quantity =
+    auto const &position_group = message.getGroupRef(i, FIELD::NoPositions);
+
+    position_t position;
+    volume_t quantity_long(0);
+    volume_t quantity_short(0);
+    generated::decode_position_report_entry(position_group, position,
+                                            quantity_long, quantity_short);
+    position.quantity =
         double_equals(quantity_long, 0) ? quantity_short : quantity_long;
 
     // If quantity is 0, ignore the position
-    if (quantity == 0) {
+    if (position.quantity == 0) {
       continue;
     }
 
-    // clang-format off
-    position_t position = {
-		field<string>::get(position_group, FIELD::Symbol),
-		quantity,
-		field<side_t>::get(position_group, FIELD::Side),
-		field<price_t>::get(position_group, FIELD::SettlPrice),
-		field<price_t>::get(position_group, FIELD::UnderlyingEndPrice)};
-    // clang-format on
     positions->push_back(std::move(position));
   }
 
@@ -428,35 +600,27 @@ void quickfix::onMessage(FIX44::PositionReport const &message,
 
 void quickfix::onMessage(FIX44::SecurityList const &message,
                          SessionID const &session_id) {
+  // Everything decoded lives in the thread's arena until the user is done
+  arena_scope scope(thread_arena());
+  arena_allocator<instrument_t> allocator(&scope.memory());
+
   // Total instruments reported and vector's initialization
   auto const instruments_size =
       field<size_t>::get(message, FIELD::NoRelatedSym);
 
   // Getting all elements inside the group
-  FIX44::SecurityList::NoRelatedSym instruments_group;
   optional<instruments_list_t> instruments =
-      instruments_size ? instruments_list_t{}
+      instruments_size ? instruments_list_t(allocator)
                        : optional<instruments_list_t>(boost::none);
+  if (instruments) {
+    instruments->reserve(instruments_size);
+  }
   for (size_t i = 1; i <= instruments_size; ++i) {
-    message.getGroup(i, instruments_group);
-
-    instrument_t instrument = {
-        field<string>::get(instruments_group, FIELD::Symbol),
-        field<string>::get(instruments_group, FIELD::SecurityDesc),
-        field<string>::get(instruments_group, FIELD::SecurityType),
-        field<currency>::get(instruments_group, FIELD::Currency),
-        field<optional<double>>::get(instruments_group,
-                                     FIELD::ContractMultiplier),
-        field<optional<option_type_t>>::get(instruments_group,
-                                            FIELD::PutOrCall),
-        field<optional<price_t>>::get(instruments_group, FIELD::StrikePrice),
-        field<optional<currency>>::get(instruments_group,
-                                       FIELD::StrikeCurrency),
-        field<optional<ptime>>::get(instruments_group, FIELD::MaturityDate),
-        field<optional<volume_t>>::get(instruments_group, FIELD::MinTradeVol),
-        field<optional<double>>::get(instruments_group,
-                                     FIELD::MinPriceIncrement),
-    };
+    auto const &instruments_group =
+        message.getGroupRef(i, FIELD::NoRelatedSym);
+
+    instrument_t instrument(allocator);
+    generated::decode_security_list_entry(instruments_group, instrument);
 
     instruments->push_back(std::move(instrument));
   }
@@ -467,133 +631,146 @@ void quickfix::onMessage(FIX44::SecurityList const &message,
 
 void quickfix::onMessage(FIX44::MarketDataRequestReject const &message,
                          SessionID const &session_id) {
-  auto const failure_text = field<string>::get(message, FIELD::Text);
+  auto const request_id = field<string>::get(message, FIELD::MDReqID);
+  auto const text = field<optional<string>>::get(message, FIELD::Text);
+  auto const failure_text = text ? *text : string();
+
+  // A rejected batch is requested again in halves until the symbol is alone
+  auto const outcome = m_subscriptions.reject(request_id);
+  for (auto const &retry : outcome.retries) {
+    send_market_data_request(retry);
+  }
 
   // Communicate to the user
+  if (outcome.rejected) {
+    m_user.on_subscription_rejected(*outcome.rejected, failure_text);
+  }
   m_user.on_message(failure_text);
 }
 
 void quickfix::onMessage(FIX44::MarketDataSnapshotFullRefresh const &message,
                          SessionID const &session_id) {
-  market_update_t update;
+  // Decoding into the same update every time, it keeps its memory
+  auto &update = m_market_update;
+  update.clear();
 
   // Populate the update with the update components
-  auto const symbol = field<string>::get(message, FIELD::Symbol);
-  update.symbol = symbol;
-  update.contract_multiplier =
-      field<optional<double>>::get(message, FIELD::ContractMultiplier);
-  update.underlying_symbol =
-      field<optional<string>>::get(message, FIELD::UnderlyingSymbol);
-  update.underlying_mid_price =
-      field<optional<price_t>>::get(message, FIELD::UnderlyingPx);
+  generated::decode_market_data_snapshot(message, update);
+  update.snapshot = true;
+
+  // The book is up to date from now on
+  auto const now = microsec_clock::universal_time();
+  m_subscriptions.activate(update.symbol, now);
 
   // Fill market update vector
   auto const level_depth = field<size_t>::get(message, FIELD::NoMDEntries);
-  FIX44::MarketDataSnapshotFullRefresh::NoMDEntries entries_group;
 
   if (level_depth > 0) {
     update.updates.resize(level_depth);
 
     for (size_t index = 0; index < level_depth; ++index) {
-      message.getGroup(index + 1, entries_group);
-
-      update.updates[index].side =
-          field<market_side_t>::get(entries_group, FIELD::MDEntryType);
+      auto const &entries_group =
+          message.getGroupRef(index + 1, FIELD::NoMDEntries);
 
       update.updates[index].update_type = market_update_action_t::NEW;
-      update.updates[index].level_price =
-          field<price_t>::get(entries_group, FIELD::MDEntryPx);
-      update.updates[index].level_volume =
-          field<volume_t>::get(entries_group, FIELD::MDEntrySize);
+      generated::decode_market_data_snapshot_entry(entries_group,
+                                                   update.updates[index]);
     }
   }
 
   // Communicate to the user
   m_user.on_message(update);
+
+  recover_stale_books(now);
 }
 
 void quickfix::onMessage(FIX44::MarketDataIncrementalRefresh const &message,
                          SessionID const &session_id) {
-  market_update_t update;
+  // Decoding into the same update every time, it keeps its memory
+  auto &update = m_market_update;
+  update.clear();
 
   // Populate the update with the update components
-  auto const symbol = field<string>::get(message, FIELD::Symbol);
-  update.symbol = symbol;
+  generated::decode_market_data_incremental(message, update);
+
+  // Only applied on top of a snapshot, it already includes earlier ones
+  auto const now = microsec_clock::universal_time();
+  if (!m_subscriptions.accept_incremental(update.symbol, now)) {
+    recover_stale_books(now);
+    return;
+  }
 
   // Fill market update vector
   auto const level_depth = field<size_t>::get(message, FIELD::NoMDEntries);
-  FIX44::MarketDataIncrementalRefresh::NoMDEntries entries_group;
 
   if (level_depth > 0) {
     update.updates.resize(level_depth);
 
     for (size_t index = 0; index < level_depth; ++index) {
-      message.getGroup(index + 1, entries_group);
-
-      update.updates[index].side =
-          field<market_side_t>::get(entries_group, FIELD::MDEntryType);
-
-      update.updates[index].update_type = field<market_update_action_t>::get(
-          entries_group, FIELD::MDUpdateAction);
-      ;
-      update.updates[index].level_price =
-          field<price_t>::get(entries_group, FIELD::MDEntryPx);
-      update.updates[index].level_volume =
-          field<volume_t>::get(entries_group, FIELD::MDEntrySize);
+      auto const &entries_group =
+          message.getGroupRef(index + 1, FIELD::NoMDEntries);
+
+      generated::decode_market_data_incremental_entry(entries_group,
+                                                      update.updates[index]);
     }
   }
 
   // Communicate to the user
   m_user.on_message(update);
+
+  recover_stale_books(now);
+}
+
+bool quickfix::on_market_data_incremental(raw_message const &message) {
+  // Same lock as the messages going through the session
+  Locker lock(m_quickfix_synch->m_mutex);
+  configure_network_thread();
+
+  // Fully decoded before anything is applied, the session handles the
+  // message when it's not what the decoders expect
+  auto &update = m_market_update;
+  update.clear();
+  try {
+    generated::decode_market_data_incremental(
+        message.before(FIELD::NoMDEntries), update);
+    if (!message.group(FIELD::NoMDEntries, m_raw_entries)) {
+      return false;
+    }
+    update.updates.resize(m_raw_entries.size());
+    for (size_t index = 0; index < m_raw_entries.size(); ++index) {
+      generated::decode_market_data_incremental_entry(m_raw_entries[index],
+                                                      update.updates[index]);
+    }
+  } catch (FieldNotFound const &) {
+    return false;
+  } catch (std::length_error const &) {
+    return false;
+  }
+
+  auto const now = microsec_clock::universal_time();
+  if (m_subscriptions.accept_incremental(update.symbol, now)) {
+    m_user.on_message(update);
+  }
+
+  recover_stale_books(now);
+  return true;
+}
+
+void quickfix::recover_stale_books(ptime const &now) {
+  for (auto const &request : m_subscriptions.recover_stale(now)) {
+    send_market_data_request(request);
+  }
 }
 
 void quickfix::onMessage(FIX44::ExecutionReport const &message,
                          SessionID const &session_id) {
   execution_report_t report;
-
-  report.order_id = field<optional<string>>::get(message, FIELD::ClOrdID);
-  report.original_order_id =
-      field<optional<string>>::get(message, FIELD::OrigClOrdID);
-  report.order_status =
-      field<optional<order_status_t>>::get(message, FIELD::OrdStatus);
-  report.side = field<optional<side_t>>::get(message, FIELD::Side);
-  report.transaction_time =
-      field<optional<ptime>>::get(message, FIELD::TransactTime);
-  report.open_volume =
-      field<optional<volume_t>>::get(message, FIELD::LeavesQty);
-  report.executed_volume =
-      field<optional<volume_t>>::get(message, FIELD::CumQty);
-  report.order_volume =
-      field<optional<volume_t>>::get(message, FIELD::OrderQty);
-  report.order_type =
-      field<optional<order_type_t>>::get(message, FIELD::OrdType);
-  report.reject_reason =
-      field<optional<int>>::get(message, FIELD::OrdRejReason);
-  report.symbol = field<optional<string>>::get(message, FIELD::Symbol);
-
-  report.order_price = field<optional<price_t>>::get(message, FIELD::Price);
-  report.volume_type =
-      field<optional<volume_type_t>>::get(message, FIELD::QtyType);
-  report.contract_multiplier =
-      field<optional<double>>::get(message, FIELD::ContractMultiplier);
-  report.average_execution_price =
-      field<optional<price_t>>::get(message, FIELD::AvgPx);
-  report.maximun_show_volume =
-      field<optional<volume_t>>::get(message, FIELD::MaxShow);
-  report.implied_volatility =
-      field<optional<double>>::get(message, FIELD::Volatility);
-  report.pegged_price =
-      field<optional<price_t>>::get(message, FIELD::PeggedPrice);
-
-  report.mass_status_request_type =
-      field<optional<int>>::get(message, FIELD::MassStatusReqType);
-  report.mass_status_report_number =
-      field<optional<int>>::get(message, FIELD::TotNumReports);
+  generated::decode_execution_report(message, report);
 
   // Communicate to the user
-  if (report.mass_status_request_type &&
-      (report.mass_status_request_type.get() == 7)) {
-    m_user.on_mass_status_report(report.mass_status_report_number.get());
+  if (report.has(execution_report_t::MASS_STATUS_REQUEST_TYPE) &&
+      (report.mass_status_request_type == 7)) {
+    m_user.on_mass_status_report(report.mass_status_report_number);
   } else {
     m_user.on_message(report);
   }
@@ -626,8 +803,21 @@ void quickfix::onMessage(FIX44::OrderMassCancelReport const &message,
   m_user.on_message(report);
 }
 
+optional<outbound_scheduler::metrics_t> quickfix::outbound_metrics() const {
+  if (!m_scheduler) {
+    return boost::none;
+  }
+  return m_scheduler->metrics();
+}
+
 void quickfix::send_message(Message &message, SessionID const &session) {
-  if (!m_log_replay) {
+  if (m_user_config.log_to_replay) {
+    return;
+  }
+
+  if (m_scheduler) {
+    m_scheduler->submit(message);
+  } else {
     FIX::Session::sendToTarget(message, m_session_id);
   }
 }
@@ -1,12 +1,23 @@
 #pragma once
 
 #include "../config.h"
+#include "../config_file/user_config.h"
+#include "credentials.h"
+#include "market_data_source.h"
+#include "market_data_subscriptions.h"
+#include "outbound_scheduler.h"
 #include "quickfix_user.h"
+#include "raw_message.h"
+
+#include "../threads/thread_settings.h"
 
 #include <fstream>
+#include <memory>
+#include <thread>
 #include <unordered_map>
 
 #include <quickfix/Application.h>
+#include <quickfix/DataDictionary.h>
 #include <quickfix/Field.h>
 #include <quickfix/MessageCracker.h>
 
@@ -29,7 +40,9 @@ USER_DEFINE_STRING(DeribitBTCSize, 100089);
 USER_DEFINE_PRICE(DeribitMarkPrice, 100090);
 USER_DEFINE_PRICE(DeribitOpenInterest, 100091);
 
-class quickfix : public Application, public FIX44::MessageCracker {
+class quickfix : public Application,
+                 public FIX44::MessageCracker,
+                 public market_data_source {
  public:
   /** Destructor */
   ~quickfix();
@@ -58,15 +71,29 @@ class quickfix : public Application, public FIX44::MessageCracker {
 
   // Methods for sending messages via quickfix
   void test_request();
-  void request_instrument_list();
+  void request_instrument_list() override;
   void request_positions();
   void request_mass_status();
   void request_market_data(string const &symbol);
+  void request_market_data(vector<string> const &symbols) override;
+  optional<market_data_subscriptions::state_t> market_data_state(
+      symbol_t const &symbol) const override {
+    return m_subscriptions.state(symbol);
+  }
   string send_ioc_order(string const &symbol, side_t side, price_t order_price,
                         volume_t order_volume);
   string send_gtc_order(string const &symbol, side_t side, price_t order_price,
                         volume_t order_volume);
+  string send_replace_order(string const &order_to_replace,
+                            string const &symbol, side_t side,
+                            price_t order_price, volume_t order_volume);
   void send_cancel_order(std::string const &order_to_cancel);
+
+  /**
+   * @returns the depth of the outbound queues and their counters, none if
+   * the messages are not scheduled
+   */
+  optional<outbound_scheduler::metrics_t> outbound_metrics() const;
   // TODO: refine from here
   void send_single_order(string const &symbol);
   void send_mass_cancellation_order();
@@ -76,6 +103,29 @@ class quickfix : public Application, public FIX44::MessageCracker {
   // Create a logon message
   void create_logon_message(Message &message);
 
+  // Sends a market data request for a batch of symbols
+  void send_market_data_request(
+      market_data_subscriptions::request_t const &request);
+
+  // Snapshots again the books without updates for too long
+  void recover_stale_books(ptime const &now);
+
+  // Fast path of the busy poll initiator for the incremental refreshes,
+  // decoding the fields as received. Returns false to leave the message to
+  // the session
+  bool on_market_data_incremental(raw_message const &message);
+
+  // Parses the messages of the sessions without validating them against the
+  // dictionary, keeping the full one for sampled validation
+  void trust_sessions();
+
+  // Fully validates a message received in a trusted session
+  void validate_sample(Message const &message) const;
+
+  // Applies the network thread settings to the thread receiving the messages,
+  // once, or again when quickfix moves to a new one
+  void configure_network_thread();
+
   // OnMessage for all messages. This comes from the message cracker inheritance
   virtual void onMessage(FIX44::PositionReport const &message,
                          SessionID const &session_id) override;
@@ -109,18 +159,42 @@ class quickfix : public Application, public FIX44::MessageCracker {
   // Next order identifier
   long m_order_identifier;
 
-  // Configuration file
+  // Configuration file, and its entries resolved
   config_file_t &m_configuration;
+  user_config_t const m_user_config;
+
+  // Credentials signing the logons
+  credentials m_credentials;
 
   // Specifics for quickfix
   FIX::Initiator *m_initiator;
   std::unique_ptr<FIX::SessionSettings> m_quickfix_settings;
   std::unique_ptr<FIX::SynchronizedApplication> m_quickfix_synch;
-  std::unique_ptr<FIX::FileStoreFactory> m_quickfix_store_factory;
-  std::unique_ptr<FIX::FileLogFactory> m_quickfix_log_factory;
+  std::unique_ptr<FIX::MessageStoreFactory> m_quickfix_store_factory;
+  std::unique_ptr<FIX::LogFactory> m_quickfix_log_factory;
+
+  // Full dictionary of the trusted sessions, null when not trusted
+  std::shared_ptr<DataDictionary> m_full_dictionary;
+
+  // Application messages received
+  size_t m_received_messages;
+
+  // Market data update reused by every market data message
+  market_update_t m_market_update;
+
+  // Entries of the incremental refreshes decoded by the fast path
+  std::vector<raw_message::range_t> m_raw_entries;
+
+  // Market data requested by the user
+  market_data_subscriptions m_subscriptions;
+
+  // Sends the messages within the credits of the exchange, null when they
+  // are sent right away
+  std::unique_ptr<outbound_scheduler> m_scheduler;
 
-  // Flag to know if this will be used to replaying logs or not
-  bool m_log_replay;
+  // Settings of the thread receiving the messages, and the last one set
+  thread_settings_t m_network_thread_settings;
+  std::thread::id m_network_thread;
 };
 
 }  // namespace FIX
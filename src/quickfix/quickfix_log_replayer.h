@@ -14,12 +14,14 @@ class quickfix_log_replayer {
   // Constructor
   quickfix_log_replayer(FIX::quickfix& owner, string const file_path,
                         FIX::DataDictionary const data_dictionary,
-                        FIX::SessionID const session_id, string receiver)
+                        FIX::SessionID const session_id, string receiver,
+                        bool validate)
       : m_owner(owner),
         m_file(file_path),
         m_fix_dictionary(data_dictionary),
         m_session_id(session_id),
-        m_receiver(receiver){};
+        m_receiver(receiver),
+        m_validate(validate){};
 
   /** Start the thread that will read the file */
   void start() {
@@ -46,6 +48,11 @@ class quickfix_log_replayer {
           continue;
         }
 
+        // Offline, every message can be checked against the full dictionary
+        if (m_validate) {
+          m_fix_dictionary.validate(msg);
+        }
+
         m_owner.fromApp(msg, m_session_id);
       } catch (FIX::InvalidMessage const& e) {
         std::cout << "Invalid message: " << e.what() << std::endl;
@@ -71,4 +78,7 @@ class quickfix_log_replayer {
 
   // Receiver of the messages
   string m_receiver;
+
+  // Validate every message against the dictionary
+  bool m_validate;
 };
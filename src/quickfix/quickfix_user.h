@@ -10,6 +10,10 @@ namespace FIX {
  *
  * @Note: This class methods won't have them pure virtual since the user might
  * want to only get some messages while not being interested in the others
+ *
+ * @Note: Positions and instruments lists are allocated in an arena that is
+ * reset when the callback returns. Copy whatever has to outlive it, copies are
+ * made in the heap
  */
 class quickfix_user {
  public:
@@ -24,6 +28,8 @@ class quickfix_user {
   virtual void on_message(mass_cancel_report_t const& /*report*/){};
   virtual void on_message(order_cancel_reject_t const& /*report*/){};
   virtual void on_message(string const& /*message*/){};
+  virtual void on_subscription_rejected(symbol_t const& /*symbol*/,
+                                        string const& /*reason*/){};
 };
 
 }  // namespace FIX
@@ -0,0 +1,154 @@
+#include "raw_message.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace FIX {
+
+namespace details {
+
+// Tags of the header and of the trailer checked when splitting a message
+int const raw_begin_string_tag = 8;
+int const raw_body_length_tag = 9;
+int const raw_message_type_tag = 35;
+int const raw_sequence_tag = 34;
+int const raw_possible_duplicate_tag = 43;
+int const raw_checksum_tag = 10;
+
+// Separator of the fields
+char const raw_field_separator = '\x01';
+
+/**
+ * Reads a tag or a length, only made of digits.
+ * @returns false when empty or not a number
+ */
+bool parse_raw_number(char const *first, char const *last, int &value) {
+  if (first == last) {
+    return false;
+  }
+  value = 0;
+  for (; first != last; ++first) {
+    if (*first < '0' || *first > '9') {
+      return false;
+    }
+    value = value * 10 + (*first - '0');
+  }
+  return true;
+}
+
+}  // namespace details
+
+raw_message::raw_message() : m_fields(), m_size(0) {}
+
+bool raw_message::parse(std::string const &message) {
+  m_size = 0;
+
+  auto const *const text = message.data();
+  auto const *const end = text + message.size();
+  auto const *position = text;
+  char const *body = nullptr;
+  char const *trailer = nullptr;
+  unsigned checksum = 0;
+  while (position != end) {
+    auto const *const equal = std::find(position, end, '=');
+    auto const *const separator =
+        std::find(equal, end, details::raw_field_separator);
+    int tag = 0;
+    if (separator == end ||
+        !details::parse_raw_number(position, equal, tag)) {
+      return false;
+    }
+
+    if (tag == details::raw_checksum_tag) {
+      trailer = position;
+    } else {
+      for (auto const *byte = position; byte <= separator; ++byte) {
+        checksum += static_cast<unsigned char>(*byte);
+      }
+    }
+    add_field(tag, equal + 1, static_cast<size_t>(separator - equal - 1));
+    if (tag == details::raw_body_length_tag) {
+      body = separator + 1;
+    }
+    position = separator + 1;
+  }
+
+  // The header and the trailer quickfix would check before its session
+  if (m_size < 4 || m_fields[0].first != details::raw_begin_string_tag ||
+      m_fields[1].first != details::raw_body_length_tag ||
+      m_fields[2].first != details::raw_message_type_tag ||
+      m_fields[m_size - 1].first != details::raw_checksum_tag) {
+    return false;
+  }
+  auto const &length = m_fields[1].second.text;
+  auto const &sum = m_fields[m_size - 1].second.text;
+  int expected_length = 0;
+  int expected_checksum = 0;
+  return details::parse_raw_number(length.data(), length.data() + length.size(),
+                                   expected_length) &&
+         details::parse_raw_number(sum.data(), sum.data() + sum.size(),
+                                   expected_checksum) &&
+         trailer - body == expected_length &&
+         static_cast<int>(checksum % 256) == expected_checksum;
+}
+
+std::string const *raw_message::find(int tag) const {
+  auto const last = m_fields.begin() + m_size;
+  auto const field =
+      std::find_if(m_fields.begin(), last,
+                   [tag](field_t const &field) { return field.first == tag; });
+  return field == last ? nullptr : &field->second.text;
+}
+
+std::string const &raw_message::type() const { return m_fields[2].second.text; }
+
+int raw_message::sequence() const {
+  auto const *const value = find(details::raw_sequence_tag);
+  return value == nullptr ? 0 : std::atoi(value->c_str());
+}
+
+bool raw_message::possible_duplicate() const {
+  auto const *const value = find(details::raw_possible_duplicate_tag);
+  return value != nullptr && *value == "Y";
+}
+
+raw_message::range_t raw_message::before(int count_tag) const {
+  auto const last = m_fields.begin() + (m_size - 1);
+  auto const group =
+      std::find_if(m_fields.begin(), last, [count_tag](field_t const &field) {
+        return field.first == count_tag;
+      });
+  return {m_fields.begin(), group};
+}
+
+bool raw_message::group(int count_tag, std::vector<range_t> &entries) const {
+  entries.clear();
+  auto const last = m_fields.begin() + (m_size - 1);
+  auto const count = before(count_tag).end();
+  if (count == last) {
+    return false;
+  }
+
+  auto const first = count + 1;
+  for (auto field = first; field != last; ++field) {
+    if (field->first == first->first) {
+      if (!entries.empty()) {
+        entries.back().last = field;
+      }
+      entries.push_back({field, last});
+    }
+  }
+  return entries.size() ==
+         static_cast<size_t>(std::atoi(count->second.text.c_str()));
+}
+
+void raw_message::add_field(int tag, char const *value, size_t size) {
+  if (m_size == m_fields.size()) {
+    m_fields.emplace_back();
+  }
+  auto &field = m_fields[m_size++];
+  field.first = tag;
+  field.second.text.assign(value, size);
+}
+
+}  // namespace FIX
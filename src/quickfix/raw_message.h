@@ -0,0 +1,85 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace FIX {
+
+/**
+ * Fields of a FIX message as received, without building a Message.
+ *
+ * Splitting the text once gives its tags and values in their order: enough
+ * for the generated decoders, which only iterate over the fields, and for the
+ * checks the busy poll initiator makes before handing a message to a decoder
+ * instead of to its session. The fields keep their memory from a message to
+ * the next one. Everything but parse is only valid after it succeeded
+ */
+class raw_message {
+ public:
+  // Value of a field, read by the decoders like the ones of a Message
+  struct value_t {
+    std::string const &getString() const { return text; }
+
+    std::string text;
+  };
+
+  using field_t = std::pair<int, value_t>;
+  using const_iterator = std::vector<field_t>::const_iterator;
+
+  // Consecutive fields of the message, iterated like a FieldMap
+  struct range_t {
+    const_iterator begin() const { return first; }
+    const_iterator end() const { return last; }
+
+    const_iterator first;
+    const_iterator last;
+  };
+
+  /** Constructor */
+  raw_message();
+
+  /**
+   * Splits a complete message.
+   * @returns false when it isn't well formed: a field without a tag or not
+   * terminated, a header not starting with BeginString, BodyLength and
+   * MsgType, no CheckSum at the end, or a wrong body length or checksum
+   */
+  bool parse(std::string const &message);
+
+  /** @returns the value of a field, nullptr when the message doesn't have it */
+  std::string const *find(int tag) const;
+
+  /** @returns the type of the message (MsgType) */
+  std::string const &type() const;
+
+  /** @returns the sequence number of the message (MsgSeqNum), 0 if missing */
+  int sequence() const;
+
+  /** @returns true when the message is sent again (PossDupFlag) */
+  bool possible_duplicate() const;
+
+  /**
+   * @returns the fields of the header and of the body before a repeating
+   * group, all of them but the trailer when the message doesn't have it
+   */
+  range_t before(int count_tag) const;
+
+  /**
+   * Splits the repeating group ending the body into its entries, a new entry
+   * starting at every occurrence of the first tag of the group.
+   * @returns false when the message doesn't have the group or when the
+   * entries don't match its count
+   */
+  bool group(int count_tag, std::vector<range_t> &entries) const;
+
+ private:
+  // Adds a field, reusing the memory of the previous messages
+  void add_field(int tag, char const *value, size_t size);
+
+  // Fields of the message, only the first ones are used
+  std::vector<field_t> m_fields;
+  size_t m_size;
+};
+
+}  // namespace FIX
@@ -0,0 +1,36 @@
+#include "trusted_dictionary.h"
+
+#include "decoders.h"
+
+namespace FIX {
+
+std::shared_ptr<DataDictionary> make_trusted_dictionary(
+    DataDictionary const &full_dictionary) {
+  auto dictionary = std::make_shared<DataDictionary>();
+  dictionary->checkFieldsOutOfOrder(false);
+  dictionary->checkFieldsHaveValues(false);
+  dictionary->checkUserDefinedFields(false);
+
+  // Groups are copied with their nested groups
+  for (auto const &group : generated::dictionary_groups) {
+    int delimiter = 0;
+    DataDictionary const *group_dictionary = nullptr;
+    if (full_dictionary.getGroup(group.message_type, group.tag, delimiter,
+                                 group_dictionary)) {
+      dictionary->addGroup(group.message_type, group.tag, delimiter,
+                           *group_dictionary);
+    }
+  }
+
+  // Data fields are read by length, their value may contain SOH
+  for (auto const tag : generated::dictionary_data_fields) {
+    TYPE::Type type;
+    if (full_dictionary.getFieldType(tag, type)) {
+      dictionary->addFieldType(tag, type);
+    }
+  }
+
+  return dictionary;
+}
+
+}  // namespace FIX
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <quickfix/DataDictionary.h>
+
+#include <memory>
+
+namespace FIX {
+
+/**
+ * Builds the dictionary of a trusted session from the full one.
+ *
+ * It only knows the repeating groups and data fields, which is what QuickFIX
+ * needs to parse a message. Having no version, QuickFIX skips the validation
+ * against it, so a message received only goes through the framing, checksum
+ * and header checks of the session
+ */
+std::shared_ptr<DataDictionary> make_trusted_dictionary(
+    DataDictionary const &full_dictionary);
+
+}  // namespace FIX
@@ -0,0 +1,202 @@
+#include "risk_gate.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace details {
+
+/**
+ * @returns the limit of an instrument a configuration key applies to, or
+ * null if it's not a limit
+ */
+double risk_gate::limits_t::*limit_of_key(string const &key) {
+  if (key == "RiskMaxOrderVolume") {
+    return &risk_gate::limits_t::max_order_volume;
+  }
+  if (key == "RiskMaxPosition") {
+    return &risk_gate::limits_t::max_position;
+  }
+  if (key == "RiskPriceBand") {
+    return &risk_gate::limits_t::price_band;
+  }
+  if (key == "RiskFatFinger") {
+    return &risk_gate::limits_t::fat_finger;
+  }
+  return nullptr;
+}
+
+}  // namespace details
+
+risk_gate::risk_gate(instrument_registry const &instruments,
+                     settings_t const &settings)
+    : m_instruments(instruments),
+      m_settings(settings),
+      m_instruments_risk(),
+      m_tokens(settings.order_burst),
+      m_refilled(std::chrono::steady_clock::now()),
+      m_rejections() {
+  grow();
+}
+
+risk_gate::settings_t risk_gate::load_settings(
+    config_file_t const &configuration) {
+  settings_t settings;
+  auto &limits = settings.limits;
+  limits.max_order_volume =
+      config_file::get(configuration, "RiskMaxOrderVolume", 0.0);
+  limits.max_position = config_file::get(configuration, "RiskMaxPosition", 0.0);
+  limits.price_band = config_file::get(configuration, "RiskPriceBand", 0.0);
+  limits.fat_finger = config_file::get(configuration, "RiskFatFinger", 0.0);
+  settings.orders_per_second =
+      config_file::get(configuration, "RiskOrdersPerSecond", 0.0);
+  settings.order_burst = config_file::get(configuration, "RiskOrderBurst",
+                                          settings.order_burst);
+
+  // Instruments apart start from the limits of every instrument
+  for (auto const &entry : configuration) {
+    auto const separator = entry.first.find('.');
+    if (separator == string::npos) {
+      continue;
+    }
+    auto const limit = details::limit_of_key(entry.first.substr(0, separator));
+    if (limit == nullptr) {
+      continue;
+    }
+    auto const symbol = symbol_t(entry.first.substr(separator + 1));
+    auto &instrument_limits =
+        settings.instrument_limits.emplace(symbol, limits).first->second;
+    instrument_limits.*limit =
+        config_file::convert<double>(entry.first, entry.second);
+  }
+
+  if (settings.orders_per_second < 0 || settings.order_burst < 1) {
+    BOOST_THROW_EXCEPTION(std::invalid_argument(
+        "RiskOrdersPerSecond can't be negative and RiskOrderBurst must be at "
+        "least 1"));
+  }
+  return settings;
+}
+
+string risk_gate::describe(verdict_t verdict) {
+  switch (verdict) {
+    case verdict_t::ACCEPTED:
+      return "accepted";
+    case verdict_t::ORDER_VOLUME:
+      return "order volume over the limit";
+    case verdict_t::POSITION:
+      return "position over the limit once filled";
+    case verdict_t::NO_MARKET:
+      return "no market to check the price against";
+    case verdict_t::PRICE_BAND:
+      return "price too far through the book";
+    case verdict_t::FAT_FINGER:
+      return "price too far from the mid price";
+    case verdict_t::RATE:
+      return "too many orders";
+    case verdict_t::VERDICTS:
+      break;
+  }
+  BOOST_THROW_EXCEPTION(
+      std::runtime_error("describe: Enumeration verdict_t has a wrong value"));
+}
+
+risk_gate::verdict_t risk_gate::check(instrument_id_t id, side_t side,
+                                      price_t price, volume_t volume,
+                                      volume_t replaced) {
+  auto const &risk = entry(id);
+  auto const &limits = risk.limits;
+  auto const order_volume = static_cast<double>(volume);
+  auto const order_price = static_cast<double>(price);
+
+  if (limits.max_order_volume && order_volume > limits.max_order_volume) {
+    return reject(verdict_t::ORDER_VOLUME);
+  }
+
+  // Position once the order and the others working on its side are filled.
+  // Getting closer to flat is always allowed, even over the limit
+  auto const volume_to_fill = order_volume - static_cast<double>(replaced);
+  auto const position =
+      side == side_t::BUY
+          ? risk.position + risk.working_buy + volume_to_fill
+          : risk.position - risk.working_sell - volume_to_fill;
+  if (limits.max_position && std::abs(position) > limits.max_position &&
+      std::abs(position) > std::abs(risk.position)) {
+    return reject(verdict_t::POSITION);
+  }
+
+  // Prices against the book: how far through the other side and how far from
+  // the middle
+  auto const &bbo = m_instruments.bbo(id);
+  if (limits.price_band) {
+    auto const &touch = side == side_t::BUY ? bbo.ask : bbo.bid;
+    if (!touch) {
+      return reject(verdict_t::NO_MARKET);
+    }
+    auto const through = side == side_t::BUY
+                             ? order_price / static_cast<double>(*touch) - 1
+                             : 1 - order_price / static_cast<double>(*touch);
+    if (through > limits.price_band) {
+      return reject(verdict_t::PRICE_BAND);
+    }
+  }
+  if (limits.fat_finger) {
+    if (!bbo.bid || !bbo.ask) {
+      return reject(verdict_t::NO_MARKET);
+    }
+    auto const mid =
+        (static_cast<double>(*bbo.bid) + static_cast<double>(*bbo.ask)) * 0.5;
+    if (std::abs(order_price / mid - 1) > limits.fat_finger) {
+      return reject(verdict_t::FAT_FINGER);
+    }
+  }
+
+  if (!take_token()) {
+    return reject(verdict_t::RATE);
+  }
+  return verdict_t::ACCEPTED;
+}
+
+void risk_gate::set_position(instrument_id_t id, double quantity) {
+  entry(id).position = quantity;
+}
+
+void risk_gate::set_working(instrument_id_t id, double buy_volume,
+                            double sell_volume) {
+  auto &risk = entry(id);
+  risk.working_buy = buy_volume;
+  risk.working_sell = sell_volume;
+}
+
+void risk_gate::grow() {
+  auto const first = m_instruments_risk.size();
+  m_instruments_risk.resize(m_instruments.size(),
+                            instrument_risk_t{m_settings.limits, 0, 0, 0});
+  for (auto id = static_cast<instrument_id_t>(first);
+       id < m_instruments_risk.size(); ++id) {
+    auto const found =
+        m_settings.instrument_limits.find(m_instruments.get(id).symbol);
+    if (found != m_settings.instrument_limits.end()) {
+      m_instruments_risk[id].limits = found->second;
+    }
+  }
+}
+
+bool risk_gate::take_token() {
+  if (!m_settings.orders_per_second) {
+    return true;
+  }
+
+  // Refilled with the time elapsed, never over the burst
+  auto const now = std::chrono::steady_clock::now();
+  std::chrono::duration<double> const elapsed = now - m_refilled;
+  m_refilled = now;
+  m_tokens =
+      std::min(m_settings.order_burst,
+               m_tokens + elapsed.count() * m_settings.orders_per_second);
+
+  if (m_tokens < 1) {
+    return false;
+  }
+  m_tokens -= 1;
+  return true;
+}
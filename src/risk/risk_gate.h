@@ -0,0 +1,139 @@
+#pragma once
+
+#include "../config.h"
+#include "../instruments/instrument_registry.h"
+
+#include <array>
+#include <chrono>
+#include <unordered_map>
+
+/**
+ * Pre-trade checks of the orders of a strategy, before they reach the
+ * session.
+ *
+ * Limits and positions live in a flat array indexed by instrument, next to
+ * each other, and the market comes from the registry's array of BBOs, so a
+ * check is a few loads and comparisons. Orders are also rate limited by a
+ * token bucket shared by every instrument of the session. Limits set to 0
+ * are not checked.
+ *
+ * Used from the thread of the strategy, like the positions it tracks
+ */
+class risk_gate {
+ public:
+  // Limits of an instrument
+  struct limits_t {
+    // Largest volume of an order
+    double max_order_volume = 0;
+
+    // Largest position, long or short, once the order and the ones working on
+    // its side are filled. Orders reducing the position always pass
+    double max_position = 0;
+
+    // Relative distance an order can go through the other side of the book
+    double price_band = 0;
+
+    // Relative distance from the mid price an order can be placed at, either
+    // side, catching prices mistyped
+    double fat_finger = 0;
+  };
+
+  // Limits of every instrument, and of the ones configured apart
+  struct settings_t {
+    limits_t limits;
+    std::unordered_map<symbol_t, limits_t> instrument_limits;
+
+    // Orders allowed per second on average, and at once
+    double orders_per_second = 0;
+    double order_burst = 1;
+  };
+
+  // Result of checking an order
+  enum class verdict_t {
+    ACCEPTED,
+    ORDER_VOLUME,
+    POSITION,
+    NO_MARKET,
+    PRICE_BAND,
+    FAT_FINGER,
+    RATE,
+    VERDICTS
+  };
+
+  /** Constructor */
+  risk_gate(instrument_registry const &instruments,
+            settings_t const &settings);
+
+  /**
+   * @returns the settings read from the configuration. Limits of an
+   * instrument apart are read from the same keys followed by its symbol,
+   * RiskMaxPosition.BTC-PERPETUAL for instance
+   */
+  static settings_t load_settings(config_file_t const &configuration);
+
+  /** @returns a description of a verdict, for the reports */
+  static string describe(verdict_t verdict);
+
+  /**
+   * Checks an order against the limits of its instrument and the current
+   * market. Accepted orders take a token from the rate limit. A replace gives
+   * the volume still working of the order it replaces, it doesn't count twice
+   */
+  verdict_t check(instrument_id_t id, side_t side, price_t price,
+                  volume_t volume, volume_t replaced = volume_t(0));
+
+  /** Sets the position of an instrument, signed */
+  void set_position(instrument_id_t id, double quantity);
+
+  /** Sets the volume of the orders of an instrument working on each side */
+  void set_working(instrument_id_t id, double buy_volume, double sell_volume);
+
+  /** @returns the orders refused for a reason since the start */
+  size_t rejections(verdict_t verdict) const {
+    return m_rejections[static_cast<size_t>(verdict)];
+  }
+
+ private:
+  // Limits, position and working orders of an instrument, checked together
+  struct instrument_risk_t {
+    limits_t limits;
+    double position;
+    double working_buy;
+    double working_sell;
+  };
+
+  // Entry of an instrument, growing the array for instruments added to the
+  // registry after the last check
+  instrument_risk_t &entry(instrument_id_t id) {
+    if (id >= m_instruments_risk.size()) {
+      grow();
+    }
+    return m_instruments_risk[id];
+  }
+  void grow();
+
+  // Takes a token from the rate limit if there is any
+  bool take_token();
+
+  // Counts a verdict refusing an order
+  verdict_t reject(verdict_t verdict) {
+    ++m_rejections[static_cast<size_t>(verdict)];
+    return verdict;
+  }
+
+  // Instruments and their market
+  instrument_registry const &m_instruments;
+
+  // Limits read from the configuration
+  settings_t m_settings;
+
+  // Limits and position by instrument
+  vector<instrument_risk_t> m_instruments_risk;
+
+  // Orders that can be sent now, and last time they were refilled
+  double m_tokens;
+  std::chrono::steady_clock::time_point m_refilled;
+
+  // Orders refused by verdict
+  std::array<size_t, static_cast<size_t>(verdict_t::VERDICTS)> m_rejections;
+};
@@ -0,0 +1,96 @@
+#include "thread_settings.h"
+
+#include "../memory/arena.h"
+
+#include <boost/algorithm/string/trim.hpp>
+
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace details {
+
+// Longest thread name allowed by the system
+size_t const max_thread_name = 15;
+
+/**
+ * @returns the cores listed in a configuration entry, separated by commas
+ * with optional spaces around them
+ */
+vector<int> parse_cores(string const &entry) {
+  vector<int> cores;
+  std::stringstream stream(entry);
+  string core;
+  while (std::getline(stream, core, ',')) {
+    boost::algorithm::trim(core);
+    if (!core.empty()) {
+      cores.push_back(boost::lexical_cast<int>(core));
+    }
+  }
+  return cores;
+}
+
+}  // namespace details
+
+namespace threads {
+
+thread_settings_t load_thread_settings(config_file_t const &configuration,
+                                       string const &role) {
+  thread_settings_t settings;
+  settings.name =
+      config_file::get<string>(configuration, role + "ThreadName", "");
+  settings.cores = details::parse_cores(
+      config_file::get<string>(configuration, role + "ThreadCores", ""));
+  settings.priority =
+      config_file::get(configuration, role + "ThreadPriority", 0);
+  settings.memory =
+      config_file::get<size_t>(configuration, role + "ThreadMemory", 0);
+  return settings;
+}
+
+void apply_thread_settings(thread_settings_t const &settings) {
+#ifdef __linux__
+  auto const thread = pthread_self();
+
+  if (!settings.name.empty()) {
+    auto const name = settings.name.substr(0, details::max_thread_name);
+    pthread_setname_np(thread, name.c_str());
+  }
+
+  if (!settings.cores.empty()) {
+    cpu_set_t cores;
+    CPU_ZERO(&cores);
+    for (auto const core : settings.cores) {
+      CPU_SET(core, &cores);
+    }
+    auto const error = pthread_setaffinity_np(thread, sizeof(cores), &cores);
+    if (error != 0) {
+      std::cerr << "Impossible to pin thread " << settings.name << ": "
+                << std::strerror(error) << std::endl;
+    }
+  }
+
+  if (settings.priority > 0) {
+    sched_param parameters{};
+    parameters.sched_priority = settings.priority;
+    auto const error = pthread_setschedparam(thread, SCHED_FIFO, &parameters);
+    if (error != 0) {
+      std::cerr << "Impossible to set real time priority to thread "
+                << settings.name << ": " << std::strerror(error) << std::endl;
+    }
+  }
+#endif
+
+  // Pages go to the node of the core touching them first, once pinned it's
+  // the local one
+  if (settings.memory > 0) {
+    thread_arena().reserve(settings.memory);
+  }
+}
+
+}  // namespace threads
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "../config.h"
+
+/**
+ * Where and how a thread of the engine runs.
+ *
+ * Read from the configuration with a role as prefix, "Network" or "Strategy"
+ * for instance:
+ * - <Role>ThreadName: name shown by the system tools
+ * - <Role>ThreadCores: cores the thread is pinned to, separated by commas
+ * - <Role>ThreadPriority: real time priority (1 to 99), 0 to keep the default
+ * - <Role>ThreadMemory: bytes of the thread's arena placed on its NUMA node
+ */
+struct thread_settings_t {
+  string name;
+  vector<int> cores;
+  int priority = 0;
+  size_t memory = 0;
+};
+
+namespace threads {
+
+/**
+ * @returns the settings of a role, missing entries keep the thread as it is
+ */
+thread_settings_t load_thread_settings(config_file_t const &configuration,
+                                       string const &role);
+
+/**
+ * Applies the settings to the calling thread. What the system doesn't allow,
+ * like real time scheduling without privileges, is reported and skipped
+ */
+void apply_thread_settings(thread_settings_t const &settings);
+
+}  // namespace threads
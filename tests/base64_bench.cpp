@@ -0,0 +1,54 @@
+#include "../src/quickfix/base64/base64.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Throughput of the decoder chosen for the processor against the portable
+// one, on inputs of the size of the signatures and of larger payloads
+
+namespace {
+
+using decoder_t = size_t (*)(char const *, size_t, unsigned char *);
+
+// Megabytes of characters decoded per second
+double measure(decoder_t decoder, std::string const &encoded,
+               size_t decoded_size) {
+  std::vector<unsigned char> output(
+      Deribit::base64_decoded_size(encoded.size()));
+  auto const repetitions = 100000000 / (encoded.size() + 16);
+  size_t checksum = 0;
+  auto const start = std::chrono::steady_clock::now();
+  for (size_t repetition = 0; repetition < repetitions; ++repetition) {
+    checksum += decoder(encoded.data(), encoded.size(), output.data());
+  }
+  std::chrono::duration<double> const elapsed =
+      std::chrono::steady_clock::now() - start;
+  if (checksum != repetitions * decoded_size) {
+    std::cerr << "Decoded sizes not matching" << std::endl;
+  }
+  return repetitions * encoded.size() / elapsed.count() / 1e6;
+}
+
+}  // namespace
+
+int main() {
+  std::mt19937 random(42);
+  for (size_t const size : {24, 33, 48, 96, 1024, 65536}) {
+    std::vector<unsigned char> bytes(size);
+    for (auto &byte : bytes) {
+      byte = static_cast<unsigned char>(random());
+    }
+    std::string encoded(Deribit::base64_encoded_size(size), '\0');
+    Deribit::base64_encode(bytes.data(), size, &encoded[0]);
+
+    std::cout << size << " bytes: scalar "
+              << measure(Deribit::base64_decode_scalar, encoded, size)
+              << " MB/s, vectorized "
+              << measure(Deribit::base64_decode, encoded, size) << " MB/s"
+              << std::endl;
+  }
+  return 0;
+}
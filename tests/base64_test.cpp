@@ -0,0 +1,109 @@
+#include "check.h"
+
+#include "../src/quickfix/base64/base64.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+// The decoder chosen for the processor, vectorized when it can, against the
+// portable one
+
+namespace {
+
+// Decodes with both decoders, the results must be the same
+void check_decoders(std::string const &encoded) {
+  std::vector<unsigned char> fast(
+      Deribit::base64_decoded_size(encoded.size()) + 1, 0xAA);
+  std::vector<unsigned char> scalar(fast.size(), 0xAA);
+  auto const fast_size =
+      Deribit::base64_decode(encoded.data(), encoded.size(), fast.data());
+  auto const scalar_size = Deribit::base64_decode_scalar(
+      encoded.data(), encoded.size(), scalar.data());
+  CHECK(fast_size == scalar_size);
+  CHECK(std::equal(fast.begin(), fast.begin() + scalar_size, scalar.begin()));
+
+  // Nothing written after what is decoded, but for the guard byte
+  CHECK(fast_size < fast.size());
+}
+
+// Encodes with both encoders, the results must be the same
+std::string check_encoders(std::vector<unsigned char> const &bytes) {
+  std::string fast(Deribit::base64_encoded_size(bytes.size()), '\0');
+  std::string scalar(fast.size(), '\0');
+  auto const fast_size =
+      Deribit::base64_encode(bytes.data(), bytes.size(), &fast[0]);
+  auto const scalar_size =
+      Deribit::base64_encode_scalar(bytes.data(), bytes.size(), &scalar[0]);
+  CHECK(fast_size == scalar_size);
+  CHECK(fast == scalar);
+  return fast;
+}
+
+void test_known_values() {
+  std::string const bytes[] = {"", "f", "fo", "foo", "foob", "fooba",
+                               "foobar"};
+  std::string const encoded[] = {"",         "Zg==",     "Zm8=",    "Zm9v",
+                                 "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy"};
+  for (size_t index = 0; index < 7; ++index) {
+    auto const &text = bytes[index];
+    CHECK(Deribit::base64_encode(
+              reinterpret_cast<unsigned char const *>(text.data()),
+              static_cast<unsigned int>(text.size())) == encoded[index]);
+    CHECK(Deribit::base64_decode(encoded[index]) == text);
+  }
+}
+
+void test_lengths() {
+  // Every length around the blocks of 16 and 32 characters, with every tail
+  // of 0 to 3 characters once the padding is removed
+  std::mt19937 random(42);
+  for (size_t size = 0; size < 300; ++size) {
+    std::vector<unsigned char> bytes(size);
+    for (auto &byte : bytes) {
+      byte = static_cast<unsigned char>(random());
+    }
+    auto const encoded = check_encoders(bytes);
+    check_decoders(encoded);
+
+    auto unpadded = encoded;
+    unpadded.erase(unpadded.find_last_not_of('=') + 1);
+    check_decoders(unpadded);
+    for (size_t tail = 1; tail <= 3 && tail <= unpadded.size(); ++tail) {
+      check_decoders(unpadded.substr(0, unpadded.size() - tail));
+    }
+
+    std::string decoded(Deribit::base64_decoded_size(encoded.size()), '\0');
+    decoded.resize(Deribit::base64_decode(
+        encoded.data(), encoded.size(),
+        reinterpret_cast<unsigned char *>(&decoded[0])));
+    CHECK(decoded == std::string(bytes.begin(), bytes.end()));
+  }
+}
+
+void test_invalid_characters() {
+  // Decoding stops at the first character not in base64, wherever it is in
+  // the blocks of the vectorized decoder
+  std::string valid;
+  for (int index = 0; index < 96; ++index) {
+    valid += "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"
+        [index % 64];
+  }
+  for (char const invalid : {'=', '!', ' ', '\n', '\0', '\x80', '\xff'}) {
+    for (size_t position = 0; position < valid.size(); ++position) {
+      auto encoded = valid;
+      encoded[position] = invalid;
+      check_decoders(encoded);
+    }
+  }
+}
+
+}  // namespace
+
+int main() {
+  test_known_values();
+  test_lengths();
+  test_invalid_characters();
+  return tests::report();
+}
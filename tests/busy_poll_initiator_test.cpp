@@ -0,0 +1,207 @@
+#include "check.h"
+#include "fix_message.h"
+
+#include "../src/quickfix/busy_poll_initiator.h"
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <sstream>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <quickfix/Log.h>
+#include <quickfix/MessageStore.h>
+
+// Loopback test of the busy poll initiator: an acceptor on a local socket
+// logs the session on and sends it market data, the fast path must take the
+// incremental refreshes and leave the session in sequence for the rest
+
+namespace {
+
+// Application counting the messages the sessions pass to it
+class counting_application : public FIX::Application {
+ public:
+  void onCreate(FIX::SessionID const &) override {}
+  void onLogon(FIX::SessionID const &) override { ++logons; }
+  void onLogout(FIX::SessionID const &) override {}
+  void toAdmin(FIX::Message &, FIX::SessionID const &) override {}
+  void toApp(FIX::Message &, FIX::SessionID const &) throw(
+      FIX::DoNotSend) override {}
+  void fromAdmin(FIX::Message const &, FIX::SessionID const &) throw(
+      FIX::FieldNotFound, FIX::IncorrectDataFormat, FIX::IncorrectTagValue,
+      FIX::RejectLogon) override {}
+  void fromApp(FIX::Message const &, FIX::SessionID const &) throw(
+      FIX::FieldNotFound, FIX::IncorrectDataFormat, FIX::IncorrectTagValue,
+      FIX::UnsupportedMessageType) override {
+    ++applications;
+  }
+
+  std::atomic<int> logons{0};
+  std::atomic<int> applications{0};
+};
+
+// Current time as a SendingTime, the sessions check its latency
+std::string sending_time() {
+  auto const now = std::time(nullptr);
+  char text[32];
+  std::strftime(text, sizeof(text), "%Y%m%d-%H:%M:%S", std::gmtime(&now));
+  return text;
+}
+
+// Message of the acceptor to the initiator
+std::string from_acceptor(
+    std::string const &type, int sequence,
+    std::vector<std::pair<int, std::string>> const &fields) {
+  std::vector<std::pair<int, std::string>> all = {
+      {49, "SERVER"},
+      {56, "CLIENT"},
+      {34, std::to_string(sequence)},
+      {52, sending_time()}};
+  all.insert(all.end(), fields.begin(), fields.end());
+  return tests::compose_message(type, all);
+}
+
+// Reads the next message sent to the acceptor, empty on timeout
+std::string receive(int socket, std::string &stream) {
+  auto const deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (std::chrono::steady_clock::now() < deadline) {
+    auto const trailer = stream.find("\x01" "10=");
+    if (trailer != std::string::npos &&
+        stream.size() >= trailer + 8) {
+      auto const message = stream.substr(0, trailer + 8);
+      stream.erase(0, trailer + 8);
+      return message;
+    }
+
+    char buffer[4096];
+    auto const result = ::recv(socket, buffer, sizeof(buffer), 0);
+    if (result <= 0) {
+      break;
+    }
+    stream.append(buffer, static_cast<size_t>(result));
+  }
+  return {};
+}
+
+// Field of a message received, empty when missing
+std::string field_of(std::string const &message, int tag) {
+  auto const key = "\x01" + std::to_string(tag) + "=";
+  auto const start = message.find(key);
+  if (start == std::string::npos) {
+    return {};
+  }
+  auto const value = start + key.size();
+  return message.substr(value, message.find('\x01', value) - value);
+}
+
+}  // namespace
+
+int main() {
+  // Acceptor listening on a free local port
+  auto const listener = ::socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t size = sizeof(address);
+  if (::bind(listener, reinterpret_cast<sockaddr *>(&address), size) != 0 ||
+      ::listen(listener, 1) != 0 ||
+      ::getsockname(listener, reinterpret_cast<sockaddr *>(&address),
+                    &size) != 0) {
+    std::cerr << "Impossible to listen on a local port" << std::endl;
+    return 1;
+  }
+
+  std::stringstream configuration;
+  configuration << "[DEFAULT]\n"
+                   "ConnectionType=initiator\n"
+                   "ReconnectInterval=1\n"
+                   "HeartBtInt=30\n"
+                   "StartTime=00:00:00\n"
+                   "EndTime=00:00:00\n"
+                   "UseDataDictionary=N\n"
+                   "SocketConnectHost=127.0.0.1\n"
+                   "SocketConnectPort="
+                << ntohs(address.sin_port)
+                << "\n"
+                   "[SESSION]\n"
+                   "BeginString=FIX.4.4\n"
+                   "SenderCompID=CLIENT\n"
+                   "TargetCompID=SERVER\n";
+  FIX::SessionSettings session_settings(configuration);
+  counting_application application;
+  FIX::MemoryStoreFactory store_factory;
+  FIX::ScreenLogFactory log_factory(false, false, false);
+
+  FIX::busy_poll_initiator::settings_t settings;
+  settings.fast_decoder = true;
+  FIX::busy_poll_initiator initiator(application, store_factory,
+                                     session_settings, log_factory, settings);
+  std::atomic<int> fast_messages{0};
+  std::string fast_symbol;
+  initiator.set_fast_path(
+      "X", [&](FIX::raw_message const &message, FIX::SessionID const &) {
+        auto const *symbol = message.find(55);
+        fast_symbol = symbol == nullptr ? "" : *symbol;
+        ++fast_messages;
+        return true;
+      });
+  initiator.start();
+
+  auto const connection = ::accept(listener, nullptr, nullptr);
+  timeval timeout{5, 0};
+  setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  std::string stream;
+
+  // Logon
+  auto const logon = receive(connection, stream);
+  CHECK(field_of(logon, 35) == "A");
+  auto const reply =
+      from_acceptor("A", 1, {{98, "0"}, {108, "30"}});
+  ::send(connection, reply.data(), reply.size(), 0);
+
+  // Market data through the fast path, then a test request through the
+  // session: it only answers when the fast path kept it in sequence
+  auto const update = from_acceptor(
+      "X", 2, {{55, "BTC-PERPETUAL"}, {268, "1"}, {279, "0"}, {269, "0"},
+               {270, "42000"}, {271, "10"}});
+  auto const test_request = from_acceptor("1", 3, {{112, "loopback"}});
+  auto const messages = update + test_request;
+  ::send(connection, messages.data(), messages.size(), 0);
+
+  std::string heartbeat;
+  for (auto message = receive(connection, stream); !message.empty();
+       message = receive(connection, stream)) {
+    if (field_of(message, 35) == "0") {
+      heartbeat = message;
+      break;
+    }
+    // A resend request means the session missed the sequence number
+    CHECK(field_of(message, 35) != "2");
+  }
+  CHECK(field_of(heartbeat, 112) == "loopback");
+  CHECK(application.logons == 1);
+  CHECK(fast_messages == 1);
+  CHECK(fast_symbol == "BTC-PERPETUAL");
+  CHECK(application.applications == 0);
+
+  // Sent again: the session handles it
+  auto const resent = from_acceptor(
+      "X", 4, {{43, "Y"}, {122, sending_time()}, {55, "BTC-PERPETUAL"},
+               {268, "1"}, {279, "0"}, {269, "0"}, {270, "42000"},
+               {271, "10"}});
+  ::send(connection, resent.data(), resent.size(), 0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  CHECK(fast_messages == 1);
+  CHECK(application.applications == 1);
+
+  initiator.stop(true);
+  ::close(connection);
+  ::close(listener);
+  return tests::report();
+}
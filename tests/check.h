@@ -0,0 +1,36 @@
+#pragma once
+
+#include <iostream>
+
+namespace tests {
+
+/**
+ * Expectations failed so far by the test
+ */
+inline int &failures() {
+  static int failures = 0;
+  return failures;
+}
+
+/**
+ * Reports the result of the test, @returns the exit code of its main
+ */
+inline int report() {
+  if (failures() != 0) {
+    std::cerr << failures() << " expectation(s) failed" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+}  // namespace tests
+
+// Reports a failed expectation without stopping the test
+#define CHECK(condition)                                                    \
+  do {                                                                      \
+    if (!(condition)) {                                                     \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": " << #condition       \
+                << " failed" << std::endl;                                  \
+      ++tests::failures();                                                  \
+    }                                                                       \
+  } while (false)
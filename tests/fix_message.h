@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tests {
+
+/**
+ * Composes a FIX 4.4 message of a type from the fields following MsgType,
+ * with its body length and its checksum
+ */
+inline std::string compose_message(
+    std::string const &type,
+    std::vector<std::pair<int, std::string>> const &fields) {
+  auto body = "35=" + type + '\x01';
+  for (auto const &field : fields) {
+    body += std::to_string(field.first) + '=' + field.second + '\x01';
+  }
+
+  auto message = "8=FIX.4.4\x01" "9=" + std::to_string(body.size()) + '\x01' +
+                 body;
+  unsigned checksum = 0;
+  for (auto const byte : message) {
+    checksum += static_cast<unsigned char>(byte);
+  }
+  char trailer[8];
+  std::snprintf(trailer, sizeof(trailer), "10=%03u\x01", checksum % 256);
+  return message + trailer;
+}
+
+}  // namespace tests
@@ -0,0 +1,219 @@
+#include "check.h"
+
+#include "../src/portfolio/pnl_ledger.h"
+
+#include <cmath>
+#include <cstdlib>
+
+// Profit and loss of inverse futures and of a linear option along the
+// life of their positions, and the checkpoint the ledger is reloaded from
+
+namespace {
+
+double const fee_rate = 0.0005;
+
+bool near(double value, double expected) {
+  return std::abs(value - expected) < 1e-9;
+}
+
+// Registry of a folder of its own with two futures and an option
+struct market_t {
+  explicit market_t(string const &folder) : instruments(folder) {
+    instruments_list_t list;
+    instrument_t future;
+    future.symbol = "BTC-PERPETUAL";
+    future.contract_multiplier = 10;
+    future.set(instrument_t::CONTRACT_MULTIPLIER);
+    list.push_back(future);
+
+    instrument_t other_future;
+    other_future.symbol = "ETH-PERPETUAL";
+    other_future.contract_multiplier = 10;
+    other_future.set(instrument_t::CONTRACT_MULTIPLIER);
+    list.push_back(other_future);
+
+    instrument_t option;
+    option.symbol = "BTC-27DEC24-60000-C";
+    option.contract_multiplier = 1;
+    option.put_call = option_type_t::CALL;
+    option.set(instrument_t::CONTRACT_MULTIPLIER);
+    option.set(instrument_t::PUT_CALL);
+    list.push_back(option);
+
+    instruments.update(list);
+    future_id = *instruments.find("BTC-PERPETUAL");
+    other_future_id = *instruments.find("ETH-PERPETUAL");
+    option_id = *instruments.find("BTC-27DEC24-60000-C");
+  }
+
+  instrument_registry instruments;
+  instrument_id_t future_id;
+  instrument_id_t other_future_id;
+  instrument_id_t option_id;
+};
+
+pnl_ledger::settings_t ledger_settings() {
+  pnl_ledger::settings_t settings;
+  settings.fee_rate = fee_rate;
+  return settings;
+}
+
+// Position of the future opened, increased, partially closed and flipped.
+// Its value is the notional over the price
+void test_future(pnl_ledger &ledger, instrument_id_t id) {
+  // Open: 100 USD at 100, one coin
+  ledger.on_fill(id, side_t::BUY, volume_t(10), price_t(100));
+  auto pnl = ledger.get(id);
+  CHECK(near(pnl.position, 10));
+  CHECK(near(pnl.entry_value, 1));
+  CHECK(near(ledger.cost_basis(id), 100));
+  CHECK(near(pnl.fees, fee_rate));
+
+  // Increase: the average cost of 200 USD for 1.5 coins
+  ledger.on_fill(id, side_t::BUY, volume_t(10), price_t(200));
+  pnl = ledger.get(id);
+  CHECK(near(pnl.position, 20));
+  CHECK(near(pnl.entry_value, 1.5));
+  CHECK(near(ledger.cost_basis(id), 200 / 1.5));
+  CHECK(near(pnl.realized, 0));
+
+  // Partial close: a quarter of the value paid against 50 USD at 150
+  ledger.on_fill(id, side_t::SELL, volume_t(5), price_t(150));
+  pnl = ledger.get(id);
+  CHECK(near(pnl.position, 15));
+  CHECK(near(pnl.entry_value, 1.125));
+  CHECK(near(pnl.realized, 0.375 - 50.0 / 150));
+  CHECK(near(ledger.cost_basis(id), 200 / 1.5));
+
+  // Flip: closes the rest at 200 and opens a short at that price
+  ledger.on_fill(id, side_t::SELL, volume_t(25), price_t(200));
+  pnl = ledger.get(id);
+  CHECK(near(pnl.position, -10));
+  CHECK(near(pnl.entry_value, -0.5));
+  CHECK(near(pnl.realized, 0.375 - 50.0 / 150 + 1.125 - 150.0 / 200));
+  CHECK(near(ledger.cost_basis(id), 200));
+  CHECK(pnl.fills == 4);
+  CHECK(near(pnl.fees,
+             fee_rate * (1 + 0.5 + 50.0 / 150 + 250.0 / 200)));
+
+  // The short gains when the price halves
+  BBO_t bbo;
+  bbo.bid = price_t(99);
+  bbo.ask = price_t(101);
+  ledger.mark(id, bbo);
+  CHECK(near(ledger.unrealized(id), 0.5));
+
+  // Closed at its cost, nothing is left
+  ledger.on_fill(id, side_t::BUY, volume_t(10), price_t(200));
+  pnl = ledger.get(id);
+  CHECK(pnl.position == 0);
+  CHECK(pnl.entry_value == 0);
+  CHECK(near(ledger.cost_basis(id), 0));
+  CHECK(near(ledger.unrealized(id), 0));
+}
+
+// Orders filled in parts at different prices. Every part is applied at its
+// own price (LastPx), not at the average of the order (AvgPx)
+void test_partial_fills(pnl_ledger &ledger, instrument_id_t id) {
+  // Bought 40 USD at 100 then 60 USD at 200: 0.7 coins for 100 USD, the
+  // average of the order
+  ledger.on_fill(id, side_t::BUY, volume_t(4), price_t(100));
+  ledger.on_fill(id, side_t::BUY, volume_t(6), price_t(200));
+  auto pnl = ledger.get(id);
+  CHECK(near(pnl.position, 10));
+  CHECK(near(pnl.entry_value, 0.7));
+  CHECK(near(ledger.cost_basis(id), 100 / 0.7));
+
+  // Sold in two halves, each releasing half of the value paid
+  ledger.on_fill(id, side_t::SELL, volume_t(5), price_t(250));
+  pnl = ledger.get(id);
+  CHECK(near(pnl.realized, 0.35 - 50.0 / 250));
+  CHECK(near(ledger.cost_basis(id), 100 / 0.7));
+
+  ledger.on_fill(id, side_t::SELL, volume_t(5), price_t(125));
+  pnl = ledger.get(id);
+  CHECK(pnl.position == 0);
+  CHECK(near(pnl.realized, 0.35 - 50.0 / 250 + 0.35 - 50.0 / 125));
+  CHECK(near(pnl.fees, fee_rate * (0.4 + 0.3 + 50.0 / 250 + 50.0 / 125)));
+  CHECK(pnl.fills == 4);
+}
+
+// Position of the option, whose value is the volume times the price
+void test_option(pnl_ledger &ledger, instrument_id_t id) {
+  ledger.on_fill(id, side_t::BUY, volume_t(2), price_t(0.05));
+  CHECK(near(ledger.cost_basis(id), 0.05));
+  ledger.on_fill(id, side_t::SELL, volume_t(1), price_t(0.08));
+  auto const pnl = ledger.get(id);
+  CHECK(near(pnl.position, 1));
+  CHECK(near(pnl.realized, 0.03));
+  CHECK(near(pnl.fees, fee_rate * (0.1 + 0.08)));
+
+  BBO_t bbo;
+  bbo.bid = price_t(0.06);
+  bbo.ask = price_t(0.08);
+  ledger.mark(id, bbo);
+  CHECK(near(ledger.unrealized(id), 0.02));
+}
+
+// The position of the exchange replaces the ledger's, realized profits stay
+void test_reconcile(pnl_ledger &ledger, instrument_id_t id) {
+  auto const before = ledger.get(id);
+  ledger.reconcile(id, before.position, price_t(1000));
+  CHECK(near(ledger.get(id).entry_value, before.entry_value));
+
+  ledger.reconcile(id, 30, price_t(100));
+  auto const pnl = ledger.get(id);
+  CHECK(near(pnl.position, 30));
+  CHECK(near(pnl.entry_value, 3));
+  CHECK(near(ledger.cost_basis(id), 100));
+  CHECK(near(pnl.realized, before.realized));
+  CHECK(pnl.fills == before.fills);
+}
+
+}  // namespace
+
+int main() {
+  char folder_template[] = "/tmp/pnl_ledger_test_XXXXXX";
+  auto const *const folder = ::mkdtemp(folder_template);
+  if (folder == nullptr) {
+    std::cerr << "Impossible to create a temporary folder" << std::endl;
+    return 1;
+  }
+  auto const aux_folder = string(folder) + "/";
+  market_t market(aux_folder);
+
+  pnl_ledger::pnl_t future;
+  pnl_ledger::pnl_t option;
+  {
+    pnl_ledger ledger(market.instruments, aux_folder, ledger_settings());
+    test_future(ledger, market.future_id);
+    test_partial_fills(ledger, market.other_future_id);
+    test_option(ledger, market.option_id);
+    test_reconcile(ledger, market.future_id);
+
+    auto const totals = ledger.totals();
+    future = ledger.get(market.future_id);
+    option = ledger.get(market.option_id);
+    auto const other_future = ledger.get(market.other_future_id);
+    CHECK(near(totals.realized,
+               future.realized + other_future.realized + option.realized));
+    CHECK(near(totals.fees, future.fees + other_future.fees + option.fees));
+  }
+
+  // Reloaded from the checkpoint stored when destroyed, marks aside
+  {
+    pnl_ledger ledger(market.instruments, aux_folder, ledger_settings());
+    for (auto const &expected : {std::make_pair(market.future_id, future),
+                                 std::make_pair(market.option_id, option)}) {
+      auto const pnl = ledger.get(expected.first);
+      CHECK(near(pnl.position, expected.second.position));
+      CHECK(near(pnl.entry_value, expected.second.entry_value));
+      CHECK(near(pnl.realized, expected.second.realized));
+      CHECK(near(pnl.fees, expected.second.fees));
+      CHECK(pnl.fills == expected.second.fills);
+    }
+  }
+
+  std::system(("rm -rf " + aux_folder).c_str());
+  return tests::report();
+}
@@ -0,0 +1,103 @@
+#include "check.h"
+#include "fix_message.h"
+
+#include "../src/quickfix/raw_message.h"
+
+#include <iterator>
+
+namespace {
+
+// Incremental refresh with two entries
+std::string const incremental = tests::compose_message(
+    "X", {{49, "SERVER"},
+          {56, "CLIENT"},
+          {34, "12"},
+          {52, "20240102-03:04:05.678"},
+          {55, "BTC-PERPETUAL"},
+          {268, "2"},
+          {279, "0"},
+          {269, "0"},
+          {270, "42000.5"},
+          {271, "10"},
+          {279, "2"},
+          {269, "1"},
+          {270, "42001"},
+          {271, "0"}});
+
+void test_header() {
+  FIX::raw_message message;
+  CHECK(message.parse(incremental));
+  CHECK(message.type() == "X");
+  CHECK(message.sequence() == 12);
+  CHECK(!message.possible_duplicate());
+  CHECK(message.find(55) != nullptr && *message.find(55) == "BTC-PERPETUAL");
+  CHECK(message.find(58) == nullptr);
+
+  auto const resent = tests::compose_message("X", {{34, "3"}, {43, "Y"}});
+  CHECK(message.parse(resent));
+  CHECK(message.possible_duplicate());
+  CHECK(message.sequence() == 3);
+}
+
+void test_group() {
+  FIX::raw_message message;
+  CHECK(message.parse(incremental));
+
+  int symbols = 0;
+  for (auto const &field : message.before(268)) {
+    CHECK(field.first != 268 && field.first != 279);
+    symbols += field.first == 55;
+  }
+  CHECK(symbols == 1);
+
+  std::vector<FIX::raw_message::range_t> entries;
+  CHECK(message.group(268, entries));
+  CHECK(entries.size() == 2);
+  if (entries.size() == 2) {
+    CHECK(std::distance(entries[0].begin(), entries[0].end()) == 4);
+    CHECK(std::distance(entries[1].begin(), entries[1].end()) == 4);
+    CHECK(entries[0].begin()->second.getString() == "0");
+    CHECK(entries[1].begin()->second.getString() == "2");
+    CHECK((entries[1].end() - 1)->first == 271);
+  }
+
+  // Missing group, and a count not matching the entries
+  CHECK(message.parse(tests::compose_message("X", {{55, "ETH"}})));
+  CHECK(!message.group(268, entries));
+  CHECK(message.parse(
+      tests::compose_message("X", {{268, "2"}, {279, "0"}, {269, "0"}})));
+  CHECK(!message.group(268, entries));
+}
+
+void test_malformed() {
+  FIX::raw_message message;
+
+  // Checksum and body length not matching the message
+  auto wrong_checksum = incremental;
+  wrong_checksum[wrong_checksum.size() - 2] =
+      wrong_checksum[wrong_checksum.size() - 2] == '0' ? '1' : '0';
+  CHECK(!message.parse(wrong_checksum));
+
+  auto wrong_length = incremental;
+  wrong_length.replace(wrong_length.find("\x01" "9=") + 3, 1, "9");
+  CHECK(!message.parse(wrong_length));
+
+  // Truncated, without a trailer, without a tag
+  CHECK(!message.parse(incremental.substr(0, incremental.size() - 1)));
+  CHECK(!message.parse("8=FIX.4.4\x01" "9=5\x01" "35=0\x01"));
+  CHECK(!message.parse("8=FIX.4.4\x01" "=5\x01" "35=0\x01" "10=000\x01"));
+  CHECK(!message.parse(""));
+
+  // Still usable after a failure
+  CHECK(message.parse(incremental));
+  CHECK(message.sequence() == 12);
+}
+
+}  // namespace
+
+int main() {
+  test_header();
+  test_group();
+  test_malformed();
+  return tests::report();
+}
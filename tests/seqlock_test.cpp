@@ -0,0 +1,95 @@
+#include "check.h"
+
+#include "../src/monitoring/seqlock.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// A writer publishing values whose fields are all the same number while
+// readers copy them: a torn copy would mix two values
+
+namespace {
+
+struct value_t {
+  size_t fields[32];
+};
+
+value_t value_of(size_t number) {
+  value_t value;
+  for (auto &field : value.fields) {
+    field = number;
+  }
+  return value;
+}
+
+bool consistent(value_t const &value) {
+  for (auto const field : value.fields) {
+    if (field != value.fields[0]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void test_single_thread() {
+  seqlock<value_t> published;
+  CHECK(published.published() == 0);
+  CHECK(published.load().fields[0] == 0);
+
+  published.store(value_of(7));
+  CHECK(published.published() == 1);
+  CHECK(published.load().fields[31] == 7);
+
+  published.store(value_of(8));
+  CHECK(published.published() == 2);
+  CHECK(consistent(published.load()));
+  CHECK(published.load().fields[0] == 8);
+}
+
+void test_concurrent_readers() {
+  size_t const values = 200000;
+  seqlock<value_t> published;
+  std::atomic<bool> writing{true};
+  std::atomic<int> torn{0};
+  std::atomic<int> backwards{0};
+
+  std::vector<std::thread> readers;
+  for (int reader = 0; reader < 3; ++reader) {
+    readers.emplace_back([&] {
+      size_t last = 0;
+      while (writing.load(std::memory_order_relaxed)) {
+        auto const value = published.load();
+        if (!consistent(value)) {
+          ++torn;
+        }
+        // A single writer publishes increasing numbers
+        if (value.fields[0] < last) {
+          ++backwards;
+        }
+        last = value.fields[0];
+      }
+    });
+  }
+
+  for (size_t number = 1; number <= values; ++number) {
+    published.store(value_of(number));
+  }
+  writing = false;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  CHECK(torn == 0);
+  CHECK(backwards == 0);
+  CHECK(published.published() == values);
+  CHECK(published.load().fields[0] == values);
+}
+
+}  // namespace
+
+int main() {
+  test_single_thread();
+  test_concurrent_readers();
+  return tests::report();
+}
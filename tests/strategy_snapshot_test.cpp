@@ -0,0 +1,62 @@
+#include "check.h"
+
+#include "../src/monitoring/strategy_snapshot.h"
+
+#include <limits>
+
+// Snapshots rendered for the dashboards: the JSON is compared as a whole
+
+namespace {
+
+double const missing = std::numeric_limits<double>::quiet_NaN();
+
+void test_empty() {
+  strategy_snapshot_t snapshot{};
+  snapshot.timestamp = 1700000000000000;
+  CHECK(to_json(snapshot) ==
+        "{\"timestamp\":1700000000000000,\"positions\":[],"
+        "\"positions_dropped\":0,\"orders\":[],\"books\":[],"
+        "\"total_delta\":0,\"pnl\":{\"realized\":0,\"unrealized\":0,"
+        "\"fees\":0},\"latency\":{\"evaluations\":0,\"last_ns\":0,"
+        "\"max_ns\":0,\"mean_ns\":0}}\n");
+}
+
+void test_entries() {
+  strategy_snapshot_t snapshot{};
+  snapshot.timestamp = 1;
+  snapshot.positions_count = 2;
+  snapshot.positions_dropped = 3;
+  snapshot.positions[0] = {"BTC-PERPETUAL", -10, -0.25};
+  snapshot.positions[1] = {"BTC-27DEC24-60000-C", 1, missing};
+  snapshot.orders_count = 1;
+  snapshot.orders[0] = {"42", "BTC-PERPETUAL", side_t::SELL, 42000.5, 30, 10};
+  snapshot.books_count = 1;
+  snapshot.books[0] = {"BTC-PERPETUAL", 100, 42000, missing, missing};
+  snapshot.total_delta = 0.125;
+  snapshot.realized = 0.5;
+  snapshot.unrealized = -0.25;
+  snapshot.fees = 0.001;
+  snapshot.latency = {4, 100, 300, 800};
+
+  CHECK(to_json(snapshot) ==
+        "{\"timestamp\":1,\"positions\":["
+        "{\"symbol\":\"BTC-PERPETUAL\",\"quantity\":-10,\"delta\":-0.25},"
+        "{\"symbol\":\"BTC-27DEC24-60000-C\",\"quantity\":1,\"delta\":null}"
+        "],\"positions_dropped\":3,\"orders\":["
+        "{\"id\":\"42\",\"symbol\":\"BTC-PERPETUAL\",\"side\":\"SELL\","
+        "\"price\":42000.5,\"volume\":30,\"filled\":10}"
+        "],\"books\":["
+        "{\"symbol\":\"BTC-PERPETUAL\",\"bid_volume\":100,\"bid\":42000,"
+        "\"ask\":null,\"ask_volume\":null}"
+        "],\"total_delta\":0.125,\"pnl\":{\"realized\":0.5,"
+        "\"unrealized\":-0.25,\"fees\":0.001},\"latency\":{"
+        "\"evaluations\":4,\"last_ns\":100,\"max_ns\":300,\"mean_ns\":200}}\n");
+}
+
+}  // namespace
+
+int main() {
+  test_empty();
+  test_entries();
+  return tests::report();
+}